@@ -108,6 +108,13 @@ namespace hexgrid_errors
         }
     };
 
+    class FunctionIsNotDefined : public HexgriderException{
+        public:
+        FunctionIsNotDefined(std::string func_name){
+            msg = " Call to undefined function: " + func_name + "\n";
+        }
+    };
+
     class AssingingWrongVariableType : public HexgriderException{
         public:
         AssingingWrongVariableType(std::string expected_type, std::string given_type){
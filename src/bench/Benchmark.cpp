@@ -0,0 +1,103 @@
+#include "Benchmark.h"
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+using namespace bench;
+using namespace std;
+
+void Stopwatch::resume(){
+    if(running) return;
+    started = Clock::now();
+    running = true;
+}
+
+void Stopwatch::pause(){
+    if(!running) return;
+    elapsed += Clock::now() - started;
+    running = false;
+}
+
+Stopwatch::Clock::duration Stopwatch::getElapsed() const {
+    return elapsed;
+}
+
+Runner::Runner(Config config_) : config(move(config_)) {}
+
+void Runner::run(const string& name, function<uint64_t(Stopwatch&)> body){
+    if(!config.filter.empty() && name.find(config.filter) == string::npos) return;
+    auto watch = Stopwatch();
+    uint64_t iterations = 0;
+    uint64_t items = 0;
+    auto minTime = chrono::duration<double>(config.minSeconds);
+    do {
+        watch.resume();
+        items += body(watch);
+        watch.pause();
+        iterations++;
+    } while(watch.getElapsed() < minTime);
+    double seconds = chrono::duration<double>(watch.getElapsed()).count();
+    results.push_back(Result{name, iterations, items,
+                             seconds * 1e9 / iterations, items / seconds});
+    cerr << left << setw(40) << name << right
+         << setw(16) << fixed << setprecision(1) << results.back().nsPerIteration << " ns/iter"
+         << setw(16) << setprecision(0) << results.back().itemsPerSecond << " items/s\n";
+}
+
+const Config& Runner::getConfig() const {
+    return config;
+}
+
+const vector<Result>& Runner::getResults() const {
+    return results;
+}
+
+void Runner::writeJson(ostream& out) const {
+    out << "{\n  \"benchmarks\": [";
+    out << fixed << setprecision(3);
+    for(size_t i = 0; i < results.size(); i++){
+        auto const& r = results[i];
+        out << (i ? ",\n" : "\n")
+            << "    {\"name\": \"" << r.name << "\", "
+            << "\"iterations\": " << r.iterations << ", "
+            << "\"items\": " << r.items << ", "
+            << "\"ns_per_iteration\": " << r.nsPerIteration << ", "
+            << "\"items_per_second\": " << r.itemsPerSecond << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+namespace{
+    const void* volatile sink;
+}
+
+void bench::keep(const void* value){
+    sink = value;
+}
+
+vector<tuple<int, int, int>> bench::hexSpiral(int n){
+    auto walker = generator::SpiralWalker();
+    auto positions = vector<tuple<int, int, int>>();
+    positions.reserve(n);
+    for(int i = 0; i < n; i++) positions.push_back(walker.next());
+    return positions;
+}
+
+string bench::generatedScript(const generator::Options& options){
+    ostringstream script;
+    generator::ScriptGenerator(options).write(script);
+    return script.str();
+}
+
+string bench::corpus(size_t kilobytes){
+    auto options = generator::Options();
+    options.targetBytes = kilobytes * 1024;
+    options.queries = 30;
+    options.recursionDepth = 100;
+    return generatedScript(options);
+}
+
+vector<int> bench::gridSizes(int maxCells){
+    auto sizes = vector<int>();
+    for(long long n = 1000; n <= maxCells; n *= 10) sizes.push_back(int(n));
+    return sizes;
+}
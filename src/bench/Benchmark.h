@@ -0,0 +1,88 @@
+#ifndef TKOM_BENCHMARK_H
+#define TKOM_BENCHMARK_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <generator/ScriptGenerator.h>
+
+namespace bench
+{
+
+struct Config
+{
+    int maxCells = 1000000;
+    double minSeconds = 0.2;
+    std::string filter;
+};
+
+struct Result
+{
+    std::string name;
+    std::uint64_t iterations;
+    std::uint64_t items;
+    double nsPerIteration;
+    double itemsPerSecond;
+};
+
+// Measures the time spent inside a benchmark body. The runner starts it
+// before every iteration; bodies pause it around their own setup.
+class Stopwatch
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    void resume();
+    void pause();
+    Clock::duration getElapsed() const;
+private:
+    Clock::time_point started;
+    Clock::duration elapsed = Clock::duration::zero();
+    bool running = false;
+};
+
+class Runner
+{
+public:
+    Runner(Config);
+
+    // Calls body until it has been timed for at least Config::minSeconds.
+    // body returns how many items (tokens, cells, lookups...) it processed.
+    void run(const std::string& name, std::function<std::uint64_t(Stopwatch&)> body);
+
+    const Config& getConfig() const;
+    const std::vector<Result>& getResults() const;
+    void writeJson(std::ostream&) const;
+
+private:
+    Config config;
+    std::vector<Result> results;
+};
+
+// Keeps the optimizer from dropping a computed value.
+void keep(const void*);
+
+// The first n positions of the generator's spiral around [0, 0, 0].
+std::vector<std::tuple<int, int, int>> hexSpiral(int n);
+
+// A script from generator::ScriptGenerator.
+std::string generatedScript(const generator::Options&);
+
+// A seeded corpus of about the given size: grid literal, query loops and
+// recursion, used by the lexer and parser benchmarks.
+std::string corpus(size_t kilobytes);
+
+// Sizes 10^3, 10^4, ... up to maxCells.
+std::vector<int> gridSizes(int maxCells);
+
+void registerLexerBenchmarks(Runner&);
+void registerParserBenchmarks(Runner&);
+void registerHexgridBenchmarks(Runner&);
+void registerInterpreterBenchmarks(Runner&);
+
+} // namespace bench
+
+#endif // TKOM_BENCHMARK_H
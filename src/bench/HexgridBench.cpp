@@ -0,0 +1,221 @@
+#include "Benchmark.h"
+#include <algorithm>
+#include <random>
+#include <cstdio>
+#include <interpreter/CompressedGrid.h>
+#include <interpreter/GridFile.h>
+#include <interpreter/PagedGrid.h>
+#include <interpreter/Interpreter.h>
+#include <interpreter/Parallel.h>
+using namespace bench;
+using namespace intprt;
+using namespace std;
+
+namespace{
+    const int queriesPerIteration = 10000;
+
+    Var position(const tuple<int, int, int>& pos){
+        auto arr = Array();
+        arr.add(get<0>(pos));
+        arr.add(get<1>(pos));
+        arr.add(get<2>(pos));
+        return arr;
+    }
+
+    Hexgrid buildGrid(const vector<tuple<int, int, int>>& cells){
+        static const char* colours[] = {"blue", "red", "yellow"};
+        auto grid = Hexgrid();
+        for(size_t i = 0; i < cells.size(); i++)
+            grid.add(position(cells[i]), string(colours[i % 3]));
+        return grid;
+    }
+
+    vector<tuple<int, int, int>> sample(const vector<tuple<int, int, int>>& cells, int n){
+        auto rng = mt19937(42);
+        auto picked = vector<tuple<int, int, int>>();
+        for(int i = 0; i < n; i++) picked.push_back(cells[rng() % cells.size()]);
+        return picked;
+    }
+}
+
+void bench::registerHexgridBenchmarks(Runner& runner){
+    for(int n : gridSizes(runner.getConfig().maxCells)){
+        auto cells = hexSpiral(n);
+        auto size = to_string(n);
+        auto probes = sample(cells, queriesPerIteration);
+        auto grid = buildGrid(cells);
+
+        runner.run("hexgrid/add/" + size, [&](Stopwatch&){
+            auto built = buildGrid(cells);
+            keep(&built);
+            return uint64_t(n);
+        });
+        runner.run("hexgrid/on/" + size, [&](Stopwatch&){
+            for(auto const& probe : probes){
+                auto value = grid.on(probe);
+                keep(&value);
+            }
+            return uint64_t(probes.size());
+        });
+        runner.run("hexgrid/beside/" + size, [&](Stopwatch&){
+            for(auto const& [q, r, s] : probes){
+                auto neighbours = grid.beside(q, r, s);
+                keep(&neighbours);
+            }
+            return uint64_t(probes.size());
+        });
+        for(int radius : {2, 10}){
+            runner.run("hexgrid/within/" + to_string(radius) + "/" + size, [&](Stopwatch&){
+                uint64_t found = 0;
+                for(size_t i = 0; i < probes.size(); i += 10)
+                    grid.within(probes[i], radius, [&](const Position&){ found++; });
+                keep(&found);
+                return uint64_t(probes.size() / 10);
+            });
+        }
+        // Corner to corner across the largest complete hexagon.
+        int k = 0;
+        while(hexCount(k + 1) <= uint64_t(n)) k++;
+        auto from = Position(-k, 0, k), to = Position(k, 0, -k);
+        runner.run("hexgrid/path/open/" + size, [&](Stopwatch&){
+            auto found = grid.path(from, to);
+            keep(&found);
+            return uint64_t(1);
+        });
+        auto weighted = Hexgrid();
+        auto rng = mt19937(7);
+        for(auto const& cell : cells) weighted.add(position(cell), int(1 + rng() % 4));
+        runner.run("hexgrid/path/weighted/" + size, [&](Stopwatch&){
+            auto found = weighted.path(from, to);
+            keep(&found);
+            return uint64_t(1);
+        });
+        runner.run("hexgrid/flood/" + size, [&](Stopwatch&){
+            auto region = weighted.flood(from, 1);
+            keep(&region);
+            return uint64_t(region.size());
+        });
+        runner.run("hexgrid/components/" + size, [&](Stopwatch&){
+            auto labels = weighted.components();
+            keep(&labels);
+            return uint64_t(n);
+        });
+        runner.run("hexgrid/distances/center/" + size, [&](Stopwatch&){
+            auto field = grid.distances({Position(0, 0, 0)});
+            keep(&field);
+            return uint64_t(n);
+        });
+        // One source in a hundred cells, so frontiers are wide.
+        auto sources = vector<Position>(cells.begin(), cells.end());
+        shuffle(sources.begin(), sources.end(), mt19937(3));
+        sources.resize(max<size_t>(1, cells.size() / 100));
+        auto threadCounts = vector<unsigned>{1};
+        if(hardwareThreads() > 1) threadCounts.push_back(hardwareThreads());
+        for(unsigned threads : threadCounts){
+            runner.run("hexgrid/distances/sources/" + to_string(threads) + "/" + size, [&](Stopwatch&){
+                auto field = grid.distances(sources, true, threads);
+                keep(&field);
+                return uint64_t(n);
+            });
+        }
+        runner.run("hexgrid/neighbour_sum/" + size, [&](Stopwatch&){
+            auto sums = weighted.neighbourhood(Reduction::Sum);
+            keep(&sums);
+            return uint64_t(n);
+        });
+        auto board = Hexgrid();
+        for(auto const& cell : cells) board.add(position(cell), int(rng() % 2));
+        runner.run("hexgrid/step/" + size, [&](Stopwatch&){
+            auto next = board.step(1, [](const Var& value, int living) -> Var {
+                return get<int>(value) ? int(living == 2) : int(living == 2 || living == 3);
+            }, hardwareThreads());
+            keep(&next);
+            return uint64_t(n);
+        });
+        // Every seventh cell is an obstacle, sight lines are 5 to 30 cells long.
+        auto obstacles = Hexgrid();
+        for(size_t i = 0; i < cells.size(); i += 7) obstacles.add(position(cells[i]), string("rock"));
+        auto sightings = vector<pair<Position, Position>>();
+        for(size_t i = 0; i < probes.size(); i++){
+            auto const& [q, r, s] = probes[i];
+            int reach = 5 + int(i % 26);
+            sightings.push_back({probes[i], Position(q + reach, r - reach / 2, s - reach + reach / 2)});
+        }
+        runner.run("hexgrid/visible/" + size, [&](Stopwatch&){
+            uint64_t seen = 0;
+            for(auto const& [from, to] : sightings) seen += obstacles.visible(from, to);
+            keep(&seen);
+            return uint64_t(sightings.size());
+        });
+        runner.run("hexgrid/fov/" + size, [&](Stopwatch&){
+            uint64_t seen = 0;
+            for(size_t i = 0; i < probes.size(); i += 10)
+                obstacles.fieldOfView(probes[i], 10, [&](const Position&){ seen++; });
+            keep(&seen);
+            return uint64_t(probes.size() / 10);
+        });
+        runner.run("hexgrid/by/" + size, [&](Stopwatch&){
+            auto found = grid.by(string("blue"));
+            keep(&found);
+            return uint64_t(n);
+        });
+        if(hardwareThreads() > 1){
+            auto pool = ThreadPool(hardwareThreads());
+            auto scope = PoolScope(pool);
+            runner.run("hexgrid/by/" + to_string(hardwareThreads()) + "/" + size, [&](Stopwatch&){
+                auto found = grid.by(string("blue"), hardwareThreads());
+                keep(&found);
+                return uint64_t(n);
+            });
+        }
+        auto file = "hexgrid_bench_" + size + ".hex";
+        runner.run("hexgrid/save/" + size, [&](Stopwatch&){
+            saveHexgrid(grid, file);
+            return uint64_t(n);
+        });
+        saveHexgrid(grid, file);
+        runner.run("hexgrid/load/" + size, [&](Stopwatch&){
+            auto loaded = loadHexgrid(file);
+            keep(&loaded);
+            return uint64_t(n);
+        });
+        {
+            // Probes at random, through the default cache, and a scan.
+            auto paged = PagedGrid(file, PagedGrid::defaultCachePages);
+            runner.run("hexgrid/paged_on/" + size, [&](Stopwatch&){
+                for(auto const& probe : probes){
+                    auto value = paged.on(probe);
+                    keep(&value);
+                }
+                return uint64_t(probes.size());
+            });
+            runner.run("hexgrid/paged_foreach/" + size, [&](Stopwatch&){
+                int64_t seen = 0;
+                paged.forEach([&](const Position&, const Var&){ seen++; });
+                keep(&seen);
+                return uint64_t(n);
+            });
+        }
+        runner.run("hexgrid/save_compressed/" + size, [&](Stopwatch&){
+            saveCompressedHexgrid(grid, file);
+            return uint64_t(n);
+        });
+        saveCompressedHexgrid(grid, file);
+        runner.run("hexgrid/load_compressed/" + size, [&](Stopwatch&){
+            auto loaded = loadHexgrid(file);
+            keep(&loaded);
+            return uint64_t(n);
+        });
+        std::remove(file.c_str());
+        auto removed = vector<Var>();
+        for(auto const& probe : sample(cells, min(n, queriesPerIteration)))
+            removed.push_back(position(probe));
+        runner.run("hexgrid/remove/" + size, [&](Stopwatch& watch){
+            watch.pause();
+            auto copy = grid;
+            watch.resume();
+            for(auto const& pos : removed) copy.remove(pos);
+            return uint64_t(removed.size());
+        });
+    }
+}
@@ -0,0 +1,61 @@
+#include "Benchmark.h"
+#include <sstream>
+#include <lexer/Lexer.h>
+#include <parser/Parser.h>
+#include <interpreter/Interpreter.h>
+using namespace bench;
+using namespace lexer;
+using namespace parser;
+using namespace intprt;
+using namespace std;
+
+namespace{
+    string grid(int cells){
+        auto options = generator::Options();
+        options.cells = cells;
+        return generatedScript(options);
+    }
+
+    // examples/example1 over a whole grid: count blue neighbours of every cell.
+    string neighbourCountScript(int cells){
+        return grid(cells) +
+               "int blue_count = 0;\n"
+               "foreach array cell in grid\n"
+               "{\n"
+               "    foreach array pos in grid beside cell\n"
+               "    {\n"
+               "        if (grid on pos == \"blue\") { blue_count = blue_count + 1; }\n"
+               "    }\n"
+               "}\n";
+    }
+
+    // examples/example2: remove the blue cells with positive q.
+    string removeByValueScript(int cells){
+        return grid(cells) +
+               "foreach array pos in grid by \"blue\"\n"
+               "{\n"
+               "    if (pos[0] > 0) {remove pos from grid;}\n"
+               "}\n";
+    }
+
+    void runScript(Runner& runner, const string& name, const string& script, int cells){
+        istringstream in(script);
+        auto tokens = Lexer(in).readAll();
+        auto program = Parser(move(tokens)).parse();
+        // The scripts define no functions, which visit(Program&) would take
+        // out of the tree, so one parse serves every iteration.
+        runner.run(name, [&](Stopwatch&){
+            auto interpreter = Interpreter();
+            program->accept(interpreter);
+            return uint64_t(cells);
+        });
+    }
+}
+
+void bench::registerInterpreterBenchmarks(Runner& runner){
+    for(int cells : {100, 1000}){
+        auto size = to_string(cells);
+        runScript(runner, "interpreter/example1/" + size, neighbourCountScript(cells), cells);
+        runScript(runner, "interpreter/example2/" + size, removeByValueScript(cells), cells);
+    }
+}
@@ -0,0 +1,20 @@
+#include "Benchmark.h"
+#include <sstream>
+#include <lexer/Lexer.h>
+using namespace bench;
+using namespace lexer;
+using namespace token;
+using namespace std;
+
+void bench::registerLexerBenchmarks(Runner& runner){
+    for(size_t kilobytes : {64, 1024}){
+        auto script = corpus(kilobytes);
+        runner.run("lexer/getToken/" + to_string(kilobytes) + "KB", [&](Stopwatch&){
+            istringstream in(script);
+            Lexer lexer(in);
+            uint64_t tokens = 0;
+            while(lexer.getToken().getType() != Token::Type::EndOfFile) tokens++;
+            return tokens;
+        });
+    }
+}
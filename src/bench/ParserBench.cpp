@@ -0,0 +1,23 @@
+#include "Benchmark.h"
+#include <sstream>
+#include <lexer/Lexer.h>
+#include <parser/Parser.h>
+using namespace bench;
+using namespace lexer;
+using namespace parser;
+using namespace std;
+
+void bench::registerParserBenchmarks(Runner& runner){
+    for(size_t kilobytes : {64, 1024}){
+        istringstream in(corpus(kilobytes));
+        auto tokens = Lexer(in).readAll();
+        runner.run("parser/parse/" + to_string(kilobytes) + "KB", [&](Stopwatch& watch){
+            watch.pause();
+            auto copy = tokens;
+            watch.resume();
+            auto program = Parser(move(copy)).parse();
+            keep(program.get());
+            return uint64_t(tokens.size());
+        });
+    }
+}
@@ -0,0 +1,49 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "Benchmark.h"
+
+using namespace bench;
+
+void printUsage()
+{
+  std::cerr << "usage: hexgrider_bench [--json <file>] [--max-cells <n>]\n"
+               "                       [--min-time <seconds>] [--filter <text>]\n";
+}
+
+bool parseArguments(int argc, char* argv[], Config& config, std::string& jsonPath)
+{
+  for(int i = 1; i + 1 < argc; i += 2){
+    std::string arg = argv[i];
+    std::string value = argv[i + 1];
+    if(arg == "--json") jsonPath = value;
+    else if(arg == "--max-cells") config.maxCells = std::atoi(value.c_str());
+    else if(arg == "--min-time") config.minSeconds = std::atof(value.c_str());
+    else if(arg == "--filter") config.filter = value;
+    else return false;
+  }
+  return argc % 2 == 1;
+}
+
+int main(int argc, char* argv[])
+{
+  auto config = Config();
+  std::string jsonPath;
+  if(!parseArguments(argc, argv, config, jsonPath)){
+    printUsage();
+    return 2;
+  }
+  auto runner = Runner(config);
+  registerLexerBenchmarks(runner);
+  registerParserBenchmarks(runner);
+  registerHexgridBenchmarks(runner);
+  registerInterpreterBenchmarks(runner);
+  if(jsonPath.empty()){
+    runner.writeJson(std::cout);
+  } else {
+    std::ofstream out(jsonPath);
+    runner.writeJson(out);
+  }
+  return 0;
+}
@@ -0,0 +1,228 @@
+#include "ScriptGenerator.h"
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+using namespace generator;
+using namespace std;
+
+namespace{
+    const int directions[6][3] = {
+        {1, -1, 0}, {1, 0, -1}, {0, 1, -1},
+        {-1, 1, 0}, {-1, 0, 1}, {0, -1, 1}};
+
+    vector<string> split(const string& text, char separator){
+        auto parts = vector<string>();
+        stringstream in(text);
+        string part;
+        while(getline(in, part, separator)) parts.push_back(part);
+        return parts;
+    }
+
+    // Counts what goes through it, so the size of the script is known
+    // without buffering it.
+    class CountingStream
+    {
+    public:
+        CountingStream(ostream& out_) : out(out_) {}
+        CountingStream& operator<<(const string& text){
+            out << text;
+            count += text.size();
+            return *this;
+        }
+        long long count = 0;
+    private:
+        ostream& out;
+    };
+}
+
+Random::Random(uint64_t seed) : state(seed) {}
+
+uint64_t Random::next(){
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+uint64_t Random::below(uint64_t bound){
+    return bound ? next() % bound : 0;
+}
+
+double Random::uniform(){
+    return (next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+ValueDistribution ValueDistribution::parse(const string& spec){
+    auto distribution = ValueDistribution();
+    auto colon = spec.find(':');
+    auto kind = spec.substr(0, colon);
+    auto args = colon == string::npos ? string() : spec.substr(colon + 1);
+    if(kind == "palette" || kind == "zipf"){
+        distribution.kind = kind == "palette" ? Kind::Palette : Kind::Zipf;
+        if(!args.empty()) distribution.palette = split(args, ',');
+        if(distribution.palette.empty()) throw invalid_argument("empty palette in " + spec);
+        double total = 0;
+        for(size_t i = 0; i < distribution.palette.size(); i++){
+            total += distribution.kind == Kind::Zipf ? 1.0 / (i + 1) : 1.0;
+            distribution.cumulativeWeights.push_back(total);
+        }
+        for(auto& weight : distribution.cumulativeWeights) weight /= total;
+    } else if(kind == "int" || kind == "float"){
+        distribution.kind = kind == "int" ? Kind::Int : Kind::Float;
+        auto bounds = split(args, ':');
+        if(bounds.size() != 2) throw invalid_argument("expected " + kind + ":low:high, got " + spec);
+        distribution.low = stod(bounds[0]);
+        distribution.high = stod(bounds[1]);
+        if(distribution.high < distribution.low) throw invalid_argument("empty range in " + spec);
+    } else {
+        throw invalid_argument("unknown value distribution " + spec);
+    }
+    return distribution;
+}
+
+string ValueDistribution::next(Random& random) const {
+    switch(kind){
+        case Kind::Palette:
+        case Kind::Zipf: {
+            double u = random.uniform();
+            size_t i = 0;
+            while(i + 1 < palette.size() && cumulativeWeights[i] <= u) i++;
+            return "\"" + palette[i] + "\"";
+        }
+        case Kind::Int: {
+            auto value = (long long)low + (long long)random.below(uint64_t(high - low) + 1);
+            // The lexer has no negative literals, negation is an operator.
+            return value < 0 ? "(-" + to_string(-value) + ")" : to_string(value);
+        }
+        case Kind::Float: {
+            ostringstream text;
+            double value = low + random.uniform() * (high - low);
+            text.precision(6);
+            text << fixed << (value < 0 ? -value : value);
+            return value < 0 ? "(-" + text.str() + ")" : text.str();
+        }
+    }
+    return "";
+}
+
+ValueDistribution::Kind ValueDistribution::getKind() const {
+    return kind;
+}
+
+tuple<int, int, int> SpiralWalker::next(){
+    auto position = current;
+    if(radius == 0 || (side == 5 && step == radius - 1)){
+        radius++;
+        side = 0;
+        step = 0;
+        current = {-radius, 0, radius};
+        return position;
+    }
+    get<0>(current) += directions[side][0];
+    get<1>(current) += directions[side][1];
+    get<2>(current) += directions[side][2];
+    if(++step == radius){
+        step = 0;
+        side++;
+    }
+    return position;
+}
+
+tuple<int, int, int> SpiralWalker::at(long long n){
+    if(n == 0) return {0, 0, 0};
+    // Ring k holds cells 1 + 3k(k-1) ... 3k(k+1).
+    long long k = (long long)((sqrt(12.0 * n - 3) - 3) / 6);
+    while(1 + 3 * k * (k + 1) <= n) k++;
+    while(k > 1 && 1 + 3 * (k - 1) * k > n) k--;
+    long long offset = n - (1 + 3 * k * (k - 1));
+    long long side = offset / k;
+    long long step = offset % k;
+    long long q = -k, r = 0, s = k;
+    for(long long i = 0; i < side; i++){
+        q += directions[i][0] * k;
+        r += directions[i][1] * k;
+        s += directions[i][2] * k;
+    }
+    return {int(q + directions[side][0] * step),
+            int(r + directions[side][1] * step),
+            int(s + directions[side][2] * step)};
+}
+
+ScriptGenerator::ScriptGenerator(Options options_)
+: options(move(options_)), values(ValueDistribution::parse(options.values)),
+  random(options.seed) {}
+
+void ScriptGenerator::write(ostream& out){
+    writeGrid(out);
+    writeQueries(out);
+    writeRecursion(out);
+}
+
+string ScriptGenerator::positionLiteral(const tuple<int, int, int>& pos) const {
+    return "[" + to_string(get<0>(pos)) + ", " + to_string(get<1>(pos)) + ", " +
+           to_string(get<2>(pos)) + "]";
+}
+
+tuple<int, int, int> ScriptGenerator::randomCell(){
+    return SpiralWalker::at(random.below(writtenCells));
+}
+
+void ScriptGenerator::writeGrid(ostream& out){
+    CountingStream counted(out);
+    auto walker = SpiralWalker();
+    counted << "hexgrid grid = <";
+    writtenCells = 0;
+    // Roughly what the query loops and the recursion add after the grid.
+    long long tail = 400LL * options.queries + 300;
+    while(options.targetBytes > 0 ? counted.count + tail < options.targetBytes
+                                  : writtenCells < options.cells){
+        counted << (writtenCells ? ",\n    " : "") + values.next(random) +
+                   " at " + positionLiteral(walker.next());
+        writtenCells++;
+    }
+    counted << ">;\n";
+}
+
+void ScriptGenerator::writeQueries(ostream& out){
+    if(options.queries <= 0 || writtenCells == 0) return;
+    bool numeric = values.getKind() == ValueDistribution::Kind::Int ||
+                   values.getKind() == ValueDistribution::Kind::Float;
+    auto accumulator = numeric && values.getKind() == ValueDistribution::Kind::Float
+                     ? string("float total = 0.0;\n") : string("int total = 0;\n");
+    out << "int matches = 0;\n" << accumulator;
+    for(int i = 0; i < options.queries; i++){
+        auto value = values.next(random);
+        switch(i % 3){
+            case 0:
+                out << "foreach array pos in grid beside " << positionLiteral(randomCell()) << "\n"
+                    << "{\n"
+                    << "    if (grid on pos == " << value << ") { matches = matches + 1; }\n"
+                    << "}\n";
+                break;
+            case 1:
+                out << "foreach array pos in grid by " << value << "\n"
+                    << "{\n"
+                    << "    foreach array next in grid beside pos { matches = matches + 1; }\n"
+                    << "}\n";
+                break;
+            case 2:
+                out << "foreach array pos in grid\n"
+                    << "{\n";
+                if(numeric) out << "    total = total + (grid on pos);\n";
+                else        out << "    if (grid on pos != " << value << ") { total = total + 1; }\n";
+                out << "}\n";
+                break;
+        }
+    }
+}
+
+void ScriptGenerator::writeRecursion(ostream& out){
+    if(options.recursionDepth <= 0) return;
+    out << "int depth_reached = 0;\n"
+        << "func int descend(int n)\n"
+        << "{\n"
+        << "    depth_reached = depth_reached + 1;\n"
+        << "    if (n > 0) { descend(n - 1); }\n"
+        << "}\n"
+        << "descend(" << options.recursionDepth << ");\n";
+}
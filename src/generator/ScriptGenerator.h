@@ -0,0 +1,101 @@
+#ifndef TKOM_SCRIPT_GENERATOR_H
+#define TKOM_SCRIPT_GENERATOR_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace generator
+{
+
+// splitmix64. Used instead of the <random> distributions, whose output
+// differs between standard libraries, so that a seed means the same
+// corpus everywhere.
+class Random
+{
+public:
+    Random(std::uint64_t seed);
+    std::uint64_t next();
+    // Uniform in [0, bound).
+    std::uint64_t below(std::uint64_t bound);
+    // Uniform in [0, 1).
+    double uniform();
+private:
+    std::uint64_t state;
+};
+
+// Produces cell values as hexgrider literals. Specs:
+//   palette:blue,red,yellow   strings, uniformly
+//   zipf:blue,red,yellow      strings, the n-th one with weight 1/n
+//   int:0:100                 integers in [0, 100]
+//   float:0:1                 decimals in [0, 1)
+class ValueDistribution
+{
+public:
+    enum class Kind { Palette, Zipf, Int, Float };
+
+    static ValueDistribution parse(const std::string& spec);
+
+    std::string next(Random&) const;
+    Kind getKind() const;
+private:
+    Kind kind = Kind::Palette;
+    std::vector<std::string> palette = {"blue", "red", "yellow"};
+    std::vector<double> cumulativeWeights;
+    double low = 0;
+    double high = 100;
+};
+
+struct Options
+{
+    std::uint64_t seed = 1;
+    long long cells = 1000;
+    // When set, cells are added until the script reaches about this size.
+    long long targetBytes = 0;
+    std::string values = "palette:blue,red,yellow";
+    int queries = 0;
+    int recursionDepth = 0;
+};
+
+// Writes a script that declares "hexgrid grid" from a literal of cells laid
+// out on a spiral around [0, 0, 0], followed by foreach/by/beside query
+// loops and a recursive function. Output is streamed, so corpora larger
+// than memory can be generated.
+class ScriptGenerator
+{
+public:
+    ScriptGenerator(Options);
+    void write(std::ostream&);
+
+private:
+    void writeGrid(std::ostream&);
+    void writeQueries(std::ostream&);
+    void writeRecursion(std::ostream&);
+    std::string positionLiteral(const std::tuple<int, int, int>&) const;
+    std::tuple<int, int, int> randomCell();
+
+    Options options;
+    ValueDistribution values;
+    Random random;
+    long long writtenCells = 0;
+};
+
+// Walks a hexagonal spiral around [0, 0, 0], ring by ring.
+class SpiralWalker
+{
+public:
+    std::tuple<int, int, int> next();
+    // Position of the n-th cell of the spiral.
+    static std::tuple<int, int, int> at(long long n);
+private:
+    int radius = 0;
+    int side = 0;
+    int step = 0;
+    std::tuple<int, int, int> current = {0, 0, 0};
+};
+
+} // namespace generator
+
+#endif // TKOM_SCRIPT_GENERATOR_H
@@ -0,0 +1,119 @@
+#include <set>
+#include <sstream>
+#include <boost/test/unit_test.hpp>
+#include <lexer/Lexer.h>
+#include <parser/Parser.h>
+#include <interpreter/Interpreter.h>
+#include "generator/ScriptGenerator.h"
+using namespace generator;
+using namespace lexer;
+using namespace parser;
+using namespace intprt;
+using namespace std;
+
+struct GeneratorTestsFixture
+{
+    Interpreter interpreter = Interpreter();
+
+    string generate(const Options& options)
+    {
+        ostringstream out;
+        ScriptGenerator(options).write(out);
+        return out.str();
+    }
+
+    void interpret_text(const string& str)
+    {
+        istringstream in(str);
+        Parser p(make_unique<Lexer>(in));
+        p.parse()->accept(interpreter);
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(GeneratorTests, GeneratorTestsFixture)
+
+BOOST_AUTO_TEST_CASE(generator_same_seed_gives_same_script)
+{
+    auto options = Options();
+    options.queries = 6;
+    BOOST_CHECK_EQUAL(generate(options), generate(options));
+    auto other = options;
+    other.seed = 2;
+    BOOST_CHECK(generate(options) != generate(other));
+}
+
+BOOST_AUTO_TEST_CASE(generator_random_stream_is_fixed)
+{
+    auto random = Random(1);
+    BOOST_CHECK_EQUAL(random.next(), 10451216379200822465ULL);
+    BOOST_CHECK_EQUAL(random.next(), 13757245211066428519ULL);
+}
+
+BOOST_AUTO_TEST_CASE(generator_spiral_has_distinct_cube_coordinates)
+{
+    auto walker = SpiralWalker();
+    auto seen = set<tuple<int, int, int>>();
+    for(long long i = 0; i < 1000; i++){
+        auto pos = walker.next();
+        BOOST_CHECK_EQUAL(get<0>(pos) + get<1>(pos) + get<2>(pos), 0);
+        BOOST_CHECK(pos == SpiralWalker::at(i));
+        seen.insert(pos);
+    }
+    BOOST_CHECK_EQUAL(seen.size(), 1000);
+    // Cells 1..6 form the first ring, 7..18 the second.
+    BOOST_CHECK(SpiralWalker::at(6) == make_tuple(-1, 1, 0));
+    BOOST_CHECK(SpiralWalker::at(7) == make_tuple(-2, 0, 2));
+}
+
+BOOST_AUTO_TEST_CASE(generator_script_runs)
+{
+    auto options = Options();
+    options.cells = 50;
+    options.queries = 9;
+    options.recursionDepth = 20;
+    interpret_text(generate(options));
+    BOOST_CHECK_EQUAL(get<Hexgrid>(interpreter.getValue("grid")).size(), 50);
+    BOOST_CHECK_EQUAL(get<int>(interpreter.getValue("depth_reached")), 21);
+}
+
+BOOST_AUTO_TEST_CASE(generator_numeric_values_run)
+{
+    auto options = Options();
+    options.cells = 30;
+    options.queries = 3;
+    options.values = "int:-5:5";
+    interpret_text(generate(options));
+    options.values = "float:-1:1";
+    interpret_text(generate(options));
+    BOOST_CHECK_EQUAL(get<Hexgrid>(interpreter.getValue("grid")).size(), 30);
+}
+
+BOOST_AUTO_TEST_CASE(generator_zipf_prefers_first_value)
+{
+    auto distribution = ValueDistribution::parse("zipf:a,b,c,d");
+    auto random = Random(7);
+    int first = 0, last = 0;
+    for(int i = 0; i < 10000; i++){
+        auto value = distribution.next(random);
+        if(value == "\"a\"") first++;
+        if(value == "\"d\"") last++;
+    }
+    BOOST_CHECK(first > 3 * last);
+}
+
+BOOST_AUTO_TEST_CASE(generator_reaches_target_size)
+{
+    auto options = Options();
+    options.targetBytes = 64 * 1024;
+    options.queries = 10;
+    auto script = generate(options);
+    BOOST_CHECK(script.size() >= 60 * 1024);
+    BOOST_CHECK(script.size() <= 68 * 1024);
+}
+
+BOOST_AUTO_TEST_CASE(generator_rejects_unknown_distribution)
+{
+    BOOST_CHECK_THROW(ValueDistribution::parse("normal:0:1"), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,63 @@
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "generator/ScriptGenerator.h"
+
+using namespace generator;
+
+void printUsage()
+{
+  std::cerr << "usage: hexgen [options] > script\n"
+               "  --seed <n>         random seed (default 1)\n"
+               "  --cells <n>        cells in the hexgrid literal (default 1000)\n"
+               "  --bytes <n>[K|M|G] grow the hexgrid until the script has about this size\n"
+               "  --values <spec>    palette:a,b,c | zipf:a,b,c | int:low:high | float:low:high\n"
+               "  --queries <n>      foreach/by/beside query loops over the grid\n"
+               "  --recursion <n>    depth of a recursive function call\n";
+}
+
+long long parseSize(const std::string& text)
+{
+  size_t used = 0;
+  long long value = std::stoll(text, &used);
+  auto suffix = text.substr(used);
+  if(suffix == "K") return value << 10;
+  if(suffix == "M") return value << 20;
+  if(suffix == "G") return value << 30;
+  if(!suffix.empty()) throw std::invalid_argument("unknown size suffix " + suffix);
+  return value;
+}
+
+bool parseArguments(int argc, char* argv[], Options& options)
+{
+  for(int i = 1; i + 1 < argc; i += 2){
+    std::string arg = argv[i];
+    std::string value = argv[i + 1];
+    if(arg == "--seed") options.seed = std::stoull(value);
+    else if(arg == "--cells") options.cells = std::stoll(value);
+    else if(arg == "--bytes") options.targetBytes = parseSize(value);
+    else if(arg == "--values") options.values = value;
+    else if(arg == "--queries") options.queries = std::stoi(value);
+    else if(arg == "--recursion") options.recursionDepth = std::stoi(value);
+    else return false;
+  }
+  return argc % 2 == 1;
+}
+
+int main(int argc, char* argv[])
+{
+  auto options = Options();
+  try {
+    if(!parseArguments(argc, argv, options)){
+      printUsage();
+      return 2;
+    }
+    std::ios::sync_with_stdio(false);
+    ScriptGenerator(options).write(std::cout);
+  } catch(const std::exception& e) {
+    std::cerr << "hexgen: " << e.what() << '\n';
+    return 2;
+  }
+  return 0;
+}
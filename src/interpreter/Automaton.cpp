@@ -0,0 +1,85 @@
+#include "Interpreter.h"
+#include "NeighbourTable.h"
+#include "Parallel.h"
+#include <unordered_map>
+using namespace intprt;
+using namespace std;
+
+namespace{
+    struct ValueHash
+    {
+        size_t operator()(const Var& value) const {
+            switch(value.index()){
+                case 1: return hash<int>()(get<int>(value));
+                // -0.0 equals 0.0, so it must hash alike.
+                case 2: return hash<double>()(get<double>(value) == 0.0 ? 0.0 : get<double>(value));
+                case 3: return get<Symbol>(value).hash();
+                default: return 0;
+            }
+        }
+    };
+
+    struct ValueEqual
+    {
+        bool operator()(const Var& a, const Var& b) const {
+            return sameValue(a, b);
+        }
+    };
+
+    // Counts of living neighbours run from 0 to 6.
+    const size_t counts = 7;
+}
+
+// Cells holding equal values share a state, and the rule is asked once for
+// each state and count of living neighbours that occurs, so it costs the
+// same on a board of any size. Counting neighbours and picking the next
+// state are split across threads; the hexgrid holding the next generation
+// is then written in storage order, leaving this one as it was.
+Hexgrid Hexgrid::step(const Var& alive, const StepRule& rule, unsigned threads) const {
+    requireCells();
+    auto table = NeighbourTable(*this);
+    auto states = unordered_map<Var, uint32_t, ValueHash, ValueEqual>();
+    auto stateValues = vector<const Var*>();
+    auto state = vector<uint32_t>(table.size());
+    for(size_t cell = 0; cell < table.size(); cell++){
+        auto const& value = table.value(cell);
+        if(value.index() == 0 || value.index() > 3)
+            throw runtime_error("step needs cells holding numbers or text");
+        auto found = states.find(value);
+        if(found == states.end()){
+            found = states.emplace(value, uint32_t(stateValues.size())).first;
+            stateValues.push_back(&value);
+        }
+        state[cell] = found->second;
+    }
+    auto living = vector<uint8_t>(stateValues.size());
+    for(size_t i = 0; i < stateValues.size(); i++) living[i] = sameValue(*stateValues[i], alive);
+
+    auto next = vector<uint32_t>(table.size());
+    parallelChunks(table.size(), threads, [&](unsigned, size_t begin, size_t end){
+        for(size_t cell = begin; cell < end; cell++){
+            uint32_t count = 0;
+            for(auto neighbour : table.neighbours(cell))
+                count += neighbour != NeighbourTable::none && living[state[neighbour]];
+            next[cell] = state[cell] * counts + count;
+        }
+    });
+
+    auto outcomes = vector<Var>(stateValues.size() * counts);
+    auto asked = vector<bool>(outcomes.size());
+    for(auto key : next){
+        if(asked[key]) continue;
+        asked[key] = true;
+        outcomes[key] = rule(*stateValues[key / counts], int(key % counts));
+        internText(outcomes[key]);
+    }
+    auto generation = Hexgrid();
+    auto& stored = generation.data.edit();
+    for(size_t cell = 0; cell < table.size(); cell++){
+        auto const& value = outcomes[next[cell]];
+        auto cost = stepCost(value);
+        if(cost >= 0 && cost < stored.minStepCost) stored.minStepCost = cost;
+        stored.cells.emplace_hint(stored.cells.end(), table.position(cell), value);
+    }
+    return generation;
+}
@@ -0,0 +1,142 @@
+#include "Batch.h"
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <lexer/Lexer.h>
+#include <parser/Parser.h>
+#include "CompressedGrid.h"
+#include "GridFile.h"
+using namespace intprt;
+using namespace std;
+
+BatchRunner::BatchRunner(ast::Program& program_, string inputName_, unsigned threads)
+: program(program_), inputName(move(inputName_)), pool(make_shared<ThreadPool>(threads)) {}
+
+void BatchRunner::setOutputFormat(OutputFormat format){
+    outputFormat = format;
+}
+
+ThreadPool::Stats BatchRunner::getPoolStats() const {
+    return pool->getStats();
+}
+
+string BatchRunner::runOne(const string& path){
+    auto grid = readInputHexgrid(path);
+    auto output = ostringstream();
+    auto interpreter = Interpreter();
+    interpreter.setPool(pool);
+    interpreter.setOutputFormat(outputFormat);
+    interpreter.setOutput(output);
+    interpreter.declare(5, inputName);
+    interpreter.assign(inputName, move(grid));
+    program.accept(interpreter);
+    return output.str();
+}
+
+// One task per pool thread, each taking the next input until none are
+// left. Inputs are thus started in order, and outputs wait for those
+// before them for about as long as one run takes.
+size_t BatchRunner::run(const vector<string>& paths, ostream& out, ostream& errors){
+    auto next = atomic<size_t>(0);
+    auto outputs = vector<string>(paths.size());
+    auto done = vector<bool>(paths.size());
+    size_t written = 0, failed = 0;
+    auto lock = mutex();
+    pool->run(pool->size(), [&](size_t, unsigned){
+        for(size_t input = next++; input < paths.size(); input = next++){
+            auto output = string();
+            auto error = string();
+            try {
+                output = runOne(paths[input]);
+            } catch(const exception& e) {
+                error = e.what();
+            }
+            auto guard = lock_guard<mutex>(lock);
+            if(!error.empty()){
+                errors << paths[input] << ": " << error << "\n";
+                failed++;
+            }
+            outputs[input] = move(output);
+            done[input] = true;
+            for(; written < paths.size() && done[written]; written++){
+                out << outputs[written];
+                outputs[written] = string();
+            }
+        }
+    });
+    out.flush();
+    return failed;
+}
+
+namespace{
+    // Numbers, text, negated numbers and arrays of those; anything else
+    // would run as code.
+    bool isConstant(ast::Node& node){
+        using namespace ast;
+        if(dynamic_cast<IntegerLiteral*>(&node) || dynamic_cast<DecimalLiteral*>(&node) ||
+           dynamic_cast<TextLiteral*>(&node)) return true;
+        if(auto negated = dynamic_cast<ArithmeticalNegation*>(&node)) return isConstant(*negated->value);
+        if(auto array = dynamic_cast<ArrayLiteral*>(&node)){
+            for(auto const& element : array->elements)
+                if(!isConstant(*element)) return false;
+            return true;
+        }
+        return false;
+    }
+
+    bool isHexgridLiteral(ast::Node& node){
+        auto literal = dynamic_cast<ast::HexgridLiteral*>(&node);
+        if(!literal) return false;
+        for(auto const& cell : literal->cells){
+            auto hexCell = dynamic_cast<ast::HexgridCell*>(cell.get());
+            if(!hexCell || !isConstant(*hexCell->value) || !isConstant(*hexCell->pos)) return false;
+        }
+        return true;
+    }
+}
+
+Hexgrid intprt::readHexgrid(istream& in){
+    auto script = string("hexgrid grid = ");
+    script.append(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    script += ";";
+    auto source = istringstream(script);
+    auto program = parser::Parser(make_unique<lexer::Lexer>(source)).parse();
+    // Anything but the literal would run as a script.
+    auto initialization = program->stmnts.size() == 1 && program->funcs.empty()
+                        ? dynamic_cast<ast::InitializationStatement*>(program->stmnts[0].get()) : nullptr;
+    if(!initialization || !isHexgridLiteral(*initialization->value))
+        throw runtime_error("not a hexgrid");
+    auto interpreter = Interpreter();
+    interpreter.setThreads(1);
+    program->accept(interpreter);
+    auto grid = interpreter.getValue("grid");
+    if(grid.index() != 5) throw runtime_error("not a hexgrid");
+    return get<Hexgrid>(move(grid));
+}
+
+Hexgrid intprt::readInputHexgrid(const string& path){
+    auto file = ifstream(path, ios::binary);
+    if(!file) throw runtime_error("can't open the file");
+    char magic[sizeof gridfile::magic] = {};
+    file.read(magic, sizeof magic);
+    if(file && (!memcmp(magic, gridfile::magic, sizeof magic)
+                || !memcmp(magic, gridfile::compressedMagic, sizeof magic)))
+        return loadHexgrid(path);
+    file.clear();
+    file.seekg(0);
+    return readHexgrid(file);
+}
+
+vector<string> intprt::readPathList(istream& in){
+    auto paths = vector<string>();
+    for(string line; getline(in, line);){
+        auto begin = line.find_first_not_of(" \t\r");
+        if(begin == string::npos) continue;
+        auto end = line.find_last_not_of(" \t\r");
+        paths.push_back(line.substr(begin, end - begin + 1));
+    }
+    return paths;
+}
@@ -0,0 +1,54 @@
+#ifndef TKOM_BATCH_H
+#define TKOM_BATCH_H
+
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <parser/Ast.h>
+#include "Interpreter.h"
+#include "ThreadPool.h"
+#include "ValueFormat.h"
+
+namespace intprt
+{
+
+// Runs one parsed program once per input file, each time on an interpreter
+// of its own with the hexgrid read from the file bound to a variable. The
+// threads of one pool take the inputs in order and share it for the
+// programs' parallel work too; what the runs return is written in input
+// order, each as soon as those before it are done.
+class BatchRunner
+{
+public:
+    BatchRunner(ast::Program&, std::string inputName, unsigned threads);
+
+    void setOutputFormat(OutputFormat);
+    // Returns how many inputs failed; their errors, after their paths, go
+    // to errors and their output is left out.
+    std::size_t run(const std::vector<std::string>& paths, std::ostream& out, std::ostream& errors);
+    ThreadPool::Stats getPoolStats() const;
+
+private:
+    std::string runOne(const std::string& path);
+
+    ast::Program& program;
+    std::string inputName;
+    OutputFormat outputFormat = OutputFormat::Text;
+    std::shared_ptr<ThreadPool> pool;
+};
+
+// A hexgrid literal as written in scripts: <value at [q, r, s], ...>,
+// its values and positions written out; throws on anything else.
+Hexgrid readHexgrid(std::istream&);
+// The hexgrid of a batch input: a file written by save, compressed or
+// not, or else a hexgrid literal.
+Hexgrid readInputHexgrid(const std::string& path);
+// Non-empty lines, surrounding blanks removed.
+std::vector<std::string> readPathList(std::istream&);
+
+} // namespace intprt
+
+#endif // TKOM_BATCH_H
@@ -0,0 +1,201 @@
+#include "Builtins.h"
+#include <bitset>
+#include <climits>
+#include "HexLine.h"
+#include "PagedGrid.h"
+#include "Parallel.h"
+using namespace intprt;
+using namespace std;
+
+namespace{
+    void checkArgCount(const string& name, const vector<Var>& args, size_t least, size_t most){
+        if(args.size() < least || args.size() > most)
+            throw runtime_error("Wrong arg count for " + name);
+    }
+
+    const Hexgrid& hexgridArg(const string& name, const vector<Var>& args, size_t i){
+        if(args[i].index() != 5)
+            throw runtime_error("Argument " + to_string(i + 1) + " of " + name + " must be a hexgrid");
+        return get<Hexgrid>(args[i]);
+    }
+
+    Position positionArg(const string& name, const vector<Var>& args, size_t i){
+        auto const& value = args[i];
+        if(value.index() != 4 || get<Array>(value).size() != 3)
+            throw runtime_error("Argument " + to_string(i + 1) + " of " + name + " must be a position");
+        return Hexgrid::arrayToTuple(value);
+    }
+
+    vector<Position> positionsArg(const string& name, const vector<Var>& args, size_t i){
+        auto invalid = runtime_error("Argument " + to_string(i + 1) + " of " + name + " must be an array of positions");
+        if(args[i].index() != 4) throw invalid;
+        auto const& array = get<Array>(args[i]);
+        auto found = vector<Position>();
+        for(int j = 0; j < array.size(); j++){
+            auto value = array.get(j);
+            if(value.index() != 4 || get<Array>(value).size() != 3) throw invalid;
+            found.push_back(Hexgrid::arrayToTuple(value));
+        }
+        return found;
+    }
+
+    // Which of the neighbour counts 0 to 6 an array lists.
+    bitset<7> countsArg(const string& name, const vector<Var>& args, size_t i){
+        auto invalid = runtime_error("Argument " + to_string(i + 1) + " of " + name + " must be an array of counts from 0 to 6");
+        if(args[i].index() != 4) throw invalid;
+        auto const& array = get<Array>(args[i]);
+        auto listed = bitset<7>();
+        for(int j = 0; j < array.size(); j++){
+            auto count = array.get(j);
+            if(count.index() != 1 || get<int>(count) < 0 || get<int>(count) > 6) throw invalid;
+            listed.set(get<int>(count));
+        }
+        return listed;
+    }
+
+    Var positions(const vector<Position>& found){
+        auto array = Array();
+        for(auto const& pos : found) array.add(positionToArray(pos));
+        return array;
+    }
+
+    // flood(grid, seed) or flood(grid, seed, value)
+    Var flood(const vector<Var>& args){
+        checkArgCount("flood", args, 2, 3);
+        auto const& grid = hexgridArg("flood", args, 0);
+        auto seed = positionArg("flood", args, 1);
+        return positions(args.size() == 3 ? grid.flood(seed, args[2]) : grid.flood(seed));
+    }
+
+    // line(from, to)
+    Var line(const vector<Var>& args){
+        checkArgCount("line", args, 2, 2);
+        auto cells = Array();
+        for(auto walk = HexLine(positionArg("line", args, 0), positionArg("line", args, 1));
+            !walk.done(); walk.next())
+            cells.add(positionToArray(walk.current()));
+        return cells;
+    }
+
+    // fov(grid, observer, radius)
+    void fov(const vector<Var>& args, const function<void(const Var&)>& emit){
+        checkArgCount("fov", args, 3, 3);
+        auto const& grid = hexgridArg("fov", args, 0);
+        auto observer = positionArg("fov", args, 1);
+        if(args[2].index() != 1) throw runtime_error("Argument 3 of fov must be an integer");
+        grid.fieldOfView(observer, get<int>(args[2]), [&](const Position& pos){
+            emit(positionToArray(pos));
+        });
+    }
+
+    // distances(grid, sources)
+    Var distances(const vector<Var>& args){
+        checkArgCount("distances", args, 2, 2);
+        return hexgridArg("distances", args, 0).distances(positionsArg("distances", args, 1),
+                                                          false, availableThreads());
+    }
+
+    // nearest(grid, sources)
+    Var nearest(const vector<Var>& args){
+        checkArgCount("nearest", args, 2, 2);
+        return hexgridArg("nearest", args, 0).distances(positionsArg("nearest", args, 1),
+                                                        true, availableThreads());
+    }
+
+    // neighbour_sum(grid), neighbour_min(grid), ...
+    Builtin neighbourhood(const string& name, Reduction reduction){
+        return [name, reduction](const vector<Var>& args) -> Var {
+            checkArgCount(name, args, 1, 1);
+            return hexgridArg(name, args, 0).neighbourhood(reduction);
+        };
+    }
+
+    // step(grid, birth, survive), step(grid, birth, survive, alive, dead)
+    // or step(grid, "rule", alive)
+    Var step(const vector<Var>& args, const Call& call){
+        checkArgCount("step", args, 3, 5);
+        auto const& grid = hexgridArg("step", args, 0);
+        if(args[1].index() == 3){
+            checkArgCount("step", args, 3, 3);
+            auto const& rule = get<Symbol>(args[1]).str();
+            return grid.step(args[2], [&](const Var& value, int alive){
+                return call(rule, {value, alive});
+            }, availableThreads());
+        }
+        if(args.size() == 4) throw runtime_error("Wrong arg count for step");
+        auto birth = countsArg("step", args, 1);
+        auto survive = countsArg("step", args, 2);
+        auto alive = args.size() == 5 ? args[3] : Var(1);
+        auto dead = args.size() == 5 ? args[4] : Var(0);
+        // Cells holding neither value, walls say, stay as they are.
+        return grid.step(alive, [&](const Var& value, int living){
+            if(sameValue(value, alive)) return survive[living] ? alive : dead;
+            if(sameValue(value, dead)) return birth[living] ? alive : dead;
+            return value;
+        }, availableThreads());
+    }
+
+    // components(grid)
+    Var components(const vector<Var>& args){
+        checkArgCount("components", args, 1, 1);
+        return hexgridArg("components", args, 0).components();
+    }
+
+    // open(path) or open(path, pages)
+    Var openPaged(const vector<Var>& args){
+        checkArgCount("open", args, 1, 2);
+        if(args[0].index() != 3) throw runtime_error("Argument 1 of open must be a path");
+        auto pages = PagedGrid::defaultCachePages;
+        if(args.size() == 2){
+            if(args[1].index() != 1 || get<int>(args[1]) < 1)
+                throw runtime_error("Argument 2 of open must be a positive number of pages");
+            pages = size_t(get<int>(args[1]));
+        }
+        return Hexgrid::fromPages(make_shared<PagedGrid>(get<Symbol>(args[0]).str(), pages));
+    }
+
+    // page_stats(grid)
+    Var pageStats(const vector<Var>& args){
+        checkArgCount("page_stats", args, 1, 1);
+        auto pages = hexgridArg("page_stats", args, 0).getPages();
+        if(!pages) throw runtime_error("Argument 1 of page_stats must be a paged hexgrid");
+        auto stats = pages->getStats();
+        // Long scans may count past what an int holds; those stay at INT_MAX.
+        auto clamped = [](uint64_t count){ return int(min<uint64_t>(count, INT_MAX)); };
+        auto counts = Array();
+        counts.add(clamped(stats.hits));
+        counts.add(clamped(stats.faults));
+        return counts;
+    }
+}
+
+const map<string, Builtin>& intprt::builtins(){
+    static const map<string, Builtin> table = {
+        {"flood", flood},
+        {"components", components},
+        {"line", line},
+        {"open", openPaged},
+        {"page_stats", pageStats},
+        {"distances", distances},
+        {"nearest", nearest},
+        {"neighbour_sum", neighbourhood("neighbour_sum", Reduction::Sum)},
+        {"neighbour_min", neighbourhood("neighbour_min", Reduction::Min)},
+        {"neighbour_max", neighbourhood("neighbour_max", Reduction::Max)},
+        {"neighbour_count", neighbourhood("neighbour_count", Reduction::Count)},
+    };
+    return table;
+}
+
+const map<string, CallingBuiltin>& intprt::callingBuiltins(){
+    static const map<string, CallingBuiltin> table = {
+        {"step", step},
+    };
+    return table;
+}
+
+const map<string, Generator>& intprt::generators(){
+    static const map<string, Generator> table = {
+        {"fov", fov},
+    };
+    return table;
+}
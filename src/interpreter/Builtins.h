@@ -0,0 +1,35 @@
+#ifndef TKOM_BUILTINS_H
+#define TKOM_BUILTINS_H
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include "Interpreter.h"
+
+namespace intprt
+{
+
+// A native function, called like a user function with evaluated arguments.
+using Builtin = std::function<Var(const std::vector<Var>&)>;
+
+// A native function producing a sequence, handing each element to a
+// callback as soon as it is known. foreach runs its body for each element
+// as it comes; elsewhere the elements are collected into an array.
+using Generator = std::function<void(const std::vector<Var>&,
+                                     const std::function<void(const Var&)>&)>;
+
+// Calls a user function by name.
+using Call = std::function<Var(const std::string& name, std::vector<Var> args)>;
+
+// A native function taking user functions as arguments, by name.
+using CallingBuiltin = std::function<Var(const std::vector<Var>&, const Call&)>;
+
+// Built-in functions by name. A user function of the same name hides one.
+const std::map<std::string, Builtin>& builtins();
+const std::map<std::string, CallingBuiltin>& callingBuiltins();
+const std::map<std::string, Generator>& generators();
+
+} // namespace intprt
+
+#endif // TKOM_BUILTINS_H
@@ -0,0 +1,263 @@
+#include "CompressedGrid.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include "OutputWriter.h"
+using namespace intprt;
+using namespace std;
+
+namespace{
+    runtime_error corrupt(){
+        return runtime_error("Not a hexgrid file or a damaged one");
+    }
+
+    uint64_t zigzag(int64_t value){
+        return uint64_t(value) << 1 ^ uint64_t(value >> 63);
+    }
+
+    int64_t unzigzag(uint64_t value){
+        return int64_t(value >> 1) ^ -int64_t(value & 1);
+    }
+
+    void appendVarint(string& out, uint64_t value){
+        for(; value >= 0x80; value >>= 7) out.push_back(char(value | 0x80));
+        out.push_back(char(value));
+    }
+
+    void writeVarint(OutputWriter& out, uint64_t value){
+        for(; value >= 0x80; value >>= 7) out.writeUint8(uint8_t(value | 0x80));
+        out.writeUint8(uint8_t(value));
+    }
+
+    // A dictionary entry: the tag and the value, as written.
+    void encodeValue(string& out, const Var& value){
+        out.push_back(char(value.index()));
+        switch(value.index()){
+            case 0: break;
+            case 1: appendVarint(out, zigzag(get<int>(value))); break;
+            case 2: {
+                uint64_t bits;
+                auto number = get<double>(value);
+                memcpy(&bits, &number, sizeof bits);
+                for(int i = 0; i < 8; i++) out.push_back(char(bits >> 8 * i));
+                break;
+            }
+            case 3:
+                appendVarint(out, get<Symbol>(value).size());
+                out += get<Symbol>(value).str();
+                break;
+            default: throw runtime_error("Can only save cells holding numbers or text");
+        }
+    }
+
+    constexpr uint64_t explicitStep = 9;
+
+    // Cells are ordered along the curve all at once, which would read the
+    // whole of a paged grid into memory.
+    void checkNotPaged(const Hexgrid& grid){
+        if(grid.getPages()) throw runtime_error("Can't save a paged hexgrid compressed, load it first");
+    }
+}
+
+// The usual iterative conversion, quadrant by quadrant from the top, for
+// a curve of side 2^32.
+uint64_t gridfile::hilbertIndex(uint32_t x, uint32_t y){
+    uint64_t index = 0;
+    for(uint32_t side = 1u << 31; side; side >>= 1){
+        uint32_t rx = (x & side) ? 1 : 0, ry = (y & side) ? 1 : 0;
+        index += uint64_t(side) * side * ((3 * rx) ^ ry);
+        if(!ry){
+            if(rx){
+                x = ~x;
+                y = ~y;
+            }
+            swap(x, y);
+        }
+    }
+    return index;
+}
+
+void intprt::writeCompressedHexgrid(const Hexgrid& grid, ostream& stream){
+    checkNotPaged(grid);
+    // Offsets from the smallest coordinates keep the grid in one corner of
+    // the curve rather than split across its quadrants.
+    int64_t lowQ = 0, lowR = 0;
+    bool first = true;
+    grid.forEach([&](const Position& pos, const Var&){
+        if(first) lowQ = get<0>(pos), lowR = get<1>(pos);
+        lowR = min<int64_t>(lowR, get<1>(pos));
+        first = false;
+    });
+    // Values are told apart by their encoding, numbered as first seen.
+    struct Ordered { uint64_t index; Position pos; uint64_t number; };
+    auto order = vector<Ordered>();
+    order.reserve(size_t(grid.size()));
+    auto seen = unordered_map<string, uint64_t>();
+    auto distinct = vector<const string*>();
+    auto entry = string();
+    grid.forEach([&](const Position& pos, const Var& value){
+        entry.clear();
+        encodeValue(entry, value);
+        auto found = seen.emplace(entry, seen.size());
+        if(found.second) distinct.push_back(&found.first->first);
+        order.push_back({gridfile::hilbertIndex(uint32_t(get<0>(pos) - lowQ), uint32_t(get<1>(pos) - lowR)),
+                         pos, found.first->second});
+    });
+    sort(order.begin(), order.end(), [](const auto& a, const auto& b){ return a.index < b.index; });
+    // Renumbered in curve order, so that the values met first get the
+    // smallest numbers.
+    auto numbers = vector<uint64_t>(distinct.size(), uint64_t(-1));
+    auto entries = string();
+    uint64_t numbered = 0;
+    for(auto& cell : order){
+        if(numbers[cell.number] == uint64_t(-1)){
+            numbers[cell.number] = numbered++;
+            entries += *distinct[cell.number];
+        }
+        cell.number = numbers[cell.number];
+    }
+    auto out = OutputWriter(stream);
+    out.write(string_view(gridfile::compressedMagic, sizeof gridfile::compressedMagic));
+    writeVarint(out, order.size());
+    writeVarint(out, distinct.size());
+    out.write(entries);
+    int64_t q = 0, r = 0;
+    for(size_t i = 0; i < order.size(); i++){
+        auto const& pos = order[i].pos;
+        int64_t dq = get<0>(pos) - q, dr = get<1>(pos) - r;
+        if(dq >= -1 && dq <= 1 && dr >= -1 && dr <= 1)
+            writeVarint(out, order[i].number * 10 + uint64_t((dq + 1) * 3 + dr + 1));
+        else {
+            writeVarint(out, order[i].number * 10 + explicitStep);
+            writeVarint(out, zigzag(dq));
+            writeVarint(out, zigzag(dr));
+        }
+        q = get<0>(pos);
+        r = get<1>(pos);
+    }
+}
+
+void intprt::saveCompressedHexgrid(const Hexgrid& grid, const string& path){
+    // Before the file is emptied.
+    checkNotPaged(grid);
+    auto file = ofstream(path, ios::binary | ios::trunc);
+    if(!file) throw runtime_error("Can't write " + path);
+    writeCompressedHexgrid(grid, file);
+    file.flush();
+    if(!file) throw runtime_error("Can't write " + path);
+}
+
+CompressedGridReader::CompressedGridReader(istream& stream) : in(stream.rdbuf()) {
+    char magic[sizeof gridfile::compressedMagic];
+    if(!in || in->sgetn(magic, sizeof magic) != sizeof magic ||
+       memcmp(magic, gridfile::compressedMagic, sizeof magic)) throw corrupt();
+    cells = readVarint();
+    // Not reserved: a damaged count would run out of bytes, not memory.
+    for(auto count = readVarint(); count; count--){
+        switch(readByte()){
+            case 0: values.emplace_back(); break;
+            case 1: {
+                auto number = unzigzag(readVarint());
+                if(number < numeric_limits<int>::min() || number > numeric_limits<int>::max()) throw corrupt();
+                values.emplace_back(int(number));
+                break;
+            }
+            case 2: {
+                uint64_t bits = 0;
+                for(int i = 0; i < 8; i++) bits |= uint64_t(readByte()) << 8 * i;
+                double number;
+                memcpy(&number, &bits, sizeof number);
+                values.emplace_back(number);
+                break;
+            }
+            case 3: {
+                auto text = string();
+                char buffer[1 << 12];
+                for(auto left = readVarint(); left;){
+                    auto want = streamsize(min<uint64_t>(left, sizeof buffer));
+                    if(in->sgetn(buffer, want) != want) throw corrupt();
+                    text.append(buffer, size_t(want));
+                    left -= uint64_t(want);
+                }
+                values.emplace_back(move(text));
+                break;
+            }
+            default: throw corrupt();
+        }
+    }
+}
+
+uint64_t CompressedGridReader::size() const {
+    return cells;
+}
+
+bool CompressedGridReader::next(Position& pos, Var& value){
+    size_t number;
+    if(!next(pos, number)) return false;
+    value = values[number];
+    return true;
+}
+
+const vector<Var>& CompressedGridReader::getValues() const {
+    return values;
+}
+
+bool CompressedGridReader::next(Position& pos, size_t& value){
+    if(read == cells) return false;
+    auto code = readVarint();
+    auto number = code / 10, step = code % 10;
+    if(number >= values.size()) throw corrupt();
+    int64_t dq, dr;
+    if(step == explicitStep){
+        dq = unzigzag(readVarint());
+        dr = unzigzag(readVarint());
+        // Bounded, so that adding them can't overflow.
+        const int64_t span = int64_t(1) << 33;
+        if(dq < -span || dq > span || dr < -span || dr > span) throw corrupt();
+    } else {
+        dq = int64_t(step / 3) - 1;
+        dr = int64_t(step % 3) - 1;
+    }
+    q += dq;
+    r += dr;
+    if(q < numeric_limits<int>::min() || q > numeric_limits<int>::max() ||
+       r < numeric_limits<int>::min() || r > numeric_limits<int>::max()) throw corrupt();
+    pos = Position(int(q), int(r), int(-q - r));
+    value = size_t(number);
+    read++;
+    return true;
+}
+
+uint8_t CompressedGridReader::readByte(){
+    auto got = in->sbumpc();
+    if(got == char_traits<char>::eof()) throw corrupt();
+    return uint8_t(got);
+}
+
+uint64_t CompressedGridReader::readVarint(){
+    uint64_t value = 0;
+    for(int shift = 0; shift < 64; shift += 7){
+        auto byte = readByte();
+        value |= uint64_t(byte & 0x7f) << shift;
+        if(!(byte & 0x80)) return value;
+    }
+    throw corrupt();
+}
+
+Hexgrid intprt::readCompressedHexgrid(istream& stream){
+    auto reader = CompressedGridReader(stream);
+    // Sorted into storage order as positions and value numbers, which move
+    // much faster than values.
+    auto cells = vector<pair<Position, size_t>>();
+    auto pos = Position();
+    size_t value;
+    while(reader.next(pos, value)) cells.emplace_back(pos, value);
+    sort(cells.begin(), cells.end());
+    auto grid = Hexgrid();
+    auto const& values = reader.getValues();
+    for(auto const& [at, number] : cells)
+        if(!grid.append(at, values[number])) throw corrupt();
+    return grid;
+}
@@ -0,0 +1,68 @@
+#ifndef TKOM_COMPRESSED_GRID_H
+#define TKOM_COMPRESSED_GRID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Interpreter.h"
+
+namespace intprt
+{
+
+// Hexgrids written by save ... compressed. Varints are unsigned LEB128,
+// signed numbers are zigzag encoded first:
+//   header    char magic[8] "HEXGRIZ1", varint cells, varint values
+//   values    each distinct value once: uint8 tag (0 nothing, 1 int,
+//             2 float, 3 string), then a varint int, float64 bits or a
+//             varint length and the bytes
+//   cells     varint value number * 10 + step, where step 0 to 8 is
+//             (dq + 1) * 3 + (dr + 1) for a move of at most one in q and r
+//             from the previous cell, the first from (0, 0), and step 9 is
+//             followed by the varints dq and dr
+// Cells go along a Hilbert curve over (q, r), so that neighbouring cells
+// mostly follow each other and a cell of a small palette over a dense
+// grid takes one byte. Only cells holding numbers or text can be saved.
+namespace gridfile
+{
+    constexpr char compressedMagic[8] = {'H', 'E', 'X', 'G', 'R', 'I', 'Z', '1'};
+
+    // Position of (x, y) along a Hilbert curve filling 2^32 by 2^32 cells.
+    std::uint64_t hilbertIndex(std::uint32_t x, std::uint32_t y);
+}
+
+void writeCompressedHexgrid(const Hexgrid&, std::ostream&);
+void saveCompressedHexgrid(const Hexgrid&, const std::string& path);
+
+// Decodes cells one at a time as they are read, in the order they were
+// written; throws when the stream ends early or is damaged.
+class CompressedGridReader
+{
+public:
+    explicit CompressedGridReader(std::istream&);
+
+    std::uint64_t size() const;
+    // The next cell, false after the last.
+    bool next(Position&, Var&);
+    // The same, giving the number of the value in getValues().
+    bool next(Position&, std::size_t& value);
+    const std::vector<Var>& getValues() const;
+
+private:
+    std::uint8_t readByte();
+    std::uint64_t readVarint();
+
+    std::streambuf* in;
+    std::uint64_t cells = 0;
+    std::uint64_t read = 0;
+    std::vector<Var> values;
+    std::int64_t q = 0, r = 0;
+};
+
+Hexgrid readCompressedHexgrid(std::istream&);
+
+} // namespace intprt
+
+#endif // TKOM_COMPRESSED_GRID_H
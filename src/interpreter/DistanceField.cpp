@@ -0,0 +1,67 @@
+#include "Interpreter.h"
+#include "NeighbourTable.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <atomic>
+using namespace intprt;
+using namespace std;
+
+namespace{
+    // Frontiers smaller than this are expanded on one thread.
+    const size_t parallelFrontier = 1 << 14;
+
+    // A cell's distance and nearest source in one word, so that keeping
+    // the smaller of two keys keeps the closer source, or on a tie the
+    // one listed first.
+    const uint64_t unreached = UINT64_MAX;
+
+    uint64_t key(uint64_t distance, uint64_t source){
+        return distance << 32 | source;
+    }
+}
+
+// Breadth-first from all sources at once, one level at a time. A level is
+// expanded on several threads when it is large; each cell ends up with the
+// smallest key offered to it, so which thread gets there first doesn't
+// change the result.
+Hexgrid Hexgrid::distances(const vector<Position>& sources, bool nearest, unsigned threads) const {
+    requireCells();
+    auto table = NeighbourTable(*this);
+    auto reached = vector<atomic<uint64_t>>(table.size());
+    for(auto& cell : reached) cell.store(unreached, memory_order_relaxed);
+    auto frontier = vector<uint32_t>();
+    for(size_t source = 0; source < sources.size(); source++){
+        auto cell = table.find(sources[source]);
+        if(cell == NeighbourTable::none || reached[cell].load(memory_order_relaxed) != unreached) continue;
+        reached[cell].store(key(0, source), memory_order_relaxed);
+        frontier.push_back(cell);
+    }
+    for(uint64_t distance = 1; !frontier.empty(); distance++){
+        unsigned parts = frontier.size() >= parallelFrontier ? max(threads, 1u) : 1;
+        auto found = vector<vector<uint32_t>>(parts);
+        parallelChunks(frontier.size(), parts, [&](unsigned part, size_t begin, size_t end){
+            for(size_t i = begin; i < end; i++){
+                auto offer = key(distance, reached[frontier[i]].load(memory_order_relaxed) & 0xffffffff);
+                for(auto next : table.neighbours(frontier[i])){
+                    if(next == NeighbourTable::none) continue;
+                    auto current = reached[next].load(memory_order_relaxed);
+                    while(offer < current &&
+                          !reached[next].compare_exchange_weak(current, offer, memory_order_relaxed)) {}
+                    if(current == unreached) found[part].push_back(next);
+                }
+            }
+        });
+        frontier.clear();
+        for(auto const& cells : found) frontier.insert(frontier.end(), cells.begin(), cells.end());
+    }
+    auto field = Hexgrid();
+    auto& stored = field.data.edit();
+    for(size_t cell = 0; cell < table.size(); cell++){
+        auto found = reached[cell].load(memory_order_relaxed);
+        if(found == unreached) continue;
+        int value = int(nearest ? found & 0xffffffff : found >> 32);
+        stored.cells.emplace_hint(stored.cells.end(), table.position(cell), value);
+        stored.minStepCost = min(stored.minStepCost, double(value));
+    }
+    return field;
+}
@@ -0,0 +1,94 @@
+#include "Interpreter.h"
+using namespace intprt;
+using namespace std;
+
+namespace{
+    // The six directions in the order a ring is walked.
+    const Position ringDirections[6] = {
+        {1, -1, 0}, {1, 0, -1}, {0, 1, -1},
+        {-1, 1, 0}, {-1, 0, 1}, {0, -1, 1}};
+
+    // Where a ray from the observer crosses a side of a ring, as a
+    // fraction of the side: num / den with den > 0. Rings are scaled
+    // copies of each other, so a ray crosses every ring's side at the same
+    // fraction and rays can be compared exactly with integers.
+    struct Slope
+    {
+        long long num;
+        long long den;
+    };
+
+    bool operator<(Slope a, Slope b){
+        return a.num * b.den < b.num * a.den;
+    }
+
+    bool operator<=(Slope a, Slope b){
+        return !(b < a);
+    }
+
+    // A range of rays that hasn't been blocked yet.
+    struct Interval
+    {
+        Slope low;
+        Slope high;
+    };
+
+    bool lit(const vector<Interval>& intervals, Slope ray){
+        for(auto const& interval : intervals)
+            if(interval.low <= ray && ray <= interval.high) return true;
+        return false;
+    }
+
+    void shade(vector<Interval>& intervals, Slope low, Slope high){
+        auto kept = vector<Interval>();
+        for(auto const& interval : intervals){
+            if(!(low < interval.high) || !(interval.low < high)){
+                kept.push_back(interval);
+                continue;
+            }
+            if(interval.low < low) kept.push_back(Interval{interval.low, low});
+            if(high < interval.high) kept.push_back(Interval{high, interval.high});
+        }
+        intervals.swap(kept);
+    }
+
+    Position offset(const Position& pos, const Position& direction, long long times){
+        return Position(int(get<0>(pos) + get<0>(direction) * times),
+                        int(get<1>(pos) + get<1>(direction) * times),
+                        int(get<2>(pos) + get<2>(direction) * times));
+    }
+}
+
+// Shadow casting over the six sextants around the observer. Cell j of the
+// k-th ring on a sextant's side spans the rays (2j-1)/2k ... (2j+1)/2k and
+// is seen when the ray through its centre, j/k, is still lit. Occupied
+// cells of a ring shade their span for the rings beyond it. Cells at
+// the corners belong to two sextants; they are reported by the sextant
+// whose side starts at them.
+void Hexgrid::fieldOfView(const Position& observer, int radius,
+                          const function<void(const Position&)>& visit) const {
+    requireCells();
+    auto const& cells = data->cells;
+    if(radius < 0) throw std::runtime_error("Radius must not be negative");
+    visit(observer);
+    vector<Interval> sextants[6];
+    for(auto& sextant : sextants) sextant.push_back(Interval{{0, 1}, {1, 1}});
+    auto blockers = vector<long long>();
+    for(long long k = 1; k <= radius; k++){
+        bool anyLit = false;
+        for(int side = 0; side < 6; side++){
+            auto& intervals = sextants[side];
+            if(intervals.empty()) continue;
+            anyLit = true;
+            auto corner = offset(observer, ringDirections[(side + 4) % 6], k);
+            blockers.clear();
+            for(long long j = 0; j <= k; j++){
+                auto pos = offset(corner, ringDirections[side], j);
+                if(j < k && lit(intervals, Slope{j, k})) visit(pos);
+                if(cells.count(pos)) blockers.push_back(j);
+            }
+            for(auto j : blockers) shade(intervals, Slope{2 * j - 1, 2 * k}, Slope{2 * j + 1, 2 * k});
+        }
+        if(!anyLit) break;
+    }
+}
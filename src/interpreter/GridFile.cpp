@@ -0,0 +1,191 @@
+#include "GridFile.h"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "CompressedGrid.h"
+#include "OutputWriter.h"
+using namespace intprt;
+using namespace std;
+
+namespace{
+    // The bytes of a file, mapped into memory when it is a regular file,
+    // read otherwise.
+    class FileBytes
+    {
+    public:
+        explicit FileBytes(const string& path){
+            int file = open(path.c_str(), O_RDONLY);
+            if(file < 0) throw runtime_error("Can't open " + path);
+            struct stat status;
+            if(fstat(file, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0){
+                length = size_t(status.st_size);
+                mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file, 0);
+                if(mapped == MAP_FAILED) mapped = nullptr;
+                else madvise(mapped, length, MADV_SEQUENTIAL);
+            }
+            if(!mapped){
+                unsigned char buffer[1 << 16];
+                for(ssize_t got; (got = read(file, buffer, sizeof buffer)) > 0;)
+                    copy.insert(copy.end(), buffer, buffer + got);
+                length = copy.size();
+            }
+            close(file);
+        }
+        ~FileBytes(){
+            if(mapped) munmap(mapped, length);
+        }
+        FileBytes(const FileBytes&) = delete;
+        FileBytes& operator=(const FileBytes&) = delete;
+
+        const unsigned char* data() const {
+            return mapped ? static_cast<const unsigned char*>(mapped) : copy.data();
+        }
+        size_t size() const {
+            return length;
+        }
+
+    private:
+        void* mapped = nullptr;
+        size_t length = 0;
+        vector<unsigned char> copy;
+    };
+
+    runtime_error corrupt(){
+        return runtime_error("Not a hexgrid file or a damaged one");
+    }
+
+    struct SymbolHash
+    {
+        size_t operator()(const Symbol& text) const { return text.hash(); }
+    };
+}
+
+uint32_t gridfile::readUint32(const unsigned char* bytes){
+    return uint32_t(bytes[0]) | uint32_t(bytes[1]) << 8 | uint32_t(bytes[2]) << 16 | uint32_t(bytes[3]) << 24;
+}
+
+uint64_t gridfile::readUint64(const unsigned char* bytes){
+    return uint64_t(readUint32(bytes)) | uint64_t(readUint32(bytes + 4)) << 32;
+}
+
+gridfile::Layout gridfile::readHeader(const unsigned char* header, uint64_t fileSize){
+    if(fileSize < headerSize || memcmp(header, magic, sizeof magic)) throw corrupt();
+    auto layout = Layout();
+    layout.cells = readUint64(header + 8);
+    layout.strings = readUint64(header + 16);
+    layout.stringBytes = readUint64(header + 24);
+    // Bounded first, so that the offsets below can't overflow.
+    if(layout.cells > fileSize || layout.strings > fileSize || layout.stringBytes > fileSize ||
+       layout.fileSize() != fileSize) throw corrupt();
+    return layout;
+}
+
+// Strings are numbered in a first walk over the cells, then each column
+// is written in a walk of its own, so that none is held in memory and a
+// paged grid is saved a page at a time.
+void intprt::saveHexgrid(const Hexgrid& grid, const string& path){
+    uint64_t cellCount = 0;
+    // By text, so that text of its own isn't interned to be told apart.
+    auto stringNumbers = unordered_map<Symbol, uint64_t, SymbolHash>();
+    auto strings = vector<Symbol>();
+    uint64_t stringBytes = 0;
+    grid.forEach([&](const Position&, const Var& value){
+        cellCount++;
+        if(value.index() > 3) throw runtime_error("Can only save cells holding numbers or text");
+        if(value.index() != 3) return;
+        auto found = stringNumbers.emplace(get<Symbol>(value), strings.size());
+        if(!found.second) return;
+        strings.push_back(get<Symbol>(value));
+        stringBytes += strings.back().size();
+    });
+    auto file = ofstream(path, ios::binary | ios::trunc);
+    if(!file) throw runtime_error("Can't write " + path);
+    {
+        auto out = OutputWriter(file);
+        out.write(string_view(gridfile::magic, sizeof gridfile::magic));
+        out.writeUint64(cellCount);
+        out.writeUint64(strings.size());
+        out.writeUint64(stringBytes);
+        grid.forEach([&](const Position& pos, const Var&){ out.writeInt32(get<0>(pos)); });
+        grid.forEach([&](const Position& pos, const Var&){ out.writeInt32(get<1>(pos)); });
+        grid.forEach([&](const Position&, const Var& value){ out.writeUint8(uint8_t(value.index())); });
+        for(size_t padding = (8 - cellCount % 8) % 8; padding; padding--) out.writeUint8(0);
+        grid.forEach([&](const Position&, const Var& value){
+            switch(value.index()){
+                case 1: out.writeUint64(uint64_t(int64_t(get<int>(value)))); break;
+                case 2: {
+                    uint64_t bits;
+                    auto number = get<double>(value);
+                    memcpy(&bits, &number, sizeof bits);
+                    out.writeUint64(bits);
+                    break;
+                }
+                case 3: out.writeUint64(stringNumbers.at(get<Symbol>(value))); break;
+                default: out.writeUint64(0);
+            }
+        });
+        uint64_t offset = 0;
+        for(auto const& text : strings){
+            out.writeUint64(offset);
+            offset += text.size();
+        }
+        out.writeUint64(offset);
+        for(auto const& text : strings) out.write(text.str());
+    }
+    file.flush();
+    if(!file) throw runtime_error("Can't write " + path);
+}
+
+Hexgrid intprt::loadHexgrid(const string& path){
+    {
+        auto file = ifstream(path, ios::binary);
+        char magic[sizeof gridfile::compressedMagic] = {};
+        if(file.read(magic, sizeof magic) && !memcmp(magic, gridfile::compressedMagic, sizeof magic)){
+            file.seekg(0);
+            return readCompressedHexgrid(file);
+        }
+    }
+    auto bytes = FileBytes(path);
+    auto data = bytes.data();
+    auto layout = gridfile::readHeader(data, bytes.size());
+    auto offsets = data + layout.offsetColumn();
+    auto text = reinterpret_cast<const char*>(data + layout.stringData());
+    // Each string is interned once, its cells share the symbol.
+    auto strings = vector<Symbol>();
+    for(uint64_t i = 0; i < layout.strings; i++){
+        auto begin = gridfile::readUint64(offsets + 8 * i), end = gridfile::readUint64(offsets + 8 * i + 8);
+        if(begin > end || end > layout.stringBytes) throw corrupt();
+        strings.emplace_back(string_view(text + begin, size_t(end - begin)));
+    }
+    auto grid = Hexgrid();
+    for(uint64_t cell = 0; cell < layout.cells; cell++){
+        int q = int32_t(gridfile::readUint32(data + layout.qColumn() + 4 * cell));
+        int r = int32_t(gridfile::readUint32(data + layout.rColumn() + 4 * cell));
+        auto raw = gridfile::readUint64(data + layout.valueColumn() + 8 * cell);
+        auto value = Var();
+        switch(data[layout.tagColumn() + cell]){
+            case 0: break;
+            case 1: value = int(int64_t(raw)); break;
+            case 2: {
+                double number;
+                memcpy(&number, &raw, sizeof number);
+                value = number;
+                break;
+            }
+            case 3: {
+                if(raw >= layout.strings) throw corrupt();
+                value = strings[raw];
+                break;
+            }
+            default: throw corrupt();
+        }
+        if(!grid.append(Position(q, r, -q - r), move(value))) throw corrupt();
+    }
+    return grid;
+}
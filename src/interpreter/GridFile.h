@@ -0,0 +1,60 @@
+#ifndef TKOM_GRID_FILE_H
+#define TKOM_GRID_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "Interpreter.h"
+
+namespace intprt
+{
+
+// Hexgrids saved with save and read back with load. All numbers are
+// little-endian and every column starts at a multiple of 8 bytes:
+//   header    char magic[8] "HEXGRID1", uint64 cells, uint64 strings,
+//             uint64 string bytes
+//   int32     q[cells]
+//   int32     r[cells]            s follows from q and r
+//   uint8     tag[cells]          0 nothing, 1 int, 2 float, 3 string,
+//                                 padded with zeros to a multiple of 8
+//   uint64    value[cells]        int64, float64 bits or string number
+//   uint64    offset[strings + 1] of each string in the bytes below
+//   char      bytes[string bytes]
+// Cells are in storage order, (q, r) ascending, and each distinct string
+// is stored once. Only cells holding numbers or text can be saved.
+namespace gridfile
+{
+    constexpr char magic[8] = {'H', 'E', 'X', 'G', 'R', 'I', 'D', '1'};
+    constexpr std::size_t headerSize = 32;
+
+    struct Layout
+    {
+        std::uint64_t cells = 0;
+        std::uint64_t strings = 0;
+        std::uint64_t stringBytes = 0;
+
+        std::uint64_t qColumn() const { return headerSize; }
+        std::uint64_t rColumn() const { return qColumn() + 4 * cells; }
+        std::uint64_t tagColumn() const { return rColumn() + 4 * cells; }
+        std::uint64_t valueColumn() const { return tagColumn() + (cells + 7) / 8 * 8; }
+        std::uint64_t offsetColumn() const { return valueColumn() + 8 * cells; }
+        std::uint64_t stringData() const { return offsetColumn() + 8 * (strings + 1); }
+        std::uint64_t fileSize() const { return stringData() + stringBytes; }
+    };
+
+    // Checks the magic and that the sizes fit in fileSize.
+    Layout readHeader(const unsigned char* header, std::uint64_t fileSize);
+
+    std::uint32_t readUint32(const unsigned char*);
+    std::uint64_t readUint64(const unsigned char*);
+}
+
+void saveHexgrid(const Hexgrid&, const std::string& path);
+// Maps the file into memory, or reads it when it can't be mapped, and
+// stores the cells straight from its columns. Compressed files, see
+// CompressedGrid.h, are decoded instead.
+Hexgrid loadHexgrid(const std::string& path);
+
+} // namespace intprt
+
+#endif // TKOM_GRID_FILE_H
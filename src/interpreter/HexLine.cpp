@@ -0,0 +1,49 @@
+#include "HexLine.h"
+using namespace intprt;
+using namespace std;
+
+HexLine::HexLine(const Position& from, const Position& to)
+: q{get<0>(from), 0, (long long)get<0>(to) - get<0>(from)},
+  r{get<1>(from), 0, (long long)get<1>(to) - get<1>(from)},
+  s{get<2>(from), 0, (long long)get<2>(to) - get<2>(from)},
+  steps(hexDistance(from, to)) {}
+
+bool HexLine::done() const {
+    return taken > steps;
+}
+
+long long HexLine::size() const {
+    return steps + 1;
+}
+
+// Each axis holds its coordinate rounded to the nearest integer; the
+// three roundings may not sum to zero, and then the axis that was rounded
+// the furthest is the one recomputed from the other two.
+Position HexLine::current() const {
+    auto eq = llabs(q.error), er = llabs(r.error), es = llabs(s.error);
+    if(eq > er && eq > es) return Position(int(-r.value - s.value), int(r.value), int(s.value));
+    if(er > es) return Position(int(q.value), int(-q.value - s.value), int(s.value));
+    return Position(int(q.value), int(r.value), int(-q.value - r.value));
+}
+
+// Halves round up on q and r and down on s, so a line running exactly
+// along the edge between two cells consistently takes the same side.
+void HexLine::step(Axis& axis, bool roundHalfUp){
+    axis.error += axis.delta;
+    long long twice = 2 * axis.error;
+    if(roundHalfUp ? twice >= steps : twice > steps){
+        axis.value++;
+        axis.error -= steps;
+    } else if(roundHalfUp ? twice < -steps : twice <= -steps){
+        axis.value--;
+        axis.error += steps;
+    }
+}
+
+void HexLine::next(){
+    taken++;
+    if(taken > steps) return;
+    step(q, true);
+    step(r, true);
+    step(s, false);
+}
@@ -0,0 +1,41 @@
+#ifndef TKOM_HEX_LINE_H
+#define TKOM_HEX_LINE_H
+
+#include "HexMath.h"
+
+namespace intprt
+{
+
+// Walks the cells on the straight line between two cells, both included.
+// Like Bresenham's line it steps with integer additions and comparisons
+// only: each coordinate keeps the error of its rounding, scaled by the
+// length of the line, and moves by one when the error passes a half.
+//
+//   for(auto line = HexLine(a, b); !line.done(); line.next()) use(line.current());
+class HexLine
+{
+public:
+    HexLine(const Position& from, const Position& to);
+    bool done() const;
+    Position current() const;
+    void next();
+    // Number of cells on the line.
+    long long size() const;
+
+private:
+    struct Axis
+    {
+        long long value;
+        long long error;
+        long long delta;
+    };
+    void step(Axis&, bool roundHalfUp);
+
+    Axis q, r, s;
+    long long steps;
+    long long taken = 0;
+};
+
+} // namespace intprt
+
+#endif // TKOM_HEX_LINE_H
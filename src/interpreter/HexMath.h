@@ -0,0 +1,45 @@
+#ifndef TKOM_HEX_MATH_H
+#define TKOM_HEX_MATH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <tuple>
+
+namespace intprt
+{
+
+// Cube coordinates [q, r, s] of a cell, q + r + s == 0.
+using Position = std::tuple<int, int, int>;
+
+struct PositionHash
+{
+    std::size_t operator()(const Position& pos) const
+    {
+        // s follows from q and r.
+        auto key = (std::uint64_t(std::uint32_t(std::get<0>(pos))) << 32) |
+                   std::uint32_t(std::get<1>(pos));
+        key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+        return std::size_t(key ^ (key >> 31));
+    }
+};
+
+// Number of steps between two cells.
+inline long long hexDistance(const Position& a, const Position& b)
+{
+    long long dq = std::llabs((long long)std::get<0>(a) - std::get<0>(b));
+    long long dr = std::llabs((long long)std::get<1>(a) - std::get<1>(b));
+    long long ds = std::llabs((long long)std::get<2>(a) - std::get<2>(b));
+    return (dq + dr + ds) / 2;
+}
+
+// Number of cells at most radius steps from a cell, itself included.
+inline unsigned long long hexCount(unsigned long long radius)
+{
+    return 3 * radius * (radius + 1) + 1;
+}
+
+} // namespace intprt
+
+#endif // TKOM_HEX_MATH_H
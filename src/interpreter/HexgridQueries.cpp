@@ -0,0 +1,56 @@
+#include "Interpreter.h"
+#include "HexLine.h"
+#include <climits>
+using namespace intprt;
+using namespace std;
+
+Var Hexgrid::within(Var center, int radius){
+    auto positions = Array();
+    within(arrayToTuple(center), radius, [&](const Position& pos){
+        positions.add(positionToArray(pos));
+    });
+    return positions;
+}
+
+void Hexgrid::within(const Position& center, int radius,
+                     const function<void(const Position&)>& visit) const {
+    requireCells();
+    auto const& cells = data->cells;
+    if(radius < 0) throw std::runtime_error("Radius must not be negative");
+    long long q = get<0>(center), r = get<1>(center), s = get<2>(center);
+    // Probing every position in range costs a lookup each, scanning costs
+    // one step per occupied cell: probe small neighbourhoods of big grids,
+    // scan otherwise.
+    if((unsigned long long)radius < cells.size() && hexCount(radius) < cells.size()){
+        for(long long dq = -radius; dq <= radius; dq++){
+            long long first = max<long long>(-radius, -dq - radius);
+            long long last = min<long long>(radius, -dq + radius);
+            for(long long dr = first; dr <= last; dr++){
+                long long pq = q + dq, pr = r + dr, ps = s - dq - dr;
+                if(pq < INT_MIN || pq > INT_MAX || pr < INT_MIN || pr > INT_MAX ||
+                   ps < INT_MIN || ps > INT_MAX) continue;
+                auto pos = Position(int(pq), int(pr), int(ps));
+                if(cells.count(pos)) visit(pos);
+            }
+        }
+        return;
+    }
+    // Cells are ordered by q, so only the band q - radius ... q + radius
+    // is scanned.
+    auto it = cells.lower_bound(Position(int(max<long long>(q - radius, INT_MIN)), INT_MIN, INT_MIN));
+    for(; it != cells.end() && get<0>(it->first) <= q + radius; ++it){
+        if(hexDistance(it->first, center) <= radius) visit(it->first);
+    }
+}
+
+bool Hexgrid::visible(const Position& source, const Position& target) const {
+    requireCells();
+    auto const& cells = data->cells;
+    auto line = HexLine(source, target);
+    for(line.next(); !line.done(); line.next()){
+        auto pos = line.current();
+        if(pos == target) break;
+        if(cells.count(pos)) return false;
+    }
+    return true;
+}
@@ -0,0 +1,89 @@
+#include "InstrumentedInterpreter.h"
+using namespace ast;
+using namespace intprt;
+
+namespace{
+    // Balances enter/leave even when a visit throws.
+    class ListenerGuard
+    {
+    public:
+        ListenerGuard(ExecutionListener& listener_, const char* kind, const Node& node)
+        : listener(listener_) { listener.enter(kind, node); }
+        ~ListenerGuard() { listener.leave(); }
+    private:
+        ExecutionListener& listener;
+    };
+}
+
+void ListenerGroup::add(ExecutionListener& listener){
+    listeners.push_back(&listener);
+}
+
+bool ListenerGroup::empty() const {
+    return listeners.empty();
+}
+
+void ListenerGroup::enter(const char* kind, const Node& node){
+    for(auto listener : listeners) listener->enter(kind, node);
+}
+
+void ListenerGroup::leave(){
+    for(auto it = listeners.rbegin(); it != listeners.rend(); it++) (*it)->leave();
+}
+
+InstrumentedInterpreter::InstrumentedInterpreter(ExecutionListener& listener_)
+: listener(listener_) {}
+
+template<class NodeT>
+void InstrumentedInterpreter::instrumented(const char* kind, NodeT& node)
+{
+    ListenerGuard guard(listener, kind, node);
+    Interpreter::visit(node);
+}
+
+void InstrumentedInterpreter::visit(Program& node){ instrumented("Program", node); }
+void InstrumentedInterpreter::visit(VariableDeclarationStatement& node){ instrumented("VariableDeclarationStatement", node); }
+void InstrumentedInterpreter::visit(FunctionDefinition& node){ instrumented("FunctionDefinition", node); }
+void InstrumentedInterpreter::visit(StatementBlock& node){ instrumented("StatementBlock", node); }
+void InstrumentedInterpreter::visit(FunctionCall& node){ instrumented("FunctionCall", node); }
+void InstrumentedInterpreter::visit(VariableReference& node){ instrumented("VariableReference", node); }
+void InstrumentedInterpreter::visit(TextLiteral& node){ instrumented("TextLiteral", node); }
+void InstrumentedInterpreter::visit(IntegerLiteral& node){ instrumented("IntegerLiteral", node); }
+void InstrumentedInterpreter::visit(DecimalLiteral& node){ instrumented("DecimalLiteral", node); }
+void InstrumentedInterpreter::visit(HexgridLiteral& node){ instrumented("HexgridLiteral", node); }
+void InstrumentedInterpreter::visit(HexgridCell& node){ instrumented("HexgridCell", node); }
+void InstrumentedInterpreter::visit(ArrayLiteral& node){ instrumented("ArrayLiteral", node); }
+void InstrumentedInterpreter::visit(OrExpression& node){ instrumented("OrExpression", node); }
+void InstrumentedInterpreter::visit(AndExpression& node){ instrumented("AndExpression", node); }
+void InstrumentedInterpreter::visit(LessExpression& node){ instrumented("LessExpression", node); }
+void InstrumentedInterpreter::visit(LessOrEqualExpression& node){ instrumented("LessOrEqualExpression", node); }
+void InstrumentedInterpreter::visit(GreaterExpression& node){ instrumented("GreaterExpression", node); }
+void InstrumentedInterpreter::visit(GreaterOrEqualExpression& node){ instrumented("GreaterOrEqualExpression", node); }
+void InstrumentedInterpreter::visit(EqualExpression& node){ instrumented("EqualExpression", node); }
+void InstrumentedInterpreter::visit(NotEqualExpression& node){ instrumented("NotEqualExpression", node); }
+void InstrumentedInterpreter::visit(BesideExpression& node){ instrumented("BesideExpression", node); }
+void InstrumentedInterpreter::visit(ByExpression& node){ instrumented("ByExpression", node); }
+void InstrumentedInterpreter::visit(OnExpression& node){ instrumented("OnExpression", node); }
+void InstrumentedInterpreter::visit(WithinExpression& node){ instrumented("WithinExpression", node); }
+void InstrumentedInterpreter::visit(PathExpression& node){ instrumented("PathExpression", node); }
+void InstrumentedInterpreter::visit(VisibleExpression& node){ instrumented("VisibleExpression", node); }
+void InstrumentedInterpreter::visit(AddExpression& node){ instrumented("AddExpression", node); }
+void InstrumentedInterpreter::visit(SubtructExpression& node){ instrumented("SubtructExpression", node); }
+void InstrumentedInterpreter::visit(MultiplyExpression& node){ instrumented("MultiplyExpression", node); }
+void InstrumentedInterpreter::visit(DivideExpression& node){ instrumented("DivideExpression", node); }
+void InstrumentedInterpreter::visit(ModuloExpression& node){ instrumented("ModuloExpression", node); }
+void InstrumentedInterpreter::visit(LogicalNegation& node){ instrumented("LogicalNegation", node); }
+void InstrumentedInterpreter::visit(ArithmeticalNegation& node){ instrumented("ArithmeticalNegation", node); }
+void InstrumentedInterpreter::visit(IndexingExpression& node){ instrumented("IndexingExpression", node); }
+void InstrumentedInterpreter::visit(AssignmentStatement& node){ instrumented("AssignmentStatement", node); }
+void InstrumentedInterpreter::visit(InitializationStatement& node){ instrumented("InitializationStatement", node); }
+void InstrumentedInterpreter::visit(AddStatement& node){ instrumented("AddStatement", node); }
+void InstrumentedInterpreter::visit(ConditionBlock& node){ instrumented("ConditionBlock", node); }
+void InstrumentedInterpreter::visit(ForeachStatement& node){ instrumented("ForeachStatement", node); }
+void InstrumentedInterpreter::visit(ParallelForeachStatement& node){ instrumented("ParallelForeachStatement", node); }
+void InstrumentedInterpreter::visit(SaveStatement& node){ instrumented("SaveStatement", node); }
+void InstrumentedInterpreter::visit(LoadExpression& node){ instrumented("LoadExpression", node); }
+void InstrumentedInterpreter::visit(IfStatement& node){ instrumented("IfStatement", node); }
+void InstrumentedInterpreter::visit(MoveStatement& node){ instrumented("MoveStatement", node); }
+void InstrumentedInterpreter::visit(RemoveStatement& node){ instrumented("RemoveStatement", node); }
+void InstrumentedInterpreter::visit(ReturnStatement& node){ instrumented("ReturnStatement", node); }
@@ -0,0 +1,97 @@
+#ifndef TKOM_INSTRUMENTED_INTERPRETER_H
+#define TKOM_INSTRUMENTED_INTERPRETER_H
+
+#include <vector>
+#include <parser/Ast.h>
+#include "Interpreter.h"
+
+namespace intprt
+{
+
+// Receives a notification around every node the interpreter visits.
+// kind is a string literal naming the node class.
+class ExecutionListener
+{
+public:
+    virtual ~ExecutionListener() = default;
+    virtual void enter(const char* kind, const ast::Node&) = 0;
+    virtual void leave() = 0;
+};
+
+// Forwards notifications to several listeners in the order they were added.
+class ListenerGroup : public ExecutionListener
+{
+public:
+    void add(ExecutionListener&);
+    bool empty() const;
+    void enter(const char* kind, const ast::Node&) override;
+    void leave() override;
+private:
+    std::vector<ExecutionListener*> listeners;
+};
+
+// Interpreter that reports each visit to a listener before delegating to
+// the plain Interpreter. Kept as a separate class so that runs without
+// instrumentation pay nothing for it.
+class InstrumentedInterpreter : public Interpreter
+{
+public:
+    InstrumentedInterpreter(ExecutionListener&);
+
+    void visit(ast::Program&) override;
+    void visit(ast::VariableDeclarationStatement&) override;
+    void visit(ast::FunctionDefinition&) override;
+    void visit(ast::StatementBlock&) override;
+    void visit(ast::FunctionCall&) override;
+    void visit(ast::VariableReference&) override;
+    void visit(ast::TextLiteral&) override;
+    void visit(ast::IntegerLiteral&) override;
+    void visit(ast::DecimalLiteral&) override;
+    void visit(ast::HexgridLiteral&) override;
+    void visit(ast::HexgridCell&) override;
+    void visit(ast::ArrayLiteral&) override;
+    void visit(ast::OrExpression&) override;
+    void visit(ast::AndExpression&) override;
+    void visit(ast::LessExpression&) override;
+    void visit(ast::LessOrEqualExpression&) override;
+    void visit(ast::GreaterExpression&) override;
+    void visit(ast::GreaterOrEqualExpression&) override;
+    void visit(ast::EqualExpression&) override;
+    void visit(ast::NotEqualExpression&) override;
+    void visit(ast::BesideExpression&) override;
+    void visit(ast::ByExpression&) override;
+    void visit(ast::OnExpression&) override;
+    void visit(ast::WithinExpression&) override;
+    void visit(ast::PathExpression&) override;
+    void visit(ast::VisibleExpression&) override;
+    void visit(ast::AddExpression&) override;
+    void visit(ast::SubtructExpression&) override;
+    void visit(ast::MultiplyExpression&) override;
+    void visit(ast::DivideExpression&) override;
+    void visit(ast::ModuloExpression&) override;
+    void visit(ast::LogicalNegation&) override;
+    void visit(ast::ArithmeticalNegation&) override;
+    void visit(ast::IndexingExpression&) override;
+    void visit(ast::AssignmentStatement&) override;
+    void visit(ast::InitializationStatement&) override;
+    void visit(ast::AddStatement&) override;
+    void visit(ast::ConditionBlock&) override;
+    void visit(ast::ForeachStatement&) override;
+    void visit(ast::ParallelForeachStatement&) override;
+    void visit(ast::SaveStatement&) override;
+    void visit(ast::LoadExpression&) override;
+    void visit(ast::IfStatement&) override;
+    void visit(ast::MoveStatement&) override;
+    void visit(ast::RemoveStatement&) override;
+    void visit(ast::ReturnStatement&) override;
+
+private:
+    template<class NodeT>
+    void instrumented(const char* kind, NodeT& node);
+
+    ExecutionListener& listener;
+};
+
+} // namespace intprt
+
+#endif // TKOM_INSTRUMENTED_INTERPRETER_H
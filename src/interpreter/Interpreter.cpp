@@ -1,41 +1,68 @@
 #include "Interpreter.h"
+#include "Builtins.h"
+#include "CompressedGrid.h"
+#include "GridFile.h"
+#include "PagedGrid.h"
+#include "ValueFormat.h"
+#include <algorithm>
+#include <sstream>
 using namespace ast;
 using namespace parser;
 using namespace std;
 using namespace intprt;
 
-Array::Array(){
-    values = vector<Var>();
-}
+Array::Array(){}
 Var Array::get(int i) const {
-    return values[i];
+    return (*values)[i];
 }
 void Array::add(Var v){
-    values.push_back(v);
+    values.edit().push_back(move(v));
 }
 int Array::size() const {
-    return values.size();
+    return values->size();
 }
 std::string Array::toString()const{
-    string returnString="[ ";
-    for(auto& elem : values){
-        switch(elem.index()){
-            case 1: 
-                returnString+=to_string(std::get<int>(elem));
-                break;
-            case 2: 
-                returnString+=to_string(std::get<double>(elem));
-                break;
-            case 3: returnString+=std::get<string>(elem);
-                break;
-            case 4: returnString+=std::get<Array>(elem).toString();
-                break;
-            case 5: returnString+=std::get<Hexgrid>(elem).toString();
-                break;
-        }
-        returnString += ", ";
+    ostringstream out;
+    {
+        OutputWriter writer(out);
+        write(writer);
+    }
+    return out.str();
+}
+void Array::write(OutputWriter& out) const {
+    out.write("[ ");
+    for(auto& elem : *values){
+        writeElement(out, elem);
+        out.write(", ");
+    }
+    out.write(']');
+}
+
+void intprt::internText(Var& value){
+    if(value.index() == 3 && !get<Symbol>(value).isInterned()) value = get<Symbol>(value).interned();
+}
+
+Array intprt::positionToArray(const Position& pos){
+    auto position = Array();
+    position.add(get<0>(pos));
+    position.add(get<1>(pos));
+    position.add(get<2>(pos));
+    return position;
+}
+
+void intprt::writeElement(OutputWriter& out, const Var& elem){
+    switch(elem.index()){
+        case 1: out.write(std::get<int>(elem));
+            break;
+        case 2: out.writeFixed(std::get<double>(elem));
+            break;
+        case 3: out.write(std::get<Symbol>(elem).str());
+            break;
+        case 4: std::get<Array>(elem).write(out);
+            break;
+        case 5: std::get<Hexgrid>(elem).write(out);
+            break;
     }
-    return returnString + "]";
 }
 
 Hexgrid::Hexgrid(){
@@ -57,33 +84,85 @@ Var Hexgrid::on(int q, int r, int s)  {
 }
 
 Var Hexgrid::on(tuple<int, int, int> key)  {
-    if(!cells.count(key)) throw std::runtime_error("No such cell");
-    return cells[key];
+    if(data->pages) return data->pages->on(key);
+    auto cell = data->cells.find(key);
+    if(cell == data->cells.end()) throw std::runtime_error("No such cell");
+    return cell->second;
 }
 void Hexgrid::add(Var arr, Var value){
+    requireCells();
     auto key = arrayToTuple(arr);
-    if(cells.count(key)) throw std::runtime_error("Cell is taken");
-    cells[key] = value;
+    if(data->cells.count(key)) throw std::runtime_error("Cell is taken");
+    auto& stored = data.edit();
+    auto cost = stepCost(value);
+    if(cost >= 0 && cost < stored.minStepCost) stored.minStepCost = cost;
+    internText(value);
+    stored.cells[key] = move(value);
+}
+Hexgrid Hexgrid::fromCells(vector<pair<Position, Var>> cells){
+    stable_sort(cells.begin(), cells.end(), [](const auto& a, const auto& b){ return a.first < b.first; });
+    auto hex = Hexgrid();
+    auto& stored = hex.data.edit();
+    for(auto& [pos, value] : cells){
+        if(!stored.cells.empty() && prev(stored.cells.end())->first == pos) throw std::runtime_error("Cell is taken");
+        auto cost = stepCost(value);
+        if(cost >= 0 && cost < stored.minStepCost) stored.minStepCost = cost;
+        internText(value);
+        stored.cells.emplace_hint(stored.cells.end(), pos, move(value));
+    }
+    return hex;
+}
+
+bool Hexgrid::append(const Position& pos, Var value){
+    requireCells();
+    if(!data->cells.empty() && !(prev(data->cells.end())->first < pos)) return false;
+    auto& stored = data.edit();
+    auto cost = stepCost(value);
+    if(cost >= 0 && cost < stored.minStepCost) stored.minStepCost = cost;
+    internText(value);
+    stored.cells.emplace_hint(stored.cells.end(), pos, move(value));
+    return true;
+}
+
+Hexgrid Hexgrid::fromPages(shared_ptr<PagedGrid> pages){
+    auto hex = Hexgrid();
+    hex.data.edit().pages = move(pages);
+    return hex;
+}
+
+PagedGrid* Hexgrid::getPages() const {
+    return data->pages.get();
+}
+
+void Hexgrid::requireCells() const {
+    if(data->pages) throw std::runtime_error("Only on, beside and foreach work on a paged hexgrid");
 }
-Var Hexgrid::by(Var value){
+
+void Hexgrid::forEach(const function<void(const Position&, const Var&)>& each) const {
+    if(data->pages) return data->pages->forEach(each);
+    for(auto const& [pos, value] : data->cells) each(pos, value);
+}
+
+Var Hexgrid::by(Var value, unsigned threads){
+    requireCells();
     auto foundPositions = Array();
-    for(auto const& [pos, cellValue] : cells){
-        const size_t index = cellValue.index();
-        if(index == value.index()){
-            if( (index == 1 && std::get<1>(value) == std::get<1>(cellValue)) ||
-                (index == 2 && std::get<2>(value) == std::get<2>(cellValue)) ||
-                (index == 3 && std::get<3>(value) == std::get<3>(cellValue))){
-                auto posArray = Array();
-                posArray.add(std::get<0>(pos));
-                posArray.add(std::get<1>(pos));
-                posArray.add(std::get<2>(pos));
-                foundPositions.add(posArray);
-            }
-        }
+    auto const& cells = data->cells;
+    if(threads <= 1 || cells.size() < parallelScanCells){
+        for(auto const& [pos, cellValue] : cells)
+            if(sameValue(cellValue, value)) foundPositions.add(positionToArray(pos));
+        return foundPositions;
     }
-    Var returnArray = Var();
-    returnArray = foundPositions;
-    return returnArray;
+    // More ranges than threads, so that threads done early take over the
+    // ranges of the others.
+    auto parts = ranges(size_t(threads) * 8);
+    auto found = vector<vector<Var>>(parts.size());
+    parallelTasks(parts.size(), threads, [&](size_t part){
+        for(auto cell = parts[part].first; cell != parts[part].second; ++cell)
+            if(sameValue(cell->second, value)) found[part].push_back(positionToArray(cell->first));
+    });
+    for(auto& positions : found)
+        for(auto& position : positions) foundPositions.add(move(position));
+    return foundPositions;
 }
 
 Var Hexgrid::beside(int q, int r, int s){
@@ -93,7 +172,7 @@ Var Hexgrid::beside(int q, int r, int s){
         int r_ = r + get<1>(direction);
         int s_ = s + get<2>(direction);
         tuple<int, int, int> pos(q_, r_, s_);
-        if(cells.count(pos)){
+        if(data->pages ? data->pages->contains(pos) : data->cells.count(pos)){
             auto position = Array();
             position.add(q_);
             position.add(r_);
@@ -106,42 +185,79 @@ Var Hexgrid::beside(int q, int r, int s){
 }
 
 Var Hexgrid::remove(Var v){
+    requireCells();
     auto pos = arrayToTuple(v);
-    auto value = cells[pos];
+    auto cell = data->cells.find(pos);
+    if(cell == data->cells.end()) return Var();
+    auto& cells = data.edit().cells;
+    auto value = move(cells[pos]);
     cells.erase(pos);
     return value;
 }
 
-int Hexgrid::size(){
-    return cells.size();
+int Hexgrid::size() const {
+    return data->pages ? int(data->pages->size()) : int(data->cells.size());
 }
 
 std::string Hexgrid::toString()const{
-    string returnString="< ";
-    for(auto const& [pos, elem] : cells){
-        switch(elem.index()){
-            case 1: returnString+=to_string(get<int>(elem));
-                break;
-            case 2: returnString+=to_string(get<double>(elem));
-                break;
-            case 3: returnString+=get<string>(elem);
-                break;
-            case 4: returnString+=get<Array>(elem).toString();
-                break;
-            case 5: returnString+=get<Hexgrid>(elem).toString();
-                break;
-        }
-        returnString += " at [";
-        returnString += to_string(get<0>(pos)) + ", ";
-        returnString += to_string(get<1>(pos)) + ", ";
-        returnString += to_string(get<2>(pos)) + "], ";
+    ostringstream out;
+    {
+        OutputWriter writer(out);
+        write(writer);
     }
-    return returnString + ">";
+    return out.str();
+}
+
+void Hexgrid::write(OutputWriter& out) const {
+    out.write("< ");
+    forEach([&](const Position& pos, const Var& elem){
+        writeElement(out, elem);
+        out.write(" at [").write(get<0>(pos)).write(", ")
+           .write(get<1>(pos)).write(", ")
+           .write(get<2>(pos)).write("], ");
+    });
+    out.write('>');
+}
+
+const map<tuple<int, int, int>, Var>& Hexgrid::getCells() const {
+    requireCells();
+    return data->cells;
+}
+
+vector<Hexgrid::CellRange> Hexgrid::ranges(size_t parts) const {
+    requireCells();
+    auto const& cells = data->cells;
+    auto split = vector<CellRange>();
+    function<void(CellRange, size_t)> cut = [&](CellRange range, size_t count){
+        if(count <= 1 || range.first == range.second){
+            split.push_back(range);
+            return;
+        }
+        auto const& first = range.first->first;
+        auto const& last = prev(range.second)->first;
+        // Keys are ordered by q, then r, which settles s.
+        auto middle = [](int low, int high){ return int(low + (int64_t(high) - low) / 2 + 1); };
+        auto key = tuple<int, int, int>();
+        if(get<0>(first) != get<0>(last))
+            key = {middle(get<0>(first), get<0>(last)), numeric_limits<int>::min(), numeric_limits<int>::min()};
+        else if(get<1>(first) != get<1>(last))
+            key = {get<0>(first), middle(get<1>(first), get<1>(last)), numeric_limits<int>::min()};
+        else {
+            split.push_back(range);
+            return;
+        }
+        auto at = cells.lower_bound(key);
+        cut({range.first, at}, count / 2);
+        cut({at, range.second}, count - count / 2);
+    };
+    cut({cells.begin(), cells.end()}, max<size_t>(parts, 1));
+    return split;
 }
 
 vector<tuple<int, int, int>> Hexgrid::getKeys(){
+    requireCells();
     auto keys = vector<tuple<int, int, int>>();
-    for(auto const& [key, elem] : cells){
+    for(auto const& [key, elem] : data->cells){
         keys.push_back(key);
     }
     return keys;
@@ -216,6 +332,46 @@ Interpreter::Interpreter()
     returning=false;
 }
 
+void Interpreter::setOutputFormat(OutputFormat format){
+    outputFormat = format;
+}
+
+void Interpreter::setOutput(ostream& out){
+    output = &out;
+}
+
+void Interpreter::setThreads(unsigned count){
+    threads = count ? count : 1;
+    pool.reset();
+}
+
+void Interpreter::setPool(shared_ptr<ThreadPool> shared){
+    pool = move(shared);
+    threads = pool->size();
+}
+
+void Interpreter::recover(){
+    contextStack.assign(1, FunctionCallContext());
+    functionArgs.clear();
+    returning = false;
+    funcs.clear();
+}
+
+ThreadPool& Interpreter::getPool(){
+    if(!pool) pool = make_shared<ThreadPool>(threads);
+    return *pool;
+}
+
+ThreadPool::Stats Interpreter::getPoolStats() const {
+    return pool ? pool->getStats() : ThreadPool::Stats();
+}
+
+FunctionDefinition* Interpreter::findFunction(const string& name) const {
+    auto func = funcs.find(name);
+    if(func != funcs.end()) return func->second;
+    return parent ? parent->findFunction(name) : nullptr;
+}
+
 bool Interpreter::isGlobalscope(){
     return (contextStack.size() == 1 && contextStack[0].getScopeCount() == 0);
 }
@@ -249,7 +405,8 @@ bool Interpreter::containsVar(string name){
 }
 
 bool Interpreter::containsFun(string name){
-    return funcs.count(name);
+    return findFunction(name) || builtins().count(name) || callingBuiltins().count(name) ||
+           generators().count(name);
 }
 
 Var Interpreter::getValue(string name){
@@ -282,7 +439,9 @@ size_t Interpreter::getIndex(string name){
 }
 
 void Interpreter::visit(Program& p){
-    funcs.swap(p.funcs);
+    funcs.clear();
+    for(auto const& [name, func] : p.funcs) funcs[name] = func.get();
+    auto scope = PoolScope(threads, [this]() -> ThreadPool& { return getPool(); });
     for(auto const& stmnt: p.stmnts)
         stmnt->accept(*this);
 }
@@ -334,12 +493,13 @@ void Interpreter::visit(ArrayLiteral& arrLit){
 }
 
 void Interpreter::visit(HexgridLiteral& hexLit){
-    auto hex = Hexgrid();
+    auto cells = vector<pair<Position, Var>>();
+    cells.reserve(hexLit.cells.size());
     for(auto const& cell : hexLit.cells){
         cell->accept(*this);
-        hex.add(result2, result);
+        cells.emplace_back(Hexgrid::arrayToTuple(result2), move(result));
     }
-    result = hex;
+    result = Hexgrid::fromCells(move(cells));
 }
 
 void Interpreter::visit(HexgridCell& hexCell){
@@ -382,7 +542,7 @@ void Interpreter::visit(AddExpression& expr){
         [](int& l, double& r)               {l+=r;},
         [](double& l, int& r)               {l+=r;},
         [](double& l, double& r)            {l+=r;},
-        [](std::string& l, std::string& r)  {l+=r;},
+        [](Symbol& l, Symbol& r)            {l+=r;},
         [](auto&, auto&)                {throw std::runtime_error("type mismatch");},
     }, result, rvalue);
 }
@@ -461,7 +621,7 @@ void Interpreter::visit(EqualExpression& expr){
         [](int& res, double& l, double& r)  {res = int(l == r);},
         [](int& res, int& l, double& r)     {res = int(l == r);},
         [](int& res, double& l, int& r)     {res = int(l == r);},
-        [](int& res, string& l, string& r)  {res = int(l == r);},
+        [](int& res, Symbol& l, Symbol& r)  {res = int(l == r);},
         [](auto&, auto&, auto&)         {throw std::runtime_error("type mismatch");},
     }, result, lvalue, rvalue);
 }
@@ -476,7 +636,7 @@ void Interpreter::visit(NotEqualExpression& expr){
         [](int& res, double& l, double& r)  {res = int(l != r);},
         [](int& res, int& l, double& r)     {res = int(l != r);},
         [](int& res, double& l, int& r)     {res = int(l != r);},
-        [](int& res, string& l, string& r)  {res = int(l != r);},
+        [](int& res, Symbol& l, Symbol& r)  {res = int(l != r);},
         [](auto&, auto&, auto&)         {throw std::runtime_error("type mismatch");},
     }, result, lvalue, rvalue);
 
@@ -589,7 +749,7 @@ void Interpreter::visit(ByExpression& expr){
     auto hexgrid = result;
     expr.rvalue->accept(*this);
     if(hexgrid.index()==5)
-        result = get<Hexgrid>(hexgrid).by(result);
+        result = get<Hexgrid>(hexgrid).by(result, availableThreads());
 }
 
 void Interpreter::visit(BesideExpression& expr){
@@ -604,6 +764,45 @@ void Interpreter::visit(BesideExpression& expr){
     }
 }
 
+Var Interpreter::evaluateWithin(WithinExpression& expr, int& radius){
+    expr.grid->accept(*this);
+    auto hexgrid = result;
+    if(hexgrid.index()!=5) throw std::runtime_error("Can only search within hexgrid");
+    expr.radius->accept(*this);
+    if(result.index()!=1) throw std::runtime_error("Radius must be an integer");
+    radius = get<int>(result);
+    expr.center->accept(*this);
+    return hexgrid;
+}
+
+void Interpreter::visit(PathExpression& expr){
+    expr.source->accept(*this);
+    auto source = result;
+    expr.target->accept(*this);
+    auto target = result;
+    expr.grid->accept(*this);
+    if(result.index()!=5) throw std::runtime_error("Can only find path in hexgrid");
+    result = get<Hexgrid>(result).path(source, target);
+}
+
+void Interpreter::visit(VisibleExpression& expr){
+    expr.source->accept(*this);
+    if(!isPosition(result)) throw std::runtime_error("Position must be an array of 3 integers\n");
+    auto source = Hexgrid::arrayToTuple(result);
+    expr.target->accept(*this);
+    if(!isPosition(result)) throw std::runtime_error("Position must be an array of 3 integers\n");
+    auto target = Hexgrid::arrayToTuple(result);
+    expr.grid->accept(*this);
+    if(result.index()!=5) throw std::runtime_error("Can only check visibility in hexgrid");
+    result = int(get<Hexgrid>(result).visible(source, target));
+}
+
+void Interpreter::visit(WithinExpression& expr){
+    int radius;
+    auto hexgrid = evaluateWithin(expr, radius);
+    result = get<Hexgrid>(hexgrid).within(result, radius);
+}
+
 
 
 void Interpreter::visit(IfStatement& ifStmnt){
@@ -639,40 +838,54 @@ void Interpreter::visit(StatementBlock& statementBlock){
     result = {};
 }
 
+void Interpreter::iterate(ForeachStatement& foreachStatement, const Var& elem){
+    pushScope();
+    foreachStatement.iterator->accept(*this);
+    if(getIndex(lastDeclared) == elem.index()){
+        assign(lastDeclared, elem);
+        foreachStatement.statementBlock->accept(*this);
+    }
+    popScope();
+}
+
 void Interpreter::visit(ForeachStatement& foreachStatement){
-    foreachStatement.iterated->accept(*this);
+    forEachElement(*foreachStatement.iterated, [&](const Var& elem){
+        iterate(foreachStatement, elem);
+    });
+}
+
+void Interpreter::forEachElement(Node& iterated, const function<void(const Var&)>& each){
+    // Positions found by within and elements made by generators go straight
+    // to the loop, without an array.
+    if(auto within = dynamic_cast<WithinExpression*>(&iterated)){
+        int radius;
+        auto hexgrid = evaluateWithin(*within, radius);
+        auto& grid = get<Hexgrid>(hexgrid);
+        grid.within(grid.arrayToTuple(result), radius, [&](const Position& pos){
+            each(positionToArray(pos));
+        });
+        return;
+    }
+    auto call = dynamic_cast<FunctionCall*>(&iterated);
+    if(call && !findFunction(call->funcName) && generators().count(call->funcName)){
+        evaluateArgs(*call);
+        auto args = functionArgs;
+        generators().at(call->funcName)(args, each);
+        return;
+    }
+    iterated.accept(*this);
     if(result.index() == 4){
-        auto iterated = get<4>(result);
-        for(int i = 0; i<iterated.size(); i++){
-            pushScope();
-            auto elem = iterated.get(i);
-            foreachStatement.iterator->accept(*this);
-            if(getIndex(lastDeclared) == elem.index()){
-                assign(lastDeclared, elem);
-                foreachStatement.statementBlock->accept(*this);
-            }
-            popScope();
+        auto elements = get<4>(result);
+        for(int i = 0; i<elements.size(); i++){
+            each(elements.get(i));
         }
     } else if(result.index() == 5){
-        auto iterated = get<5>(result);
-        auto keys = iterated.getKeys();
-        for(size_t i = 0; i<keys.size();i++){
-            pushScope();
-            auto arr = Array();
-            arr.add(get<0>(keys[i]));
-            arr.add(get<1>(keys[i]));
-            arr.add(get<2>(keys[i]));
-            Var elem = arr;
-            foreachStatement.iterator->accept(*this);
-            if(getIndex(lastDeclared) == elem.index()){
-                assign(lastDeclared, elem);
-                foreachStatement.statementBlock->accept(*this);
-            }
-            popScope();
-        }
+        auto elements = get<5>(result);
+        elements.forEach([&](const Position& pos, const Var&){
+            each(positionToArray(pos));
+        });
     }
     else  throw std::runtime_error("Can only iterate array or hexgrid");
-
 }
 
 void Interpreter::visit(FunctionDefinition& funcDef){
@@ -686,27 +899,54 @@ void Interpreter::visit(FunctionDefinition& funcDef){
     popContext();
 }
 
-void Interpreter::visit(FunctionCall& funcCall){
+void Interpreter::evaluateArgs(FunctionCall& funcCall){
     functionArgs.clear();
     for(auto const& arg:funcCall.args){
         arg->accept(*this);
         functionArgs.push_back(result);
     }
-    funcs[funcCall.funcName]->accept(*this);
+}
+
+void Interpreter::visit(FunctionCall& funcCall){
+    evaluateArgs(funcCall);
+    if(auto func = findFunction(funcCall.funcName)){
+        func->accept(*this);
+        return;
+    }
+    auto builtin = builtins().find(funcCall.funcName);
+    if(builtin != builtins().end()){
+        result = builtin->second(functionArgs);
+        return;
+    }
+    auto calling = callingBuiltins().find(funcCall.funcName);
+    if(calling != callingBuiltins().end()){
+        auto args = functionArgs;
+        result = calling->second(args, [&](const string& name, vector<Var> callArgs){
+            return callFunction(name, move(callArgs));
+        });
+        return;
+    }
+    auto generator = generators().find(funcCall.funcName);
+    if(generator == generators().end()) throw hexgrid_errors::FunctionIsNotDefined(funcCall.funcName);
+    auto elements = Array();
+    generator->second(functionArgs, [&](const Var& elem){ elements.add(elem); });
+    result = elements;
+}
+
+Var Interpreter::callFunction(const string& name, vector<Var> args){
+    auto func = findFunction(name);
+    if(!func) throw hexgrid_errors::FunctionIsNotDefined(name);
+    functionArgs = move(args);
+    func->accept(*this);
+    return result;
 }
 
 void Interpreter::visit(ReturnStatement& returnStatement){
     if(returnStatement.expr) returnStatement.expr->accept(*this);
     else result = {};
     if(contextStack.size() == 1){
-        std::visit(overload{
-            [](int& res)        {cout << res << '\n';},
-            [](double& res)     {cout << res << '\n';},
-            [](string& res)     {cout << res << '\n';},
-            [](Array& res)      {cout << res.toString() << '\n';},
-            [](Hexgrid& res)    {cout << res.toString() << '\n';},
-            [](auto&)           {},
-        }, result);
+        OutputWriter out(*output);
+        writeValue(out, result, outputFormat);
     } else {
         returning=true;
     }
@@ -744,6 +984,22 @@ void Interpreter::visit(RemoveStatement& removeStatement){
     assign(removeStatement.grid->getName(), hexgrid);
 }
 
+void Interpreter::visit(SaveStatement& saveStatement){
+    saveStatement.grid->accept(*this);
+    auto grid = result;
+    if(grid.index()!=5) throw std::runtime_error("Can only save a hexgrid");
+    saveStatement.path->accept(*this);
+    if(result.index()!=3) throw std::runtime_error("File name must be text");
+    if(saveStatement.compressed) saveCompressedHexgrid(get<Hexgrid>(grid), get<Symbol>(result).str());
+    else saveHexgrid(get<Hexgrid>(grid), get<Symbol>(result).str());
+}
+
+void Interpreter::visit(LoadExpression& loadExpression){
+    loadExpression.path->accept(*this);
+    if(result.index()!=3) throw std::runtime_error("File name must be text");
+    result = loadHexgrid(get<Symbol>(result).str());
+}
+
 void Interpreter::visit(MoveStatement& moveStatement){
     moveStatement.grid_source->accept(*this);
     auto grid_source = result;
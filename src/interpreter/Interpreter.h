@@ -2,6 +2,8 @@
 #define TKOM_INTERPRETER_H
 
 #include <string>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <map>
 #include <vector>
@@ -13,12 +15,24 @@
 #include <HexgridErrors.h>
 #include <parser/Ast.h>
 #include <parser/Parser.h>
+#include "HexMath.h"
+#include "OutputWriter.h"
+#include "Parallel.h"
+#include "Shared.h"
+#include "Symbol.h"
+#include "ThreadPool.h"
 namespace intprt
 {
 
 class Array;
 class Hexgrid;
-using Var = std::variant<std::monostate, int, double, std::string, Array, Hexgrid>;
+class PagedGrid;
+using Var = std::variant<std::monostate, int, double, Symbol, Array, Hexgrid>;
+// What Hexgrid::neighbourhood makes of the six neighbours of a cell.
+enum class Reduction { Sum, Min, Max, Count };
+// Next value of a cell in a cellular automaton, from its value and the
+// number of its neighbours that are alive.
+using StepRule = std::function<Var(const Var& value, int alive)>;
 class Array
 {
 public:
@@ -27,8 +41,10 @@ public:
     void add(Var);
     int size() const;
     std::string toString() const;
+    void write(OutputWriter&) const;
 private:
-    std::vector<Var> values;
+    // Shared by copies until one of them changes.
+    Shared<std::vector<Var>> values;
 };
 class Hexgrid
 {
@@ -37,19 +53,103 @@ public:
     Var on(int, int, int);
     Var on(std::tuple<int, int, int>);
     Var beside(int, int, int) ;
-    Var by(Var);
+    // Positions of the cells at most radius steps from center, in the
+    // (q, r, s) order foreach visits a hexgrid in.
+    Var within(Var center, int radius);
+    void within(const Position& center, int radius,
+                const std::function<void(const Position&)>&) const;
+    // Cheapest path between two cells over occupied cells, both ends
+    // included, each step costing stepCost of the cell it enters. Empty
+    // when the target can't be reached.
+    Var path(Var source, Var target);
+    std::vector<Position> path(const Position& source, const Position& target) const;
+    // Whether no occupied cell lies on the line between two cells; the
+    // cells at its ends don't block it.
+    bool visible(const Position& source, const Position& target) const;
+    // Positions at most radius steps from observer that it can see, ring
+    // by ring outwards, found by shadow casting. Occupied cells block the
+    // view of what lies behind them, but are themselves seen.
+    void fieldOfView(const Position& observer, int radius,
+                     const std::function<void(const Position&)>&) const;
+    // Cells connected to seed through cells holding the same value as
+    // seed, or holding value when it is given; seed first, then in
+    // breadth-first order. Empty when seed is not occupied.
+    std::vector<Position> flood(const Position& seed) const;
+    std::vector<Position> flood(const Position& seed, const Var& value) const;
+    // The same cells, each holding the number of its connected region of
+    // equal values. Regions are numbered from 1 in foreach order.
+    Hexgrid components() const;
+    // The cells that can reach one of sources through occupied cells, each
+    // holding the number of steps to the closest one or, with nearest, its
+    // index in sources; the lower index on ties. Large frontiers are
+    // expanded on up to threads threads, with the same result.
+    Hexgrid distances(const std::vector<Position>& sources, bool nearest = false,
+                      unsigned threads = 1) const;
+    // The same cells, each holding the sum, the smallest or the largest of
+    // the values of its occupied neighbours, or how many there are. All
+    // but counts need numeric cells and give decimals when any cell holds
+    // one; cells without neighbours have no minimum or maximum and are
+    // left out of those.
+    Hexgrid neighbourhood(Reduction) const;
+    // The next generation of a cellular automaton: the same cells, each
+    // holding rule(value, n) where n counts its neighbours holding alive.
+    // Cells must hold numbers or text. rule is called once for each
+    // distinct value and count, on the calling thread; the cells are
+    // counted on up to threads threads.
+    Hexgrid step(const Var& alive, const StepRule& rule, unsigned threads = 1) const;
+    // Positions of the cells holding value, in storage order. Grids of
+    // parallelScanCells cells or more are scanned in ranges on up to
+    // threads threads, the ranges' results joined in order.
+    Var by(Var value, unsigned threads = 1);
+    static constexpr std::size_t parallelScanCells = 1 << 15;
+    using CellRange = std::pair<std::map<std::tuple<int, int, int>, Var>::const_iterator,
+                                std::map<std::tuple<int, int, int>, Var>::const_iterator>;
+    // Splits the cells into up to parts consecutive ranges in storage
+    // order. Cuts halve the span of keys, not of cells, so each costs one
+    // search of the tree; ranges may differ in size and some may be empty.
+    std::vector<CellRange> ranges(std::size_t parts) const;
     void add(Var, Var);
+    // A hexgrid of the given cells, sorted once and stored in order rather
+    // than added one by one; throws when a position is given twice.
+    static Hexgrid fromCells(std::vector<std::pair<Position, Var>> cells);
+    // Adds a cell after all the others, for building a hexgrid from cells
+    // already in storage order; false, adding nothing, when pos doesn't
+    // come after the last cell.
+    bool append(const Position& pos, Var value);
+    // A hexgrid reading its cells from a saved file as they are needed.
+    // Only on, beside, size, forEach and write work on it, and so do the
+    // output formats and saving, which walk it with forEach; the rest
+    // throw, as they would need all the cells at once.
+    static Hexgrid fromPages(std::shared_ptr<PagedGrid>);
+    PagedGrid* getPages() const;
+    // Every cell in storage order.
+    void forEach(const std::function<void(const Position&, const Var&)>&) const;
     Var remove(Var);
     std::string toString()const;
-    std::tuple<int, int, int> arrayToTuple(Var);
+    void write(OutputWriter&) const;
+    static std::tuple<int, int, int> arrayToTuple(Var);
     std::vector<std::tuple<int, int, int>> getKeys();
-    int size();
+    const std::map<std::tuple<int, int, int>, Var>& getCells() const;
+    int size() const;
 private:
-    std::map<std::tuple<int, int, int>, Var> cells;
-    std::vector<std::tuple<int, int, int>> directions = {
-        {0, -1, 1}, {0, 1, -1}, {1, 0, -1}, 
+    void requireCells() const;
+    // Shared by copies until one of them changes, so copying a hexgrid,
+    // and a value holding one, costs a reference count.
+    struct Storage;
+    Shared<Storage> data;
+    static constexpr Position directions[6] = {
+        {0, -1, 1}, {0, 1, -1}, {1, 0, -1},
         {-1, 0, 1}, {1, -1, 0}, {-1, 1, 0}};
 };
+struct Hexgrid::Storage
+{
+    std::map<std::tuple<int, int, int>, Var> cells;
+    // Read only, so shared by copies even after they change.
+    std::shared_ptr<PagedGrid> pages;
+    // Never above the cost of entering any cell, it is the path heuristic's
+    // cost per step. Only lowered, so removing cells keeps it valid.
+    double minStepCost = std::numeric_limits<double>::infinity();
+};
 
 
 class Scope
@@ -88,7 +188,9 @@ private:
 class Interpreter : public ast::AstVisitor
 {
 private: 
-    std::map<std::string, std::unique_ptr<ast::FunctionDefinition>> funcs;
+    // Those of the program being run, which stays as it was, so that
+    // several interpreters can run one program at once.
+    std::map<std::string, ast::FunctionDefinition*> funcs;
     std::vector<FunctionCallContext> contextStack;
     Scope globalScope;
     Var result;
@@ -96,9 +198,36 @@ private:
     std::string lastDeclared;
     std::vector<Var> functionArgs;
     bool returning;
+    OutputFormat outputFormat = OutputFormat::Text;
+    std::ostream* output = &std::cout;
+    unsigned threads = hardwareThreads();
+    // Unless set, started the first time parallel foreach or a built-in
+    // function has work for more than one thread; shared by those of the
+    // programs run.
+    std::shared_ptr<ThreadPool> pool;
+    // Set in the interpreters running the body of parallel foreach; user
+    // functions are looked up there, everything else is their own.
+    const Interpreter* parent = nullptr;
+
+    Interpreter(const Interpreter* parent);
+    ThreadPool& getPool();
 
 public:
     Interpreter();
+    void setOutputFormat(OutputFormat);
+    // Where top-level returns are written, std::cout by default.
+    void setOutput(std::ostream&);
+    // Threads of the pool parallel foreach and built-in functions use.
+    void setThreads(unsigned);
+    // Runs the parallel work on a pool shared with other interpreters.
+    void setPool(std::shared_ptr<ThreadPool>);
+    // Drops the calls and blocks a failed run left open, so the next run
+    // starts at the top level again; global variables stay.
+    void recover();
+    // Zeroed when there is no pool yet.
+    ThreadPool::Stats getPoolStats() const;
+    // The user function of that name, or null.
+    ast::FunctionDefinition* findFunction(const std::string& name) const;
     void declare(int, std::string);
     void assign(std::string);
     void assign(std::string, Var);
@@ -113,6 +242,17 @@ public:
     void popContext();
     size_t getIndex(std::string);
     bool isPosition(Var);
+    // Evaluates the operands of within and returns the grid, the center
+    // is left in result.
+    Var evaluateWithin(ast::WithinExpression&, int& radius);
+    // Evaluates the arguments of a call into functionArgs.
+    void evaluateArgs(ast::FunctionCall&);
+    // Calls the user function of that name and returns its result.
+    Var callFunction(const std::string& name, std::vector<Var> args);
+    // Hands each element of what foreach iterates over to each.
+    void forEachElement(ast::Node& iterated, const std::function<void(const Var&)>& each);
+    // Runs the body of foreach once, for elem.
+    void iterate(ast::ForeachStatement&, const Var& elem);
 
 
     void visit(ast::Program&) override;
@@ -138,6 +278,9 @@ public:
     void visit(ast::BesideExpression&) override;
     void visit(ast::ByExpression&) override;
     void visit(ast::OnExpression&) override;
+    void visit(ast::WithinExpression&) override;
+    void visit(ast::PathExpression&) override;
+    void visit(ast::VisibleExpression&) override;
     void visit(ast::AddExpression&) override;
     void visit(ast::SubtructExpression&) override;
     void visit(ast::MultiplyExpression&) override;
@@ -151,6 +294,9 @@ public:
     void visit(ast::AddStatement&) override;
     void visit(ast::ConditionBlock&) override;
     void visit(ast::ForeachStatement&) override;
+    void visit(ast::ParallelForeachStatement&) override;
+    void visit(ast::SaveStatement&) override;
+    void visit(ast::LoadExpression&) override;
     void visit(ast::IfStatement&) override;
     void visit(ast::MoveStatement&) override;
     void visit(ast::RemoveStatement&) override; 
@@ -158,6 +304,24 @@ public:
 };
 
 
+// Equality used by by, flood and components: numbers and text compare by
+// value, arrays and hexgrids never equal anything.
+bool sameValue(const Var&, const Var&);
+
+// Cost of entering a cell holding the value: the value itself when it is
+// a number, 1 otherwise. Cells with negative costs can't be entered.
+double stepCost(const Var&);
+
+// Interns text, which hexgrid cells hold interned only; other values are
+// left as they are.
+void internText(Var&);
+
+// [q, r, s] as an array of three integers.
+Array positionToArray(const Position&);
+
+// Writes a value nested in an array or a hexgrid.
+void writeElement(OutputWriter&, const Var&);
+
 template<class... Ts> struct overload : Ts... { using Ts::operator()...; };
 template<class... Ts> overload(Ts...) -> overload<Ts...>;
 
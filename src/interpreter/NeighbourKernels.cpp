@@ -0,0 +1,102 @@
+#include "Interpreter.h"
+#include "NeighbourTable.h"
+#include <algorithm>
+#include <limits>
+using namespace intprt;
+using namespace std;
+
+namespace{
+    // The cell values as one contiguous column, so the kernels below are
+    // plain loops over arrays the compiler can unroll and vectorize.
+    template<class T>
+    vector<T> column(const NeighbourTable& table){
+        auto values = vector<T>(table.size());
+        for(size_t cell = 0; cell < table.size(); cell++){
+            auto const& value = table.value(cell);
+            values[cell] = value.index() == 1 ? T(get<int>(value)) : T(get<double>(value));
+        }
+        return values;
+    }
+
+    // Folds the six neighbours of every cell; empty ones contribute
+    // identity, which keeps the inner loop free of branches.
+    template<class T, class Combine>
+    vector<T> reduceNeighbours(const NeighbourTable& table, const vector<T>& values,
+                               T identity, Combine combine){
+        auto reduced = vector<T>(table.size());
+        for(size_t cell = 0; cell < table.size(); cell++){
+            T folded = identity;
+            for(auto next : table.neighbours(cell))
+                folded = combine(folded, next == NeighbourTable::none ? identity : values[next]);
+            reduced[cell] = folded;
+        }
+        return reduced;
+    }
+
+    template<class T>
+    vector<T> reduceNeighbours(const NeighbourTable& table, Reduction reduction){
+        auto values = column<T>(table);
+        switch(reduction){
+            case Reduction::Min:
+                return reduceNeighbours(table, values, numeric_limits<T>::max(),
+                                        [](T a, T b){ return min(a, b); });
+            case Reduction::Max:
+                return reduceNeighbours(table, values, numeric_limits<T>::lowest(),
+                                        [](T a, T b){ return max(a, b); });
+            default:
+                return reduceNeighbours(table, values, T(0), [](T a, T b){ return a + b; });
+        }
+    }
+
+    const char* reductionName(Reduction reduction){
+        switch(reduction){
+            case Reduction::Sum: return "sum";
+            case Reduction::Min: return "min";
+            case Reduction::Max: return "max";
+            default: return "count";
+        }
+    }
+}
+
+Hexgrid Hexgrid::neighbourhood(Reduction reduction) const {
+    requireCells();
+    auto const& cells = data->cells;
+    auto table = NeighbourTable(*this);
+    auto counts = vector<int>(table.size());
+    for(size_t cell = 0; cell < table.size(); cell++)
+        for(auto next : table.neighbours(cell)) counts[cell] += next != NeighbourTable::none;
+    bool decimal = false;
+    if(reduction != Reduction::Count){
+        for(auto const& [pos, value] : cells){
+            if(value.index() == 2) decimal = true;
+            else if(value.index() != 1)
+                throw runtime_error(string("Neighbour ") + reductionName(reduction) + " needs numeric cells");
+        }
+    }
+    auto reduced = Hexgrid();
+    auto& stored = reduced.data.edit();
+    auto emit = [&](size_t cell, Var value){
+        auto cost = stepCost(value);
+        if(cost >= 0 && cost < stored.minStepCost) stored.minStepCost = cost;
+        stored.cells.emplace_hint(stored.cells.end(), table.position(cell), move(value));
+    };
+    // Cells without neighbours have no minimum or maximum.
+    bool needsNeighbours = reduction == Reduction::Min || reduction == Reduction::Max;
+    if(reduction == Reduction::Count){
+        for(size_t cell = 0; cell < table.size(); cell++) emit(cell, counts[cell]);
+    } else if(decimal){
+        auto values = reduceNeighbours<double>(table, reduction);
+        for(size_t cell = 0; cell < table.size(); cell++)
+            if(counts[cell] || !needsNeighbours) emit(cell, values[cell]);
+    } else {
+        // Six ints can't overflow a long long, but their sum may not fit an int.
+        auto values = reduceNeighbours<long long>(table, reduction);
+        for(size_t cell = 0; cell < table.size(); cell++){
+            if(!counts[cell] && needsNeighbours) continue;
+            if(values[cell] < numeric_limits<int>::min() || values[cell] > numeric_limits<int>::max())
+                throw runtime_error("Neighbour sum doesn't fit an integer");
+            emit(cell, int(values[cell]));
+        }
+    }
+    return reduced;
+}
@@ -0,0 +1,74 @@
+#include "NeighbourTable.h"
+#include <algorithm>
+using namespace intprt;
+using namespace std;
+
+// Cells are sorted by q and then r, so a cell's neighbours in its own row
+// are the cells just before and after it, and those in rows q-1 and q+1
+// are found by two cursors walking those rows alongside row q.
+NeighbourTable::NeighbourTable(const Hexgrid& grid){
+    auto const& cells = grid.getCells();
+    positions.reserve(cells.size());
+    values.reserve(cells.size());
+    for(auto const& [pos, value] : cells){
+        positions.push_back(&pos);
+        values.push_back(&value);
+    }
+    links.resize(positions.size());
+    auto q = [&](size_t i){ return (long long)get<0>(*positions[i]); };
+    auto r = [&](size_t i){ return (long long)get<1>(*positions[i]); };
+    auto rowEnd = [&](size_t start){
+        size_t end = start;
+        while(end < positions.size() && q(end) == q(start)) end++;
+        return end;
+    };
+    auto match = [&](size_t j, size_t end, long long wanted){
+        return j < end && r(j) == wanted ? uint32_t(j) : none;
+    };
+    size_t previousStart = 0, previousEnd = 0;
+    for(size_t start = 0, end; start < positions.size(); start = end){
+        end = rowEnd(start);
+        size_t nextEnd = rowEnd(end);
+        bool hasPrevious = start > 0 && q(start - 1) == q(start) - 1;
+        bool hasNext = end < positions.size() && q(end) == q(start) + 1;
+        size_t below = hasPrevious ? previousStart : previousEnd;
+        size_t belowEnd = previousEnd;
+        size_t above = hasNext ? end : nextEnd;
+        for(size_t i = start; i < end; i++){
+            auto& link = links[i];
+            link[0] = i > start && r(i - 1) == r(i) - 1 ? uint32_t(i - 1) : none;
+            link[1] = i + 1 < end && r(i + 1) == r(i) + 1 ? uint32_t(i + 1) : none;
+            while(below < belowEnd && r(below) < r(i)) below++;
+            link[2] = match(below, belowEnd, r(i));
+            link[3] = match(below + (link[2] != none), belowEnd, r(i) + 1);
+            while(above < nextEnd && r(above) < r(i) - 1) above++;
+            link[4] = match(above, nextEnd, r(i) - 1);
+            link[5] = match(above + (link[4] != none), nextEnd, r(i));
+        }
+        previousStart = start;
+        previousEnd = end;
+    }
+}
+
+size_t NeighbourTable::size() const {
+    return positions.size();
+}
+
+const Position& NeighbourTable::position(size_t cell) const {
+    return *positions[cell];
+}
+
+const Var& NeighbourTable::value(size_t cell) const {
+    return *values[cell];
+}
+
+const array<uint32_t, 6>& NeighbourTable::neighbours(size_t cell) const {
+    return links[cell];
+}
+
+uint32_t NeighbourTable::find(const Position& pos) const {
+    auto found = lower_bound(positions.begin(), positions.end(), pos,
+                             [](const Position* cell, const Position& wanted){ return *cell < wanted; });
+    if(found == positions.end() || **found != pos) return none;
+    return uint32_t(found - positions.begin());
+}
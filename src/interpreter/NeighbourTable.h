@@ -0,0 +1,41 @@
+#ifndef TKOM_NEIGHBOUR_TABLE_H
+#define TKOM_NEIGHBOUR_TABLE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Interpreter.h"
+
+namespace intprt
+{
+
+// The occupied cells of a hexgrid numbered 0, 1, ... in storage order,
+// each with the numbers of its occupied neighbours. Grid-wide kernels walk
+// these instead of looking every neighbour up in the map. It points into
+// the hexgrid, which must outlive it unchanged.
+class NeighbourTable
+{
+public:
+    static constexpr std::uint32_t none = UINT32_MAX;
+
+    explicit NeighbourTable(const Hexgrid&);
+
+    std::size_t size() const;
+    const Position& position(std::size_t cell) const;
+    const Var& value(std::size_t cell) const;
+    // Numbers of the neighbours [q, r-1], [q, r+1], [q-1, r], [q-1, r+1],
+    // [q+1, r-1] and [q+1, r] of a cell, none where they are empty.
+    const std::array<std::uint32_t, 6>& neighbours(std::size_t cell) const;
+    // Number of the cell at pos, none when it is empty.
+    std::uint32_t find(const Position& pos) const;
+
+private:
+    std::vector<const Position*> positions;
+    std::vector<const Var*> values;
+    std::vector<std::array<std::uint32_t, 6>> links;
+};
+
+} // namespace intprt
+
+#endif // TKOM_NEIGHBOUR_TABLE_H
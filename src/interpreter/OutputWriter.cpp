@@ -0,0 +1,97 @@
+#include "OutputWriter.h"
+#include <charconv>
+#include <cstring>
+using namespace intprt;
+using namespace std;
+
+namespace{
+    // Longest "%f" of a double: 309 integer digits, sign, point, 6 decimals.
+    const size_t maxNumberLength = 320;
+}
+
+OutputWriter::OutputWriter(ostream& out_, size_t capacity)
+: out(out_), buffer(capacity < maxNumberLength ? maxNumberLength : capacity) {}
+
+OutputWriter::~OutputWriter(){
+    flush();
+}
+
+char* OutputWriter::reserve(size_t n){
+    if(buffer.size() - used < n) flush();
+    return buffer.data() + used;
+}
+
+void OutputWriter::flush(){
+    if(used) out.write(buffer.data(), used);
+    used = 0;
+}
+
+OutputWriter& OutputWriter::write(char c){
+    *reserve(1) = c;
+    used++;
+    return *this;
+}
+
+OutputWriter& OutputWriter::write(string_view text){
+    if(text.size() > buffer.size()){
+        flush();
+        out.write(text.data(), text.size());
+        return *this;
+    }
+    text.copy(reserve(text.size()), text.size());
+    used += text.size();
+    return *this;
+}
+
+OutputWriter& OutputWriter::write(int value){
+    char* first = reserve(maxNumberLength);
+    used += to_chars(first, first + maxNumberLength, value).ptr - first;
+    return *this;
+}
+
+OutputWriter& OutputWriter::writeFixed(double value){
+    char* first = reserve(maxNumberLength);
+    used += to_chars(first, first + maxNumberLength, value, chars_format::fixed, 6).ptr - first;
+    return *this;
+}
+
+OutputWriter& OutputWriter::writeGeneral(double value){
+    char* first = reserve(maxNumberLength);
+    used += to_chars(first, first + maxNumberLength, value, chars_format::general, 6).ptr - first;
+    return *this;
+}
+
+OutputWriter& OutputWriter::writeShortest(double value){
+    char* first = reserve(maxNumberLength);
+    used += to_chars(first, first + maxNumberLength, value).ptr - first;
+    return *this;
+}
+
+OutputWriter& OutputWriter::writeLittleEndian(uint64_t value, size_t bytes){
+    char* first = reserve(bytes);
+    for(size_t i = 0; i < bytes; i++) first[i] = char((value >> (8 * i)) & 0xff);
+    used += bytes;
+    return *this;
+}
+
+OutputWriter& OutputWriter::writeUint8(uint8_t value){
+    return writeLittleEndian(value, 1);
+}
+
+OutputWriter& OutputWriter::writeInt32(int32_t value){
+    return writeLittleEndian(uint32_t(value), 4);
+}
+
+OutputWriter& OutputWriter::writeUint32(uint32_t value){
+    return writeLittleEndian(value, 4);
+}
+
+OutputWriter& OutputWriter::writeUint64(uint64_t value){
+    return writeLittleEndian(value, 8);
+}
+
+OutputWriter& OutputWriter::writeDouble(double value){
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof bits);
+    return writeLittleEndian(bits, 8);
+}
@@ -0,0 +1,57 @@
+#ifndef TKOM_OUTPUT_WRITER_H
+#define TKOM_OUTPUT_WRITER_H
+
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+namespace intprt
+{
+
+// How top-level return prints values: the human readable "< v at [q, r, s], >"
+// text, one JSON document per line, or length-prefixed binary frames.
+enum class OutputFormat { Text, Json, Binary };
+
+// Buffered writer for printed values. Text is collected in a fixed buffer
+// that is handed to the stream whenever it fills up, and numbers are
+// formatted with std::to_chars straight into it, so printing a value needs
+// no memory beyond the buffer however large the value is.
+class OutputWriter
+{
+public:
+    OutputWriter(std::ostream& out, size_t capacity = 1 << 16);
+    ~OutputWriter();
+    OutputWriter(const OutputWriter&) = delete;
+    OutputWriter& operator=(const OutputWriter&) = delete;
+
+    OutputWriter& write(char);
+    OutputWriter& write(std::string_view);
+    OutputWriter& write(int);
+    // Six decimal places, the format of std::to_string(double).
+    OutputWriter& writeFixed(double);
+    // Six significant digits, the default format of std::ostream.
+    OutputWriter& writeGeneral(double);
+    // Shortest text that reads back as the same double.
+    OutputWriter& writeShortest(double);
+
+    // Fixed-width little-endian binary.
+    OutputWriter& writeUint8(std::uint8_t);
+    OutputWriter& writeInt32(std::int32_t);
+    OutputWriter& writeUint32(std::uint32_t);
+    OutputWriter& writeUint64(std::uint64_t);
+    OutputWriter& writeDouble(double);
+    void flush();
+
+private:
+    char* reserve(size_t);
+    OutputWriter& writeLittleEndian(std::uint64_t, size_t bytes);
+
+    std::ostream& out;
+    std::vector<char> buffer;
+    size_t used = 0;
+};
+
+} // namespace intprt
+
+#endif // TKOM_OUTPUT_WRITER_H
@@ -0,0 +1,187 @@
+#include "PagedGrid.h"
+#include "CompressedGrid.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace intprt;
+using namespace std;
+
+namespace{
+    runtime_error corrupt(){
+        return runtime_error("Not a hexgrid file or a damaged one");
+    }
+}
+
+PagedGrid::PagedGrid(const string& path, size_t cachePages) : capacity(max<size_t>(cachePages, 1)) {
+    file = open(path.c_str(), O_RDONLY);
+    if(file < 0) throw runtime_error("Can't open " + path);
+    try {
+        struct stat status;
+        if(fstat(file, &status) < 0 || !S_ISREG(status.st_mode)) throw runtime_error("Can't page " + path);
+        unsigned char header[gridfile::headerSize] = {};
+        auto length = uint64_t(status.st_size);
+        if(length >= sizeof header) readAt(header, sizeof header, 0);
+        if(!memcmp(header, gridfile::compressedMagic, sizeof gridfile::compressedMagic))
+            throw runtime_error("Can't page a compressed hexgrid file, load it instead");
+        layout = gridfile::readHeader(header, length);
+        // The first cell of each page, to find the page holding a cell.
+        for(uint64_t cell = 0; cell < layout.cells; cell += cellsPerPage){
+            unsigned char q[4], r[4];
+            readAt(q, 4, layout.qColumn() + 4 * cell);
+            readAt(r, 4, layout.rColumn() + 4 * cell);
+            int q_ = int32_t(gridfile::readUint32(q)), r_ = int32_t(gridfile::readUint32(r));
+            auto first = Position(q_, r_, -q_ - r_);
+            if(!firstPositions.empty() && !(firstPositions.back() < first)) throw corrupt();
+            firstPositions.push_back(first);
+        }
+    } catch(...) {
+        close(file);
+        throw;
+    }
+}
+
+PagedGrid::~PagedGrid(){
+    close(file);
+}
+
+size_t PagedGrid::size() const {
+    return layout.cells;
+}
+
+bool PagedGrid::contains(const Position& pos){
+    auto index = pageOf(pos);
+    if(index == firstPositions.size()) return false;
+    auto const& positions = page(index)->positions;
+    return binary_search(positions.begin(), positions.end(), pos);
+}
+
+Var PagedGrid::on(const Position& pos){
+    auto index = pageOf(pos);
+    if(index == firstPositions.size()) throw runtime_error("No such cell");
+    auto found = page(index);
+    auto at = lower_bound(found->positions.begin(), found->positions.end(), pos);
+    if(at == found->positions.end() || *at != pos) throw runtime_error("No such cell");
+    return found->values[size_t(at - found->positions.begin())];
+}
+
+void PagedGrid::forEach(const function<void(const Position&, const Var&)>& each){
+    for(size_t index = 0; index < firstPositions.size(); index++){
+        // Held until its cells are visited, even if dropped from the cache.
+        auto current = page(index);
+        for(size_t i = 0; i < current->positions.size(); i++) each(current->positions[i], current->values[i]);
+    }
+}
+
+PagedGrid::Stats PagedGrid::getStats(){
+    auto guard = lock_guard<mutex>(lock);
+    auto stats = Stats();
+    stats.hits = hits;
+    stats.faults = faults;
+    stats.pages = firstPositions.size();
+    stats.cachedPages = cached.size();
+    return stats;
+}
+
+void PagedGrid::resetStats(){
+    auto guard = lock_guard<mutex>(lock);
+    hits = faults = 0;
+}
+
+size_t PagedGrid::pageOf(const Position& pos) const {
+    auto after = upper_bound(firstPositions.begin(), firstPositions.end(), pos);
+    if(after == firstPositions.begin()) return firstPositions.size();
+    return size_t(after - firstPositions.begin()) - 1;
+}
+
+shared_ptr<const PagedGrid::Page> PagedGrid::page(size_t index){
+    auto guard = lock_guard<mutex>(lock);
+    auto found = cached.find(index);
+    if(found != cached.end()){
+        hits++;
+        used.splice(used.begin(), used, found->second.use);
+        return found->second.page;
+    }
+    faults++;
+    // Read under the lock, so that threads missing the same page read it once.
+    auto loaded = read(index);
+    if(cached.size() >= capacity){
+        cached.erase(used.back());
+        used.pop_back();
+    }
+    used.push_front(index);
+    cached.emplace(index, Cached{loaded, used.begin()});
+    return loaded;
+}
+
+shared_ptr<const PagedGrid::Page> PagedGrid::read(size_t index) const {
+    uint64_t begin = uint64_t(index) * cellsPerPage;
+    size_t count = size_t(min<uint64_t>(cellsPerPage, layout.cells - begin));
+    auto qs = vector<unsigned char>(4 * count), rs = vector<unsigned char>(4 * count);
+    auto tags = vector<unsigned char>(count), raws = vector<unsigned char>(8 * count);
+    readAt(qs.data(), qs.size(), layout.qColumn() + 4 * begin);
+    readAt(rs.data(), rs.size(), layout.rColumn() + 4 * begin);
+    readAt(tags.data(), tags.size(), layout.tagColumn() + begin);
+    readAt(raws.data(), raws.size(), layout.valueColumn() + 8 * begin);
+    auto loaded = make_shared<Page>();
+    loaded->positions.reserve(count);
+    loaded->values.reserve(count);
+    // Each distinct string of the page is read once.
+    auto strings = unordered_map<uint64_t, Symbol>();
+    for(size_t i = 0; i < count; i++){
+        int q = int32_t(gridfile::readUint32(&qs[4 * i])), r = int32_t(gridfile::readUint32(&rs[4 * i]));
+        auto pos = Position(q, r, -q - r);
+        if(!loaded->positions.empty() && !(loaded->positions.back() < pos)) throw corrupt();
+        loaded->positions.push_back(pos);
+        auto raw = gridfile::readUint64(&raws[8 * i]);
+        auto value = Var();
+        switch(tags[i]){
+            case 0: break;
+            case 1: value = int(int64_t(raw)); break;
+            case 2: {
+                double number;
+                memcpy(&number, &raw, sizeof number);
+                value = number;
+                break;
+            }
+            case 3: {
+                if(raw >= layout.strings) throw corrupt();
+                auto known = strings.find(raw);
+                if(known == strings.end()){
+                    unsigned char offsets[16];
+                    readAt(offsets, sizeof offsets, layout.offsetColumn() + 8 * raw);
+                    auto start = gridfile::readUint64(offsets), end = gridfile::readUint64(offsets + 8);
+                    if(start > end || end > layout.stringBytes) throw corrupt();
+                    auto text = string(size_t(end - start), '\0');
+                    readAt(text.data(), text.size(), layout.stringData() + start);
+                    // Owned, so that the text goes with the page rather
+                    // than staying in the symbol table for good.
+                    known = strings.emplace(raw, Symbol::owned(move(text))).first;
+                }
+                value = known->second;
+                break;
+            }
+            default: throw corrupt();
+        }
+        loaded->values.push_back(move(value));
+    }
+    if(loaded->positions.front() != firstPositions[index] ||
+       (index + 1 < firstPositions.size() && !(loaded->positions.back() < firstPositions[index + 1])))
+        throw corrupt();
+    return loaded;
+}
+
+void PagedGrid::readAt(void* into, size_t length, uint64_t offset) const {
+    auto bytes = static_cast<char*>(into);
+    while(length){
+        auto got = pread(file, bytes, length, off_t(offset));
+        if(got < 0 && errno == EINTR) continue;
+        if(got <= 0) throw corrupt();
+        bytes += got;
+        length -= size_t(got);
+        offset += uint64_t(got);
+    }
+}
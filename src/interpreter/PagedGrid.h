@@ -0,0 +1,86 @@
+#ifndef TKOM_PAGED_GRID_H
+#define TKOM_PAGED_GRID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "GridFile.h"
+#include "Interpreter.h"
+
+namespace intprt
+{
+
+// The cells of a file written by save, read a page at a time. A page is
+// a run of cellsPerPage cells in storage order, so a region of whole
+// rows of the grid. At most cachePages pages are kept, the least
+// recently used one dropped for the next; only the first cell of each
+// page is held besides them. Text read from pages isn't interned, so it
+// is freed with them. Safe to use from several threads.
+class PagedGrid
+{
+public:
+    static constexpr std::size_t cellsPerPage = 4096;
+    static constexpr std::size_t defaultCachePages = 64;
+
+    struct Stats
+    {
+        // Lookups served by a cached page and those that read one.
+        std::uint64_t hits = 0;
+        std::uint64_t faults = 0;
+        std::size_t pages = 0;
+        std::size_t cachedPages = 0;
+    };
+
+    PagedGrid(const std::string& path, std::size_t cachePages);
+    ~PagedGrid();
+    PagedGrid(const PagedGrid&) = delete;
+    PagedGrid& operator=(const PagedGrid&) = delete;
+
+    std::size_t size() const;
+    bool contains(const Position&);
+    // Throws when there is no such cell.
+    Var on(const Position&);
+    // Every cell in storage order, a page at a time.
+    void forEach(const std::function<void(const Position&, const Var&)>&);
+
+    Stats getStats();
+    void resetStats();
+
+private:
+    struct Page
+    {
+        std::vector<Position> positions;
+        std::vector<Var> values;
+    };
+    // The page that would hold pos, or pages when it lies before them all.
+    std::size_t pageOf(const Position&) const;
+    std::shared_ptr<const Page> page(std::size_t);
+    std::shared_ptr<const Page> read(std::size_t) const;
+    void readAt(void* into, std::size_t length, std::uint64_t offset) const;
+
+    int file = -1;
+    gridfile::Layout layout;
+    std::size_t capacity;
+    std::vector<Position> firstPositions;
+    std::mutex lock;
+    // Most recently used first.
+    std::list<std::size_t> used;
+    struct Cached
+    {
+        std::shared_ptr<const Page> page;
+        std::list<std::size_t>::iterator use;
+    };
+    std::unordered_map<std::size_t, Cached> cached;
+    std::uint64_t hits = 0;
+    std::uint64_t faults = 0;
+};
+
+} // namespace intprt
+
+#endif // TKOM_PAGED_GRID_H
@@ -0,0 +1,62 @@
+#include "Parallel.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace intprt;
+using namespace std;
+
+unsigned intprt::hardwareThreads(){
+    auto count = thread::hardware_concurrency();
+    return count ? count : 1;
+}
+
+unsigned intprt::availableThreads(){
+    auto threads = ThreadPool::currentSize();
+    return threads ? threads : hardwareThreads();
+}
+
+void intprt::parallelChunks(size_t count, unsigned threads,
+                            const function<void(unsigned, size_t, size_t)>& body){
+    if(count == 0) return;
+    unsigned parts = unsigned(min<size_t>(max(threads, 1u), count));
+    auto chunk = [&](unsigned part){ return count * part / parts; };
+    if(parts == 1){
+        body(0, 0, count);
+        return;
+    }
+    if(auto pool = ThreadPool::current()){
+        pool->run(parts, [&](size_t part, unsigned){
+            body(unsigned(part), chunk(unsigned(part)), chunk(unsigned(part) + 1));
+        });
+        return;
+    }
+    auto failure = exception_ptr();
+    auto failureLock = mutex();
+    auto run = [&](unsigned part){
+        try {
+            body(part, chunk(part), chunk(part + 1));
+        } catch(...) {
+            auto lock = lock_guard<mutex>(failureLock);
+            if(!failure) failure = current_exception();
+        }
+    };
+    auto workers = vector<thread>();
+    for(unsigned part = 1; part < parts; part++) workers.emplace_back(run, part);
+    run(0);
+    for(auto& worker : workers) worker.join();
+    if(failure) rethrow_exception(failure);
+}
+
+void intprt::parallelTasks(size_t count, unsigned threads, const function<void(size_t)>& task){
+    auto pool = threads > 1 ? ThreadPool::current() : nullptr;
+    if(pool){
+        pool->run(count, [&](size_t i, unsigned){ task(i); });
+        return;
+    }
+    parallelChunks(count, threads, [&](unsigned, size_t begin, size_t end){
+        for(size_t i = begin; i < end; i++) task(i);
+    });
+}
@@ -0,0 +1,32 @@
+#ifndef TKOM_PARALLEL_H
+#define TKOM_PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+
+namespace intprt
+{
+
+// Number of threads the hardware runs at once, at least 1.
+unsigned hardwareThreads();
+
+// Size of the current thread pool, or hardwareThreads() without one.
+unsigned availableThreads();
+
+// Splits [0, count) into up to threads consecutive chunks and calls
+// body(part, begin, end) for each, as tasks of the current thread pool
+// or, without one, on threads started for them, the calling thread taking
+// the first. Returns when all are done; the first exception thrown is
+// rethrown.
+void parallelChunks(std::size_t count, unsigned threads,
+                    const std::function<void(unsigned part, std::size_t begin, std::size_t end)>& body);
+
+// Calls task(i) for every i in [0, count): each as a task of the current
+// thread pool, so idle threads steal them, or without one in up to threads
+// chunks as parallelChunks does.
+void parallelTasks(std::size_t count, unsigned threads,
+                   const std::function<void(std::size_t)>& task);
+
+} // namespace intprt
+
+#endif // TKOM_PARALLEL_H
@@ -0,0 +1,362 @@
+#include "Interpreter.h"
+#include "PagedGrid.h"
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <optional>
+using namespace intprt;
+using namespace ast;
+using namespace std;
+
+namespace{
+    using Reduced = ParallelForeachStatement::Reduced;
+    using Kind = ParallelForeachStatement::Reduction;
+
+    // Elements handed to a worker at a time. Chunks don't depend on the
+    // number of threads, so neither do the merged reductions.
+    constexpr size_t chunkSize = 256;
+    // Elements gathered before their chunks run, a page of a paged hexgrid.
+    constexpr size_t batchSize = PagedGrid::cellsPerPage;
+    static_assert(batchSize % chunkSize == 0, "batches must be whole chunks");
+
+    // Walks the body of a parallel foreach, and the user functions it
+    // calls, making sure it only changes variables it declares itself and
+    // the reduction variables. Sums and counts may only be added to, so
+    // that every chunk can start them from 0. Collects the variables the
+    // body reads from outside of it.
+    class SideEffectCheck : public AstVisitor
+    {
+    public:
+        SideEffectCheck(const Interpreter& interpreter_, const vector<Reduced>& reductions)
+        : interpreter(interpreter_) {
+            for(auto const& reduced : reductions) reductionOf[reduced.name] = reduced.reduction;
+        }
+
+        // The body of the loop; what it iterates over is evaluated before.
+        void check(ForeachStatement& loop){
+            scopes.emplace_back();
+            loop.iterator->accept(*this);
+            loop.statementBlock->accept(*this);
+            scopes.pop_back();
+        }
+
+        const set<string>& getReads() const {
+            return reads;
+        }
+
+        void visit(Program&) override {}
+        void visit(VariableDeclarationStatement& declaration) override {
+            scopes.back().insert(declaration.identifier);
+        }
+        void visit(ReturnStatement& statement) override {
+            if(!functionDepth) throw runtime_error("parallel foreach can't return");
+            if(statement.expr) statement.expr->accept(*this);
+        }
+        void visit(RemoveStatement& statement) override {
+            statement.position->accept(*this);
+            write(statement.grid->getName());
+        }
+        void visit(MoveStatement& statement) override {
+            statement.position_source->accept(*this);
+            if(statement.position_target) statement.position_target->accept(*this);
+            write(statement.grid_source->getName());
+            write(statement.grid_target->getName());
+        }
+        void visit(SaveStatement&) override {
+            throw runtime_error("parallel foreach can't save");
+        }
+        void visit(LoadExpression& expr) override { expr.path->accept(*this); }
+        void visit(IfStatement& statement) override {
+            statement.ifBlock->accept(*this);
+            for(auto const& block : statement.elifBlocks) block->accept(*this);
+            if(statement.elseBlock) statement.elseBlock->accept(*this);
+        }
+        void visit(ForeachStatement& loop) override {
+            loop.iterated->accept(*this);
+            check(loop);
+        }
+        void visit(ParallelForeachStatement& loop) override {
+            visit(static_cast<ForeachStatement&>(loop));
+        }
+        void visit(ConditionBlock& block) override {
+            block.condition->accept(*this);
+            block.statementBlock->accept(*this);
+        }
+        void visit(AddStatement& statement) override {
+            statement.being_added->accept(*this);
+            statement.added_at->accept(*this);
+            write(statement.added_to->getName());
+        }
+        void visit(InitializationStatement& initialization) override {
+            initialization.value->accept(*this);
+            scopes.back().insert(initialization.name);
+        }
+        void visit(AssignmentStatement& assignment) override {
+            auto reduction = outerReduction(assignment.name);
+            if(reduction == Kind::Sum || reduction == Kind::Count){
+                auto sum = dynamic_cast<AddExpression*>(assignment.value.get());
+                auto self = sum ? dynamic_cast<VariableReference*>(sum->lvalue.get()) : nullptr;
+                if(!self || self->getName() != assignment.name)
+                    throw runtime_error("parallel foreach can only add to " + assignment.name);
+                sum->rvalue->accept(*this);
+                return;
+            }
+            assignment.value->accept(*this);
+            write(assignment.name);
+        }
+        void visit(IndexingExpression& expr) override {
+            expr.indexOn->accept(*this);
+            expr.indexBy->accept(*this);
+        }
+        void visit(ArithmeticalNegation& expr) override { expr.value->accept(*this); }
+        void visit(LogicalNegation& expr) override { expr.value->accept(*this); }
+        void visit(ModuloExpression& expr) override { binary(expr); }
+        void visit(DivideExpression& expr) override { binary(expr); }
+        void visit(MultiplyExpression& expr) override { binary(expr); }
+        void visit(SubtructExpression& expr) override { binary(expr); }
+        void visit(AddExpression& expr) override { binary(expr); }
+        void visit(OnExpression& expr) override { binary(expr); }
+        void visit(WithinExpression& expr) override {
+            expr.grid->accept(*this);
+            expr.radius->accept(*this);
+            expr.center->accept(*this);
+        }
+        void visit(PathExpression& expr) override {
+            expr.source->accept(*this);
+            expr.target->accept(*this);
+            expr.grid->accept(*this);
+        }
+        void visit(VisibleExpression& expr) override { visit(static_cast<PathExpression&>(expr)); }
+        void visit(ByExpression& expr) override { binary(expr); }
+        void visit(BesideExpression& expr) override { binary(expr); }
+        void visit(NotEqualExpression& expr) override { binary(expr); }
+        void visit(EqualExpression& expr) override { binary(expr); }
+        void visit(GreaterOrEqualExpression& expr) override { binary(expr); }
+        void visit(GreaterExpression& expr) override { binary(expr); }
+        void visit(LessOrEqualExpression& expr) override { binary(expr); }
+        void visit(LessExpression& expr) override { binary(expr); }
+        void visit(AndExpression& expr) override { binary(expr); }
+        void visit(OrExpression& expr) override { binary(expr); }
+        void visit(ArrayLiteral& literal) override {
+            for(auto const& element : literal.elements) element->accept(*this);
+        }
+        void visit(HexgridCell& cell) override {
+            cell.value->accept(*this);
+            cell.pos->accept(*this);
+        }
+        void visit(HexgridLiteral& literal) override {
+            for(auto const& cell : literal.cells) cell->accept(*this);
+        }
+        void visit(DecimalLiteral&) override {}
+        void visit(IntegerLiteral&) override {}
+        void visit(TextLiteral&) override {}
+        void visit(VariableReference& reference) override {
+            auto const& name = reference.getName();
+            if(declared(name)) return;
+            auto reduction = outerReduction(name);
+            if(reduction == Kind::Sum || reduction == Kind::Count)
+                throw runtime_error("parallel foreach can't read " + name + " before the loop ends");
+            reads.insert(name);
+        }
+        void visit(FunctionCall& call) override {
+            for(auto const& arg : call.args) arg->accept(*this);
+            if(interpreter.findFunction(call.funcName)) checkFunction(call.funcName);
+            else if(call.funcName == "step") checkStepRule(call);
+        }
+        void visit(StatementBlock& block) override {
+            scopes.emplace_back();
+            for(auto const& statement : block.stmnts) statement->accept(*this);
+            scopes.pop_back();
+        }
+        void visit(FunctionDefinition& func) override {
+            for(size_t i = 0; i < func.getParamCount(); i++) func.declareParam(int(i), *this);
+            func.runStatementBlock(*this);
+        }
+
+    private:
+        void checkFunction(const string& name){
+            auto func = interpreter.findFunction(name);
+            if(!func || !checkedFunctions.insert(name).second) return;
+            // A function sees only its own variables as declared; what it
+            // reads from its callers is read from outside of the loop.
+            auto callerScopes = move(scopes);
+            scopes.assign(1, {});
+            functionDepth++;
+            func->accept(*this);
+            functionDepth--;
+            scopes = move(callerScopes);
+        }
+
+        // step(grid, "rule", alive) calls the user function named by its
+        // second argument, which must then be known before the loop runs.
+        void checkStepRule(FunctionCall& call){
+            if(call.args.size() < 2 || dynamic_cast<ArrayLiteral*>(call.args[1].get())) return;
+            auto rule = dynamic_cast<TextLiteral*>(call.args[1].get());
+            if(!rule) throw runtime_error("parallel foreach can only call step with a literal rule or literal counts");
+            checkFunction(rule->getValue());
+        }
+
+        void binary(BinaryExpression& expr){
+            expr.lvalue->accept(*this);
+            expr.rvalue->accept(*this);
+        }
+
+        bool declared(const string& name) const {
+            for(auto const& scope : scopes)
+                if(scope.count(name)) return true;
+            return false;
+        }
+
+        // The reduction of a variable the loop body itself changes, if any.
+        optional<Kind> outerReduction(const string& name) const {
+            if(declared(name)) return {};
+            auto found = reductionOf.find(name);
+            if(found == reductionOf.end()) return {};
+            return found->second;
+        }
+
+        void write(const string& name){
+            if(declared(name)) return;
+            if(functionDepth)
+                throw runtime_error("functions called from parallel foreach can't change " + name);
+            if(!reductionOf.count(name))
+                throw runtime_error("parallel foreach can't change " + name + ", it is not a reduction");
+        }
+
+        const Interpreter& interpreter;
+        map<string, Kind> reductionOf;
+        vector<set<string>> scopes;
+        set<string> reads;
+        set<string> checkedFunctions;
+        int functionDepth = 0;
+    };
+
+    Var combine(Kind reduction, const Var& merged, const Var& partial){
+        auto number = [](const Var& value){
+            return value.index() == 1 ? double(get<int>(value)) : get<double>(value);
+        };
+        switch(reduction){
+            case Kind::Min: return number(partial) < number(merged) ? partial : merged;
+            case Kind::Max: return number(partial) > number(merged) ? partial : merged;
+            default:
+                if(merged.index() == 1){
+                    // Taken wide, so that a sum not fitting an int throws
+                    // rather than wrapping by where the chunks were cut.
+                    auto sum = (long long)get<int>(merged) + get<int>(partial);
+                    if(sum < numeric_limits<int>::min() || sum > numeric_limits<int>::max())
+                        throw runtime_error("Reduction sum doesn't fit an integer");
+                    return int(sum);
+                }
+                return get<double>(merged) + get<double>(partial);
+        }
+    }
+}
+
+Interpreter::Interpreter(const Interpreter* parent_) : Interpreter() {
+    parent = parent_;
+    outputFormat = parent->outputFormat;
+    output = parent->output;
+}
+
+// The elements are gathered a batch at a time and cut into chunks, so a
+// paged hexgrid is walked a page at a time. Each pool thread runs chunks
+// on an interpreter of its own, holding copies of the variables the body
+// reads; sums and counts start every chunk at 0, minima and maxima at the
+// value before the loop. The chunk results are merged in
+// order, so the outcome doesn't depend on the number of threads; with one
+// thread the chunks run the same way on the calling thread.
+void Interpreter::visit(ParallelForeachStatement& loop){
+    auto check = SideEffectCheck(*this, loop.reductions);
+    check.check(loop);
+    for(auto const& reduced : loop.reductions){
+        auto index = getIndex(reduced.name);
+        if(index != 1 && index != 2)
+            throw runtime_error("Reduction variable " + reduced.name + " must be a number");
+        if(getValue(reduced.name).index() == 0)
+            throw runtime_error("Reduction variable " + reduced.name + " must be initialized");
+    }
+    if(parent){
+        visit(static_cast<ForeachStatement&>(loop));
+        return;
+    }
+    struct Snapshot { string name; size_t type; Var value; };
+    auto snapshot = vector<Snapshot>();
+    auto initial = vector<Var>();
+    auto merged = vector<Var>();
+    bool snapshotTaken = false;
+    // Taken once the iterated value is evaluated, as foreach would see them.
+    auto takeSnapshot = [&]{
+        if(snapshotTaken) return;
+        snapshotTaken = true;
+        for(auto const& name : check.getReads())
+            if(containsVar(name)) snapshot.push_back({name, getIndex(name), getValue(name)});
+        for(auto const& reduced : loop.reductions){
+            initial.push_back(getValue(reduced.name));
+            snapshot.push_back({reduced.name, getIndex(reduced.name), initial.back()});
+        }
+        merged = initial;
+    };
+
+    // Every chunk is a task of the pool; a thread that ran out of chunks
+    // steals from the others. Interpreters are kept per slot. A thread
+    // waiting inside a built-in function may start another chunk, which
+    // then gets an interpreter of its own. Threads outside of the pool all
+    // run as slot 0, so the lists are locked.
+    struct Idle { mutex lock; vector<unique_ptr<Interpreter>> interpreters; };
+    auto idle = vector<Idle>(threads);
+    auto elements = vector<Var>();
+    auto partials = vector<vector<Var>>();
+    auto runChunk = [&](size_t chunk, unsigned slot){
+        auto worker = unique_ptr<Interpreter>();
+        {
+            auto lock = lock_guard<mutex>(idle[slot].lock);
+            if(!idle[slot].interpreters.empty()){
+                worker = move(idle[slot].interpreters.back());
+                idle[slot].interpreters.pop_back();
+            }
+        }
+        if(!worker){
+            worker.reset(new Interpreter(this));
+            for(auto const& variable : snapshot){
+                if(worker->containsVar(variable.name)) continue;
+                worker->declare(int(variable.type), variable.name);
+                worker->assign(variable.name, variable.value);
+            }
+        }
+        for(size_t i = 0; i < loop.reductions.size(); i++){
+            auto reduction = loop.reductions[i].reduction;
+            bool fromZero = reduction == Kind::Sum || reduction == Kind::Count;
+            auto start = !fromZero ? initial[i]
+                       : initial[i].index() == 1 ? Var(0) : Var(0.0);
+            worker->assign(loop.reductions[i].name, start);
+        }
+        auto last = min(elements.size(), (chunk + 1) * chunkSize);
+        for(size_t i = chunk * chunkSize; i < last; i++) worker->iterate(loop, elements[i]);
+        for(auto const& reduced : loop.reductions)
+            partials[chunk].push_back(worker->getValue(reduced.name));
+        auto lock = lock_guard<mutex>(idle[slot].lock);
+        idle[slot].interpreters.push_back(move(worker));
+    };
+    // Runs the elements gathered so far. Batches are whole chunks, so the
+    // chunks are those all of the elements at once would make.
+    auto runBatch = [&]{
+        size_t chunks = (elements.size() + chunkSize - 1) / chunkSize;
+        partials.assign(chunks, {});
+        if(threads > 1) getPool().run(chunks, runChunk);
+        else for(size_t chunk = 0; chunk < chunks; chunk++) runChunk(chunk, 0);
+        for(size_t i = 0; i < loop.reductions.size(); i++)
+            for(auto const& partial : partials)
+                merged[i] = combine(loop.reductions[i].reduction, merged[i], partial[i]);
+        elements.clear();
+    };
+    forEachElement(*loop.iterated, [&](const Var& elem){
+        takeSnapshot();
+        elements.push_back(elem);
+        if(elements.size() == batchSize) runBatch();
+    });
+    takeSnapshot();
+    if(!elements.empty()) runBatch();
+    for(size_t i = 0; i < loop.reductions.size(); i++)
+        assign(loop.reductions[i].name, merged[i]);
+}
+
@@ -0,0 +1,108 @@
+#include "Interpreter.h"
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <unordered_map>
+using namespace intprt;
+using namespace std;
+
+namespace{
+    // What the search knows about a position. Every position is looked up
+    // in the grid once; empty ones are remembered as walls.
+    struct Visit
+    {
+        double step;
+        double cost;
+        Position previous;
+        bool closed;
+    };
+
+    struct Candidate
+    {
+        double estimate;
+        double cost;
+        Position pos;
+    };
+
+    // Lowest estimate first. Among equal estimates the one further along
+    // wins, which keeps A* from widening across plateaus of equal cost,
+    // and positions break the remaining ties so paths are deterministic.
+    struct Later
+    {
+        bool operator()(const Candidate& a, const Candidate& b) const {
+            if(a.estimate != b.estimate) return a.estimate > b.estimate;
+            if(a.cost != b.cost) return a.cost < b.cost;
+            return a.pos > b.pos;
+        }
+    };
+}
+
+double intprt::stepCost(const Var& value){
+    switch(value.index()){
+        case 1: return get<int>(value);
+        case 2: return get<double>(value);
+        default: return 1;
+    }
+}
+
+Var Hexgrid::path(Var source, Var target){
+    auto positions = Array();
+    for(auto const& pos : path(arrayToTuple(source), arrayToTuple(target)))
+        positions.add(positionToArray(pos));
+    return positions;
+}
+
+// A* with a binary heap. The heuristic, hexDistance times the cheapest
+// step, never overestimates, so the first time the target is taken off
+// the heap its cost is optimal. With free (zero cost) cells it is zero
+// and the search is Dijkstra's.
+vector<Position> Hexgrid::path(const Position& source, const Position& target) const {
+    requireCells();
+    auto const& cells = data->cells;
+    auto found = vector<Position>();
+    auto start = cells.find(source);
+    auto goal = cells.find(target);
+    if(start == cells.end() || goal == cells.end() || stepCost(goal->second) < 0) return found;
+
+    auto visits = unordered_map<Position, Visit, PositionHash>();
+    auto open = priority_queue<Candidate, vector<Candidate>, Later>();
+    auto heuristic = [&](const Position& pos){
+        return data->minStepCost > 0 && isfinite(data->minStepCost) ? hexDistance(pos, target) * data->minStepCost : 0.0;
+    };
+    const double unreached = numeric_limits<double>::infinity();
+    visits[source] = Visit{stepCost(start->second), 0, source, false};
+    open.push(Candidate{heuristic(source), 0, source});
+    while(!open.empty()){
+        auto current = open.top();
+        open.pop();
+        auto& visit = visits[current.pos];
+        if(visit.closed || current.cost > visit.cost) continue;
+        visit.closed = true;
+        if(current.pos == target) break;
+        for(auto const& direction : directions){
+            auto next = Position(get<0>(current.pos) + get<0>(direction),
+                                 get<1>(current.pos) + get<1>(direction),
+                                 get<2>(current.pos) + get<2>(direction));
+            auto [seen, added] = visits.try_emplace(next, Visit{-1, unreached, next, false});
+            auto& neighbour = seen->second;
+            if(added){
+                auto cell = cells.find(next);
+                if(cell != cells.end()) neighbour.step = stepCost(cell->second);
+            }
+            if(neighbour.step < 0 || neighbour.closed) continue;
+            double cost = current.cost + neighbour.step;
+            if(neighbour.cost <= cost) continue;
+            neighbour.cost = cost;
+            neighbour.previous = current.pos;
+            open.push(Candidate{cost + heuristic(next), cost, next});
+        }
+    }
+    auto reached = visits.find(target);
+    if(reached == visits.end() || !reached->second.closed) return found;
+    for(auto pos = target; ; pos = visits[pos].previous){
+        found.push_back(pos);
+        if(pos == source) break;
+    }
+    reverse(found.begin(), found.end());
+    return found;
+}
@@ -0,0 +1,107 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+using namespace intprt;
+using namespace std;
+
+namespace{
+    const size_t noNode = numeric_limits<size_t>::max();
+
+    double toMilliseconds(Profiler::Clock::duration d){
+        return chrono::duration<double, milli>(d).count();
+    }
+
+    string locationText(pair<int, int> start, pair<int, int> end){
+        return to_string(start.first) + ":" + to_string(start.second) + "-" +
+               to_string(end.first) + ":" + to_string(end.second);
+    }
+}
+
+void Profiler::enter(const char* kind, const ast::Node& node){
+    auto index = recordFor(kind, node);
+    auto& record = records[index];
+    record.stats.hits++;
+    record.active++;
+    auto callSite = callSiteFor(index);
+    stack.push_back(Frame{index, callSite, Clock::now(), Clock::duration::zero()});
+}
+
+void Profiler::leave(){
+    auto frame = stack.back();
+    stack.pop_back();
+    auto elapsed = Clock::now() - frame.start;
+    auto self = elapsed - frame.children;
+    auto& record = records[frame.node];
+    record.stats.exclusive += self;
+    if(--record.active == 0) record.stats.inclusive += elapsed;
+    callTree[frame.callSite].self += self;
+    if(!stack.empty()) stack.back().children += elapsed;
+}
+
+size_t Profiler::recordFor(const char* kind, const ast::Node& node){
+    auto found = recordIndex.find(&node);
+    if(found != recordIndex.end()) return found->second;
+    NodeRecord record;
+    record.stats.kind = kind;
+    record.stats.start = node.getStart();
+    record.stats.end = node.getEnd();
+    records.push_back(record);
+    recordIndex[&node] = records.size() - 1;
+    return records.size() - 1;
+}
+
+size_t Profiler::callSiteFor(size_t node){
+    if(callTree.empty()) callTree.push_back(CallSite{noNode, noNode, {}, Clock::duration::zero()});
+    size_t parent = stack.empty() ? 0 : stack.back().callSite;
+    auto found = callTree[parent].children.find(node);
+    if(found != callTree[parent].children.end()) return found->second;
+    callTree.push_back(CallSite{node, parent, {}, Clock::duration::zero()});
+    callTree[parent].children[node] = callTree.size() - 1;
+    return callTree.size() - 1;
+}
+
+vector<Profiler::NodeStats> Profiler::getStats() const {
+    auto stats = vector<NodeStats>();
+    for(auto const& record : records) stats.push_back(record.stats);
+    stable_sort(stats.begin(), stats.end(), [](const NodeStats& a, const NodeStats& b){
+        if(a.inclusive != b.inclusive) return a.inclusive > b.inclusive;
+        return a.start < b.start;
+    });
+    return stats;
+}
+
+void Profiler::writeReport(ostream& out) const {
+    out << setw(14) << "inclusive(ms)" << setw(14) << "exclusive(ms)"
+        << setw(12) << "hits" << "  " << left << setw(24) << "location"
+        << "node\n" << right;
+    out << fixed << setprecision(3);
+    for(auto const& stats : getStats()){
+        out << setw(14) << toMilliseconds(stats.inclusive)
+            << setw(14) << toMilliseconds(stats.exclusive)
+            << setw(12) << stats.hits << "  "
+            << left << setw(24) << locationText(stats.start, stats.end)
+            << stats.kind << '\n' << right;
+    }
+}
+
+string Profiler::frameName(size_t node) const {
+    auto const& stats = records[node].stats;
+    return string(stats.kind) + "(" + to_string(stats.start.first) + ":" +
+           to_string(stats.start.second) + ")";
+}
+
+void Profiler::writeCollapsedStacks(ostream& out) const {
+    for(size_t i = 1; i < callTree.size(); i++){
+        auto micros = chrono::duration_cast<chrono::microseconds>(callTree[i].self).count();
+        if(micros <= 0) continue;
+        auto frames = vector<string>();
+        for(size_t site = i; site != 0; site = callTree[site].parent)
+            frames.push_back(frameName(callTree[site].node));
+        for(auto frame = frames.rbegin(); frame != frames.rend(); frame++){
+            if(frame != frames.rbegin()) out << ';';
+            out << *frame;
+        }
+        out << ' ' << micros << '\n';
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef TKOM_PROFILER_H
+#define TKOM_PROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <parser/Ast.h>
+#include "InstrumentedInterpreter.h"
+
+namespace intprt
+{
+
+// Collects hit counts and wall time per AST node while listening to an
+// InstrumentedInterpreter. Inclusive time of a node includes its children,
+// exclusive time does not. Recursive re-entries are counted once in the
+// inclusive time of the outermost activation.
+class Profiler : public ExecutionListener
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct NodeStats
+    {
+        const char* kind;
+        std::pair<int, int> start;
+        std::pair<int, int> end;
+        std::uint64_t hits = 0;
+        Clock::duration inclusive = Clock::duration::zero();
+        Clock::duration exclusive = Clock::duration::zero();
+    };
+
+    void enter(const char* kind, const ast::Node&) override;
+    void leave() override;
+
+    // Stats of every visited node, sorted by descending inclusive time.
+    std::vector<NodeStats> getStats() const;
+    // Human readable table of getStats().
+    void writeReport(std::ostream&) const;
+    // One "frame;frame;frame microseconds" line per distinct call stack,
+    // the format consumed by flamegraph.pl and speedscope.
+    void writeCollapsedStacks(std::ostream&) const;
+
+private:
+    struct NodeRecord
+    {
+        NodeStats stats;
+        int active = 0;
+    };
+
+    struct CallSite
+    {
+        size_t node;
+        size_t parent;
+        std::map<size_t, size_t> children;
+        Clock::duration self = Clock::duration::zero();
+    };
+
+    struct Frame
+    {
+        size_t node;
+        size_t callSite;
+        Clock::time_point start;
+        Clock::duration children;
+    };
+
+    size_t recordFor(const char* kind, const ast::Node&);
+    size_t callSiteFor(size_t node);
+    std::string frameName(size_t node) const;
+
+    std::unordered_map<const ast::Node*, size_t> recordIndex;
+    std::vector<NodeRecord> records;
+    std::vector<CallSite> callTree;
+    std::vector<Frame> stack;
+};
+
+} // namespace intprt
+
+#endif // TKOM_PROFILER_H
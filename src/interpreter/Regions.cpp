@@ -0,0 +1,109 @@
+#include "Interpreter.h"
+#include <deque>
+#include <numeric>
+#include <unordered_set>
+using namespace intprt;
+using namespace std;
+
+bool intprt::sameValue(const Var& a, const Var& b){
+    if(a.index() != b.index()) return false;
+    switch(a.index()){
+        case 0: return true;
+        case 1: return get<int>(a) == get<int>(b);
+        case 2: return get<double>(a) == get<double>(b);
+        case 3: return get<Symbol>(a) == get<Symbol>(b);
+        default: return false;
+    }
+}
+
+vector<Position> Hexgrid::flood(const Position& seed) const {
+    requireCells();
+    auto const& cells = data->cells;
+    auto cell = cells.find(seed);
+    if(cell == cells.end()) return {};
+    return flood(seed, cell->second);
+}
+
+vector<Position> Hexgrid::flood(const Position& seed, const Var& value) const {
+    requireCells();
+    auto const& cells = data->cells;
+    auto region = vector<Position>();
+    if(!cells.count(seed)) return region;
+    auto seen = unordered_set<Position, PositionHash>{seed};
+    auto queue = deque<Position>{seed};
+    while(!queue.empty()){
+        auto pos = queue.front();
+        queue.pop_front();
+        region.push_back(pos);
+        for(auto const& direction : directions){
+            auto next = Position(get<0>(pos) + get<0>(direction),
+                                 get<1>(pos) + get<1>(direction),
+                                 get<2>(pos) + get<2>(direction));
+            if(!seen.insert(next).second) continue;
+            auto cell = cells.find(next);
+            if(cell != cells.end() && sameValue(cell->second, value)) queue.push_back(next);
+        }
+    }
+    return region;
+}
+
+// Union-find over one pass of the cells in storage order. Cells are sorted
+// by q and then r, so of the three neighbours that come before a cell,
+// [q, r-1] is the cell just before it and [q-1, r], [q-1, r+1] are found by
+// a cursor that walks row q-1 alongside row q. No lookups are needed.
+Hexgrid Hexgrid::components() const {
+    requireCells();
+    auto const& cells = data->cells;
+    auto positions = vector<const Position*>();
+    auto values = vector<const Var*>();
+    positions.reserve(cells.size());
+    values.reserve(cells.size());
+    for(auto const& [pos, value] : cells){
+        positions.push_back(&pos);
+        values.push_back(&value);
+    }
+    auto parent = vector<size_t>(positions.size());
+    iota(parent.begin(), parent.end(), 0);
+    auto find = [&](size_t i){
+        while(parent[i] != i) i = parent[i] = parent[parent[i]];
+        return i;
+    };
+    // The smaller index becomes the root, so a root is its region's first cell.
+    auto unite = [&](size_t a, size_t b){
+        if(!sameValue(*values[a], *values[b])) return;
+        a = find(a);
+        b = find(b);
+        if(a < b) parent[b] = a;
+        else if(b < a) parent[a] = b;
+    };
+    auto q = [&](size_t i){ return (long long)get<0>(*positions[i]); };
+    auto r = [&](size_t i){ return (long long)get<1>(*positions[i]); };
+    size_t rowStart = 0, previousRowStart = 0, previousRowEnd = 0, cursor = 0;
+    for(size_t i = 0; i < positions.size(); i++){
+        if(i == 0 || q(i) != q(i - 1)){
+            if(i > 0 && q(i) == q(i - 1) + 1){
+                previousRowStart = rowStart;
+                previousRowEnd = i;
+            } else {
+                previousRowStart = previousRowEnd = i;
+            }
+            rowStart = i;
+            cursor = previousRowStart;
+        } else if(r(i - 1) == r(i) - 1){
+            unite(i - 1, i);
+        }
+        while(cursor < previousRowEnd && r(cursor) < r(i)) cursor++;
+        for(size_t j = cursor; j < previousRowEnd && r(j) <= r(i) + 1; j++) unite(j, i);
+    }
+    auto labels = Hexgrid();
+    auto& stored = labels.data.edit();
+    auto label = vector<int>(positions.size(), 0);
+    int regions = 0;
+    for(size_t i = 0; i < positions.size(); i++){
+        auto root = find(i);
+        if(!label[root]) label[root] = ++regions;
+        stored.cells.emplace_hint(stored.cells.end(), *positions[i], label[root]);
+    }
+    if(regions) stored.minStepCost = 1;
+    return labels;
+}
@@ -0,0 +1,152 @@
+#include "Server.h"
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <lexer/Lexer.h>
+#include <parser/Parser.h>
+using namespace intprt;
+using namespace std;
+
+namespace{
+    runtime_error systemError(const string& what){
+        return runtime_error(what + ": " + strerror(errno));
+    }
+
+    using Clock = chrono::steady_clock;
+
+    enum class Reading { Ended, TimedOut, Stopped, Failed };
+
+    // Reads the request into request until the client ends it, unless it
+    // doesn't in time, the server is stopped meanwhile or reading fails.
+    Reading readRequest(int client, int wake, chrono::milliseconds timeout, string& request){
+        auto deadline = Clock::now() + timeout;
+        char buffer[1 << 16];
+        while(true){
+            auto left = chrono::duration_cast<chrono::milliseconds>(deadline - Clock::now()).count();
+            if(left <= 0) return Reading::TimedOut;
+            pollfd waiting[2] = {{client, POLLIN, 0}, {wake, POLLIN, 0}};
+            int ready = poll(waiting, 2, int(left));
+            if(ready < 0 && errno == EINTR) continue;
+            if(ready < 0) return Reading::Failed;
+            if(waiting[1].revents) return Reading::Stopped;
+            if(ready == 0) continue;
+            auto got = read(client, buffer, sizeof buffer);
+            if(got < 0 && errno == EINTR) continue;
+            if(got < 0) return Reading::Failed;
+            if(got == 0) return Reading::Ended;
+            request.append(buffer, size_t(got));
+        }
+    }
+
+    void writeAll(int client, const string& reply){
+        size_t sent = 0;
+        while(sent < reply.size()){
+            // A client gone early mustn't kill the server with SIGPIPE.
+            auto written = send(client, reply.data() + sent, reply.size() - sent, MSG_NOSIGNAL);
+            if(written < 0 && errno == EINTR) continue;
+            if(written <= 0) return;
+            sent += size_t(written);
+        }
+    }
+}
+
+Server::Server(const string& socketPath_, chrono::milliseconds timeout_)
+: socketPath(socketPath_), timeout(timeout_) {
+    auto address = sockaddr_un();
+    address.sun_family = AF_UNIX;
+    if(socketPath.size() >= sizeof address.sun_path)
+        throw runtime_error("Socket path too long: " + socketPath);
+    strncpy(address.sun_path, socketPath.c_str(), sizeof address.sun_path - 1);
+    // The destructor doesn't run when the constructor throws.
+    auto failure = [&](const string& what){
+        auto error = systemError(what);
+        for(int fd : {listening, wakeRead, wakeWrite})
+            if(fd >= 0) close(fd);
+        return error;
+    };
+    int wake[2];
+    if(pipe(wake) < 0) throw failure("pipe");
+    wakeRead = wake[0];
+    wakeWrite = wake[1];
+    fcntl(wakeWrite, F_SETFL, O_NONBLOCK);
+    listening = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(listening < 0) throw failure("socket");
+    if(bind(listening, reinterpret_cast<sockaddr*>(&address), sizeof address) < 0)
+        throw failure("Can't bind " + socketPath);
+    if(listen(listening, 64) < 0){
+        auto error = failure("listen");
+        unlink(socketPath.c_str());
+        throw error;
+    }
+}
+
+Server::~Server(){
+    close(listening);
+    close(wakeRead);
+    close(wakeWrite);
+    unlink(socketPath.c_str());
+}
+
+Interpreter& Server::getInterpreter(){
+    return interpreter;
+}
+
+void Server::serve(){
+    while(true){
+        pollfd waiting[2] = {{listening, POLLIN, 0}, {wakeRead, POLLIN, 0}};
+        if(poll(waiting, 2, -1) < 0){
+            if(errno == EINTR) continue;
+            throw systemError("poll");
+        }
+        if(waiting[1].revents) return;
+        int client = accept(listening, nullptr, nullptr);
+        if(client < 0) continue;
+        answer(client);
+        close(client);
+    }
+}
+
+void Server::stop(){
+    char byte = 0;
+    // Nothing to do when full, serve() is woken already.
+    [[maybe_unused]] auto written = write(wakeWrite, &byte, 1);
+}
+
+void Server::answer(int client){
+    // A client that stops reading can't hold up the others either.
+    auto microseconds = chrono::duration_cast<chrono::microseconds>(timeout).count();
+    auto limit = timeval{time_t(microseconds / 1000000), suseconds_t(microseconds % 1000000)};
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &limit, sizeof limit);
+    auto request = string();
+    switch(readRequest(client, wakeRead, timeout, request)){
+        case Reading::Ended: writeAll(client, handle(request)); break;
+        case Reading::TimedOut: writeAll(client, "error: the request wasn't ended in time\n"); break;
+        case Reading::Stopped: writeAll(client, "error: the server is stopping\n"); break;
+        // The connection is broken, there is no one to answer.
+        case Reading::Failed: break;
+    }
+}
+
+string Server::handle(const string& script){
+    auto reply = ostringstream();
+    interpreter.setOutput(reply);
+    try {
+        auto source = istringstream(script);
+        auto program = parser::Parser(make_unique<lexer::Lexer>(source)).parse();
+        program->accept(interpreter);
+        interpreter.recover();
+    } catch(const exception& e) {
+        interpreter.recover();
+        reply = ostringstream();
+        reply << "error: " << e.what() << "\n";
+    }
+    interpreter.setOutput(cout);
+    return reply.str();
+}
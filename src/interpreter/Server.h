@@ -0,0 +1,53 @@
+#ifndef TKOM_SERVER_H
+#define TKOM_SERVER_H
+
+#include <chrono>
+#include <string>
+#include "Interpreter.h"
+
+namespace intprt
+{
+
+// Runs scripts sent over a Unix domain socket on one resident interpreter,
+// so global variables, hexgrids loaded once above all, stay between
+// requests; functions last for the request defining them. A request is
+// the script text, ended by the client shutting down its writing side.
+// The reply is what the script returns, or "error: " and the message when
+// it fails, after which the connection is closed. Requests run one at a
+// time, in the order they connect, so a client must end its request
+// within a timeout; one that doesn't is answered with an error instead,
+// as is one still being read when the server is stopped.
+class Server
+{
+public:
+    // Listens on socketPath, which must not exist yet.
+    explicit Server(const std::string& socketPath,
+                    std::chrono::milliseconds timeout = std::chrono::seconds(10));
+    ~Server();
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    Interpreter& getInterpreter();
+    // Answers requests until stop() is called.
+    void serve();
+    // Safe to call from other threads and signal handlers.
+    void stop();
+    // Runs one request and returns its reply.
+    std::string handle(const std::string& script);
+
+private:
+    void answer(int client);
+
+    std::string socketPath;
+    // For reading a request and for writing its reply each.
+    std::chrono::milliseconds timeout;
+    int listening = -1;
+    // stop() writes to the one end, serve() waits on the other too.
+    int wakeRead = -1;
+    int wakeWrite = -1;
+    Interpreter interpreter;
+};
+
+} // namespace intprt
+
+#endif // TKOM_SERVER_H
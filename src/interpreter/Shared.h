@@ -0,0 +1,68 @@
+#ifndef TKOM_SHARED_H
+#define TKOM_SHARED_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace intprt
+{
+
+// A value kept on the heap behind one pointer and shared by its copies
+// until one of them is changed: copying counts a reference, and edit()
+// first copies a value that is shared. The count is atomic, so copies
+// can be made and dropped on several threads. An empty one holds no
+// allocation and reads as a default T.
+template<typename T>
+class Shared
+{
+public:
+    Shared() = default;
+    Shared(const Shared& other) : box(other.box) {
+        if(box) box->references.fetch_add(1, std::memory_order_relaxed);
+    }
+    Shared(Shared&& other) noexcept : box(other.box) {
+        other.box = nullptr;
+    }
+    Shared& operator=(Shared other) noexcept {
+        std::swap(box, other.box);
+        return *this;
+    }
+    ~Shared(){
+        if(box && box->references.fetch_sub(1, std::memory_order_acq_rel) == 1) delete box;
+    }
+
+    const T& operator*() const {
+        return box ? box->value : empty();
+    }
+    const T* operator->() const {
+        return &**this;
+    }
+    // The value, for changing it without changing the copies.
+    T& edit(){
+        if(!box) box = new Box();
+        else if(box->references.load(std::memory_order_acquire) != 1) *this = Shared(new Box(box->value));
+        return box->value;
+    }
+
+private:
+    struct Box
+    {
+        Box() = default;
+        explicit Box(const T& value_) : value(value_) {}
+        std::atomic<std::size_t> references{1};
+        T value;
+    };
+    explicit Shared(Box* box_) : box(box_) {}
+
+    static const T& empty(){
+        static const T value{};
+        return value;
+    }
+
+    Box* box = nullptr;
+};
+
+} // namespace intprt
+
+#endif // TKOM_SHARED_H
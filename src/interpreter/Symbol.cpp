@@ -0,0 +1,133 @@
+#include "Symbol.h"
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+using namespace intprt;
+using namespace std;
+
+namespace{
+    // Strings by number, in chunks doubling in size so that a string never
+    // moves once stored: reading one needs no lock, as its number can only
+    // have been handed out after it was stored. Numbers are found through
+    // shards of a hash map, each behind a lock of its own.
+    class SymbolTable
+    {
+    public:
+        static SymbolTable& instance(){
+            static SymbolTable table;
+            return table;
+        }
+
+        uint32_t intern(string_view text){
+            auto hashed = hash<string_view>()(text);
+            auto& shard = shards[hashed % shardCount];
+            auto guard = lock_guard<mutex>(shard.lock);
+            auto found = shard.numbers.find(text);
+            if(found != shard.numbers.end()) return found->second;
+            auto number = store(text, hashed);
+            shard.numbers.emplace(get(number).text, number);
+            return number;
+        }
+
+        struct Entry
+        {
+            string text;
+            size_t hash = 0;
+        };
+
+        const Entry& get(uint32_t number) const {
+            uint64_t chunk = 63 - __builtin_clzll(uint64_t(number) / firstChunk + 1);
+            return chunks[chunk][number - firstChunk * ((uint64_t(1) << chunk) - 1)];
+        }
+
+        size_t count() const {
+            return stored.load();
+        }
+
+    private:
+        static constexpr uint64_t firstChunk = 1024;
+        static constexpr size_t shardCount = 16;
+
+        SymbolTable(){
+            intern("");
+        }
+
+        uint32_t store(string_view text, size_t hashed){
+            auto guard = lock_guard<mutex>(growing);
+            uint64_t number = stored.load();
+            if(number > numeric_limits<uint32_t>::max()) throw runtime_error("Too many distinct strings");
+            uint64_t chunk = 63 - __builtin_clzll(number / firstChunk + 1);
+            if(!chunks[chunk]) chunks[chunk] = make_unique<Entry[]>(firstChunk << chunk);
+            chunks[chunk][number - firstChunk * ((uint64_t(1) << chunk) - 1)] = Entry{string(text), hashed};
+            stored.store(number + 1);
+            return uint32_t(number);
+        }
+
+        struct Shard
+        {
+            mutex lock;
+            unordered_map<string_view, uint32_t> numbers;
+        };
+        Shard shards[shardCount];
+        mutex growing;
+        unique_ptr<Entry[]> chunks[23];
+        atomic<uint64_t> stored{0};
+    };
+}
+
+struct Symbol::Owned
+{
+    atomic<size_t> references{1};
+    string text;
+};
+
+Symbol::Symbol(string_view text) : word(uintptr_t(SymbolTable::instance().intern(text)) << 1 | 1) {}
+
+Symbol::Symbol(const string& text) : Symbol(string_view(text)) {}
+
+Symbol::Symbol(const char* text) : Symbol(string_view(text)) {}
+
+Symbol Symbol::owned(string text){
+    auto symbol = Symbol();
+    symbol.word = reinterpret_cast<uintptr_t>(new Owned{{1}, move(text)});
+    return symbol;
+}
+
+void Symbol::retain() const {
+    reinterpret_cast<Owned*>(word)->references.fetch_add(1, memory_order_relaxed);
+}
+
+void Symbol::release(){
+    auto owned = reinterpret_cast<Owned*>(word);
+    if(owned->references.fetch_sub(1, memory_order_acq_rel) == 1) delete owned;
+}
+
+const string& Symbol::str() const {
+    if(isInterned()) return SymbolTable::instance().get(uint32_t(word >> 1)).text;
+    return reinterpret_cast<const Owned*>(word)->text;
+}
+
+Symbol Symbol::interned() const {
+    return isInterned() ? *this : Symbol(string_view(str()));
+}
+
+size_t Symbol::hash() const {
+    if(isInterned()) return SymbolTable::instance().get(uint32_t(word >> 1)).hash;
+    return std::hash<string_view>()(str());
+}
+
+Symbol& Symbol::operator+=(const Symbol& other){
+    *this = owned(str() + other.str());
+    return *this;
+}
+
+size_t Symbol::count(){
+    return SymbolTable::instance().count();
+}
+
+ostream& intprt::operator<<(ostream& out, const Symbol& symbol){
+    return out << symbol.str();
+}
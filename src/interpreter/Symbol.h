@@ -0,0 +1,84 @@
+#ifndef TKOM_SYMBOL_H
+#define TKOM_SYMBOL_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace intprt
+{
+
+// Text held by a value, in one of two forms. An interned symbol is the
+// number of its string in a table shared by all interpreters, where each
+// distinct string is stored once and kept for the life of the process:
+// copying it never touches the characters and comparing two of them is
+// an integer compare. Text from scripts, files and hexgrid cells is
+// interned. Text built by joining strings has a counted string of its own
+// instead, freed with the last symbol holding it, so building ever new
+// strings doesn't grow the table; it is interned once stored in a cell.
+// Pages of grids opened with open hold such text too, so that walking
+// them doesn't keep every string read.
+// Interning and copying are safe from several threads.
+class Symbol
+{
+public:
+    // The empty string.
+    Symbol() = default;
+    Symbol(std::string_view);
+    Symbol(const std::string&);
+    Symbol(const char*);
+    // Text of its own, not interned.
+    static Symbol owned(std::string);
+
+    Symbol(const Symbol& other) : word(other.word) {
+        if(!isInterned()) retain();
+    }
+    Symbol(Symbol&& other) noexcept : word(other.word) {
+        other.word = 1;
+    }
+    Symbol& operator=(Symbol other) noexcept {
+        std::swap(word, other.word);
+        return *this;
+    }
+    ~Symbol(){
+        if(!isInterned()) release();
+    }
+
+    const std::string& str() const;
+    std::size_t size() const { return str().size(); }
+    bool isInterned() const { return word & 1; }
+    // The same text, interned.
+    Symbol interned() const;
+    // The number of the interned text, interning it first if need be.
+    std::uint32_t id() const { return isInterned() ? std::uint32_t(word >> 1) : interned().id(); }
+    // Equal for equal text, in either form.
+    std::size_t hash() const;
+    // Joins into text of its own.
+    Symbol& operator+=(const Symbol&);
+
+    friend bool operator==(const Symbol& a, const Symbol& b) {
+        if(a.word == b.word) return true;
+        if(a.isInterned() && b.isInterned()) return false;
+        return a.str() == b.str();
+    }
+    friend bool operator!=(const Symbol& a, const Symbol& b) { return !(a == b); }
+
+    // How many distinct strings have been interned.
+    static std::size_t count();
+
+private:
+    struct Owned;
+    void retain() const;
+    void release();
+
+    // The interned number shifted left with the lowest bit set, or the
+    // address of an Owned string.
+    std::uintptr_t word = 1;
+};
+
+std::ostream& operator<<(std::ostream&, const Symbol&);
+
+} // namespace intprt
+
+#endif // TKOM_SYMBOL_H
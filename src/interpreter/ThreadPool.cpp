@@ -0,0 +1,214 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <iomanip>
+using namespace intprt;
+using namespace std;
+
+namespace{
+    using Clock = chrono::steady_clock;
+
+    // The pool whose thread this is and its slot in it.
+    thread_local ThreadPool* workerOf = nullptr;
+    thread_local unsigned workerSlot = 0;
+    // The innermost PoolScope.
+    thread_local PoolScope* scoped = nullptr;
+}
+
+struct ThreadPool::Batch
+{
+    const function<void(size_t, unsigned)>* task;
+    atomic<size_t> remaining;
+    mutex failureLock;
+    exception_ptr failure;
+};
+
+struct ThreadPool::Task
+{
+    Batch* batch;
+    size_t index;
+    unsigned owner;
+};
+
+struct ThreadPool::Queue
+{
+    mutex lock;
+    deque<Task> tasks;
+};
+
+// Apart, so that threads counting don't share cache lines.
+struct alignas(64) ThreadPool::Counters
+{
+    atomic<uint64_t> tasks{0};
+    atomic<uint64_t> steals{0};
+    atomic<uint64_t> busyNanoseconds{0};
+};
+
+double ThreadPool::Stats::utilization() const {
+    if(threads == 0 || elapsedSeconds <= 0) return 0;
+    return busySeconds / (threads * elapsedSeconds);
+}
+
+void ThreadPool::Stats::write(ostream& out) const {
+    out << fixed << setprecision(3)
+        << "threads      " << threads << "\n"
+        << "tasks        " << tasks << "\n"
+        << "steals       " << steals << "\n"
+        << "busy         " << busySeconds << " s\n"
+        << "elapsed      " << elapsedSeconds << " s\n"
+        << setprecision(1)
+        << "utilization  " << utilization() * 100 << "%\n";
+}
+
+ThreadPool::ThreadPool(unsigned threads) : statsStart(Clock::now()) {
+    threads = max(threads, 1u);
+    for(unsigned slot = 0; slot < threads; slot++){
+        queues.push_back(make_unique<Queue>());
+        counters.push_back(make_unique<Counters>());
+    }
+    for(unsigned slot = 1; slot < threads; slot++)
+        workers.emplace_back([this, slot]{ work(slot); });
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        auto lock = lock_guard<mutex>(sleepLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for(auto& worker : workers) worker.join();
+}
+
+unsigned ThreadPool::size() const {
+    return unsigned(queues.size());
+}
+
+ThreadPool* ThreadPool::current(){
+    if(!scoped) return workerOf;
+    if(!scoped->pool) scoped->pool = &scoped->start();
+    return scoped->pool;
+}
+
+unsigned ThreadPool::currentSize(){
+    if(scoped) return scoped->pool ? scoped->pool->size() : scoped->threads;
+    return workerOf ? workerOf->size() : 0;
+}
+
+unsigned ThreadPool::slotOfCaller() const {
+    return workerOf == this ? workerSlot : 0;
+}
+
+void ThreadPool::run(size_t count, const function<void(size_t, unsigned)>& task){
+    if(count == 0) return;
+    auto batch = Batch{&task, {count}, {}, {}};
+    unsigned slot = slotOfCaller();
+    {
+        auto lock = lock_guard<mutex>(queues[slot]->lock);
+        // Last first, so that this thread, taking from the back, starts
+        // with the first task and thieves with the last.
+        for(size_t i = count; i-- > 0;) queues[slot]->tasks.push_back(Task{&batch, i, slot});
+    }
+    queued += count;
+    { auto lock = lock_guard<mutex>(sleepLock); }
+    wake.notify_all();
+    while(batch.remaining.load(memory_order_acquire)){
+        if(runQueued(slot)) continue;
+        // Nothing to take while others run the rest: sleep as the workers
+        // do, until a task is queued or the last of these is done.
+        auto lock = unique_lock<mutex>(sleepLock);
+        wake.wait(lock, [&]{ return queued > 0 || !batch.remaining.load(memory_order_acquire); });
+    }
+    if(batch.failure) rethrow_exception(batch.failure);
+}
+
+bool ThreadPool::runQueued(unsigned slot){
+    auto task = Task{};
+    bool found = false;
+    {
+        auto& own = *queues[slot];
+        auto lock = lock_guard<mutex>(own.lock);
+        if(!own.tasks.empty()){
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            found = true;
+        }
+    }
+    for(size_t i = 1; !found && i < queues.size(); i++){
+        auto& victim = *queues[(slot + i) % queues.size()];
+        auto lock = lock_guard<mutex>(victim.lock);
+        if(!victim.tasks.empty()){
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            found = true;
+        }
+    }
+    if(!found) return false;
+    queued--;
+    auto start = Clock::now();
+    try {
+        (*task.batch->task)(task.index, slot);
+    } catch(...) {
+        auto lock = lock_guard<mutex>(task.batch->failureLock);
+        if(!task.batch->failure) task.batch->failure = current_exception();
+    }
+    auto& counted = *counters[slot];
+    counted.tasks++;
+    if(task.owner != slot) counted.steals++;
+    counted.busyNanoseconds += uint64_t(chrono::duration_cast<chrono::nanoseconds>(Clock::now() - start).count());
+    // Last, the batch may be gone as soon as it reaches 0.
+    if(task.batch->remaining.fetch_sub(1, memory_order_release) == 1){
+        // The thread that queued it may be asleep in run().
+        { auto lock = lock_guard<mutex>(sleepLock); }
+        wake.notify_all();
+    }
+    return true;
+}
+
+void ThreadPool::work(unsigned slot){
+    workerOf = this;
+    workerSlot = slot;
+    while(true){
+        if(runQueued(slot)) continue;
+        auto lock = unique_lock<mutex>(sleepLock);
+        wake.wait(lock, [&]{ return stopping || queued > 0; });
+        if(stopping && queued == 0) return;
+    }
+}
+
+ThreadPool::Stats ThreadPool::getStats() const {
+    auto stats = Stats();
+    stats.threads = size();
+    uint64_t busy = 0;
+    for(auto const& counted : counters){
+        stats.tasks += counted->tasks;
+        stats.steals += counted->steals;
+        busy += counted->busyNanoseconds;
+    }
+    stats.busySeconds = busy * 1e-9;
+    stats.elapsedSeconds = chrono::duration<double>(Clock::now() - statsStart).count();
+    return stats;
+}
+
+void ThreadPool::resetStats(){
+    for(auto& counted : counters){
+        counted->tasks = 0;
+        counted->steals = 0;
+        counted->busyNanoseconds = 0;
+    }
+    statsStart = Clock::now();
+}
+
+PoolScope::PoolScope(ThreadPool& pool_)
+: pool(&pool_), threads(pool_.size()), previous(scoped) {
+    scoped = this;
+}
+
+PoolScope::PoolScope(unsigned threads_, function<ThreadPool&()> start_)
+: pool(nullptr), threads(max(threads_, 1u)), start(move(start_)), previous(scoped) {
+    scoped = this;
+}
+
+PoolScope::~PoolScope(){
+    scoped = previous;
+}
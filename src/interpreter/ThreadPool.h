@@ -0,0 +1,111 @@
+#ifndef TKOM_THREAD_POOL_H
+#define TKOM_THREAD_POOL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+namespace intprt
+{
+
+// A fixed set of threads running tasks. Every thread has a deque of its
+// own, pushing and popping tasks at its back; a thread with nothing to do
+// steals from the front of another's. A thread waiting for the tasks it
+// started runs queued tasks meanwhile, so tasks may start tasks too, and
+// sleeps when there are none.
+// Threads outside of the pool share one more deque and count as one of
+// its threads, so a pool of n threads starts n - 1.
+class ThreadPool
+{
+public:
+    struct Stats
+    {
+        unsigned threads = 0;
+        std::uint64_t tasks = 0;
+        // Tasks run by another thread than the one that queued them.
+        std::uint64_t steals = 0;
+        double busySeconds = 0;
+        double elapsedSeconds = 0;
+        // Share of the time the threads spent running tasks.
+        double utilization() const;
+        void write(std::ostream&) const;
+    };
+
+    explicit ThreadPool(unsigned threads);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const;
+    // Calls task(i, slot) for every i in [0, count) and returns when all
+    // are done; slot is the number, below size(), of the thread running
+    // it. Threads outside of the pool all run tasks as slot 0, so tasks
+    // of one slot may run at once when several of them share the pool.
+    // The first exception thrown is rethrown.
+    void run(std::size_t count, const std::function<void(std::size_t, unsigned)>& task);
+
+    // Counted since the pool started or the last reset.
+    Stats getStats() const;
+    void resetStats();
+
+    // The pool the calling thread belongs to, or the one a PoolScope set
+    // for it, started now if it was left to be; null otherwise.
+    static ThreadPool* current();
+    // Threads of the pool current() would return, without starting it;
+    // 0 without one.
+    static unsigned currentSize();
+
+private:
+    struct Batch;
+    struct Task;
+    struct Queue;
+    struct Counters;
+
+    void work(unsigned slot);
+    bool runQueued(unsigned slot);
+    unsigned slotOfCaller() const;
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::unique_ptr<Counters>> counters;
+    std::vector<std::thread> workers;
+    std::atomic<std::size_t> queued{0};
+    bool stopping = false;
+    std::mutex sleepLock;
+    std::condition_variable wake;
+    std::chrono::steady_clock::time_point statsStart;
+
+    friend class PoolScope;
+};
+
+// Makes a pool the current one of the calling thread while it lives.
+class PoolScope
+{
+public:
+    explicit PoolScope(ThreadPool&);
+    // The pool of threads threads is got from start the first time
+    // current() asks for it, so that work that stays on one thread
+    // starts none.
+    PoolScope(unsigned threads, std::function<ThreadPool&()> start);
+    ~PoolScope();
+    PoolScope(const PoolScope&) = delete;
+    PoolScope& operator=(const PoolScope&) = delete;
+private:
+    ThreadPool* pool;
+    unsigned threads;
+    std::function<ThreadPool&()> start;
+    PoolScope* previous;
+
+    friend class ThreadPool;
+};
+
+} // namespace intprt
+
+#endif // TKOM_THREAD_POOL_H
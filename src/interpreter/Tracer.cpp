@@ -0,0 +1,105 @@
+#include "Tracer.h"
+#include <cstring>
+#include <iomanip>
+using namespace intprt;
+using namespace std;
+
+namespace{
+    string escapeJson(const string& text){
+        string escaped;
+        for(char c : text){
+            switch(c){
+                case '"':  escaped += "\\\""; break;
+                case '\\': escaped += "\\\\"; break;
+                case '\n': escaped += "\\n";  break;
+                default:   escaped += c;
+            }
+        }
+        return escaped;
+    }
+
+    // Name of the hexgrid query a node kind evaluates, if it is one.
+    const char* queryName(const char* kind){
+        static const pair<const char*, const char*> queries[] = {
+            {"OnExpression", "on"}, {"ByExpression", "by"},
+            {"BesideExpression", "beside"}, {"WithinExpression", "within"},
+            {"PathExpression", "path"}, {"VisibleExpression", "visible"}};
+        for(auto const& [node, name] : queries)
+            if(!strcmp(kind, node)) return name;
+        return nullptr;
+    }
+
+    string locationText(pair<int, int> loc){
+        return to_string(loc.first) + ":" + to_string(loc.second);
+    }
+}
+
+Tracer::Tracer() : origin(Clock::now()) {}
+
+void Tracer::begin(string name, const char* category){
+    stack.push_back(Frame{true, false, move(name), category, {0, 0}, Clock::now()});
+}
+
+void Tracer::end(){
+    auto frame = move(stack.back());
+    stack.pop_back();
+    if(!frame.traced) return;
+    auto finish = Clock::now();
+    events.push_back(Event{
+        move(frame.name), frame.category,
+        sinceOrigin(frame.start),
+        chrono::duration<double, micro>(finish - frame.start).count(),
+        frame.location});
+}
+
+void Tracer::enter(const char* kind, const ast::Node& node){
+    auto frame = Frame{false, false, "", nullptr, node.getStart(), Clock::now()};
+    if(!strcmp(kind, "Program")){
+        frame = Frame{true, true, "run", "interpreter", node.getStart(), frame.start};
+    } else if(!strcmp(kind, "FunctionCall")){
+        auto const& call = static_cast<const ast::FunctionCall&>(node);
+        frame.traced = true;
+        frame.name = "call " + call.funcName;
+        frame.category = "call";
+    } else if(auto query = queryName(kind)){
+        frame.traced = true;
+        frame.name = query;
+        frame.category = "query";
+    } else if(!stack.empty() && stack.back().program){
+        frame.traced = true;
+        frame.name = string(kind) + " " + locationText(node.getStart());
+        frame.category = "statement";
+    }
+    stack.push_back(move(frame));
+}
+
+void Tracer::leave(){
+    end();
+}
+
+const vector<Tracer::Event>& Tracer::getEvents() const {
+    return events;
+}
+
+double Tracer::sinceOrigin(Clock::time_point t) const {
+    return chrono::duration<double, micro>(t - origin).count();
+}
+
+void Tracer::writeJson(ostream& out) const {
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    out << fixed << setprecision(3);
+    for(size_t i = 0; i < events.size(); i++){
+        auto const& event = events[i];
+        if(i) out << ',';
+        out << "\n{\"name\":\"" << escapeJson(event.name) << "\","
+            << "\"cat\":\"" << event.category << "\","
+            << "\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+            << "\"ts\":" << event.timestamp << ","
+            << "\"dur\":" << event.duration;
+        if(event.location.first > 0)
+            out << ",\"args\":{\"line\":" << event.location.first
+                << ",\"column\":" << event.location.second << "}";
+        out << "}";
+    }
+    out << "\n]}\n";
+}
@@ -0,0 +1,65 @@
+#ifndef TKOM_TRACER_H
+#define TKOM_TRACER_H
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <parser/Ast.h>
+#include "InstrumentedInterpreter.h"
+
+namespace intprt
+{
+
+// Records Chrome trace events ("ph": "X") that load into chrome://tracing
+// and ui.perfetto.dev. Listening to an InstrumentedInterpreter it traces
+// top-level statements, user function calls and hexgrid queries (on, by,
+// beside, within, path, visible); other spans, like lexing and parsing,
+// are added with begin/end.
+class Tracer : public ExecutionListener
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Event
+    {
+        std::string name;
+        const char* category;
+        double timestamp;   // microseconds since the tracer was created
+        double duration;    // microseconds
+        std::pair<int, int> location;
+    };
+
+    Tracer();
+
+    void begin(std::string name, const char* category);
+    void end();
+
+    void enter(const char* kind, const ast::Node&) override;
+    void leave() override;
+
+    const std::vector<Event>& getEvents() const;
+    void writeJson(std::ostream&) const;
+
+private:
+    struct Frame
+    {
+        bool traced;
+        bool program;
+        std::string name;
+        const char* category;
+        std::pair<int, int> location;
+        Clock::time_point start;
+    };
+
+    double sinceOrigin(Clock::time_point) const;
+
+    Clock::time_point origin;
+    std::vector<Frame> stack;
+    std::vector<Event> events;
+};
+
+} // namespace intprt
+
+#endif // TKOM_TRACER_H
@@ -0,0 +1,177 @@
+#include "ValueFormat.h"
+#include <charconv>
+#include <cmath>
+using namespace intprt;
+using namespace std;
+
+namespace{
+    void writeJsonString(OutputWriter& out, const string& text){
+        static const char hex[] = "0123456789abcdef";
+        out.write('"');
+        for(unsigned char c : text){
+            switch(c){
+                case '"':  out.write("\\\""); break;
+                case '\\': out.write("\\\\"); break;
+                case '\n': out.write("\\n");  break;
+                case '\t': out.write("\\t");  break;
+                case '\r': out.write("\\r");  break;
+                default:
+                    if(c < 0x20) out.write("\\u00").write(hex[c >> 4]).write(hex[c & 15]);
+                    else out.write(char(c));
+            }
+        }
+        out.write('"');
+    }
+
+    // Keeps decimals recognisable as such: 2.0 is written as 2.0, not 2.
+    void writeJsonDecimal(OutputWriter& out, double value){
+        if(!isfinite(value)){
+            out.write("null");
+            return;
+        }
+        char text[32];
+        auto end = to_chars(text, text + sizeof text, value).ptr;
+        auto written = string_view(text, end - text);
+        out.write(written);
+        if(written.find_first_of(".e") == string_view::npos) out.write(".0");
+    }
+
+    int coordinate(const Position& pos, int i){
+        return i == 0 ? get<0>(pos) : i == 1 ? get<1>(pos) : get<2>(pos);
+    }
+
+    void writeBinaryPayload(OutputWriter& out, const Var& value);
+
+    void writeBinaryValue(OutputWriter& out, const Var& value){
+        out.writeUint8(uint8_t(value.index()));
+        writeBinaryPayload(out, value);
+    }
+
+    void writeBinaryPayload(OutputWriter& out, const Var& value){
+        switch(value.index()){
+            case 1: out.writeInt32(get<int>(value)); break;
+            case 2: out.writeDouble(get<double>(value)); break;
+            case 3: {
+                auto const& text = get<Symbol>(value).str();
+                out.writeUint32(uint32_t(text.size())).write(text);
+                break;
+            }
+            case 4: {
+                auto const& array = get<Array>(value);
+                out.writeUint32(uint32_t(array.size()));
+                for(int i = 0; i < array.size(); i++) writeBinaryValue(out, array.get(i));
+                break;
+            }
+            case 5: {
+                // A pass over the cells per column; paged grids read theirs
+                // through the page cache.
+                auto const& grid = get<Hexgrid>(value);
+                out.writeUint32(uint32_t(grid.size()));
+                for(int i = 0; i < 3; i++)
+                    grid.forEach([&](const Position& pos, const Var&){ out.writeInt32(coordinate(pos, i)); });
+                grid.forEach([&](const Position&, const Var& cell){ out.writeUint8(uint8_t(cell.index())); });
+                grid.forEach([&](const Position&, const Var& cell){ writeBinaryPayload(out, cell); });
+                break;
+            }
+        }
+    }
+
+    uint64_t payloadSize(const Var& value){
+        switch(value.index()){
+            case 1: return 4;
+            case 2: return 8;
+            case 3: return 4 + get<Symbol>(value).size();
+            case 4: {
+                auto const& array = get<Array>(value);
+                uint64_t size = 4;
+                for(int i = 0; i < array.size(); i++) size += binarySize(array.get(i));
+                return size;
+            }
+            case 5: {
+                auto const& grid = get<Hexgrid>(value);
+                uint64_t size = 4 + 13 * uint64_t(grid.size());
+                grid.forEach([&](const Position&, const Var& cell){ size += payloadSize(cell); });
+                return size;
+            }
+        }
+        return 0;
+    }
+}
+
+bool intprt::parseOutputFormat(const string& name, OutputFormat& format){
+    if(name == "text") format = OutputFormat::Text;
+    else if(name == "json") format = OutputFormat::Json;
+    else if(name == "binary") format = OutputFormat::Binary;
+    else return false;
+    return true;
+}
+
+void intprt::writeValue(OutputWriter& out, const Var& value, OutputFormat format){
+    switch(format){
+        case OutputFormat::Text:
+            switch(value.index()){
+                case 0: return;
+                case 2: out.writeGeneral(get<double>(value)); break;
+                default: writeElement(out, value);
+            }
+            out.write('\n');
+            break;
+        case OutputFormat::Json:
+            writeJson(out, value);
+            out.write('\n');
+            break;
+        case OutputFormat::Binary:
+            writeBinaryFrame(out, value);
+            break;
+    }
+}
+
+void intprt::writeJson(OutputWriter& out, const Var& value){
+    switch(value.index()){
+        case 0: out.write("null"); break;
+        case 1: out.write(get<int>(value)); break;
+        case 2: writeJsonDecimal(out, get<double>(value)); break;
+        case 3: writeJsonString(out, get<Symbol>(value).str()); break;
+        case 4: {
+            auto const& array = get<Array>(value);
+            out.write('[');
+            for(int i = 0; i < array.size(); i++){
+                if(i) out.write(',');
+                writeJson(out, array.get(i));
+            }
+            out.write(']');
+            break;
+        }
+        case 5: {
+            auto const& grid = get<Hexgrid>(value);
+            const char* columns[] = {"{\"q\":[", "],\"r\":[", "],\"s\":["};
+            for(int i = 0; i < 3; i++){
+                out.write(columns[i]);
+                bool first = true;
+                grid.forEach([&](const Position& pos, const Var&){
+                    if(!first) out.write(',');
+                    out.write(coordinate(pos, i));
+                    first = false;
+                });
+            }
+            out.write("],\"values\":[");
+            bool first = true;
+            grid.forEach([&](const Position&, const Var& cell){
+                if(!first) out.write(',');
+                writeJson(out, cell);
+                first = false;
+            });
+            out.write("]}");
+            break;
+        }
+    }
+}
+
+void intprt::writeBinaryFrame(OutputWriter& out, const Var& value){
+    out.writeUint64(binarySize(value));
+    writeBinaryValue(out, value);
+}
+
+uint64_t intprt::binarySize(const Var& value){
+    return 1 + payloadSize(value);
+}
@@ -0,0 +1,40 @@
+#ifndef TKOM_VALUE_FORMAT_H
+#define TKOM_VALUE_FORMAT_H
+
+#include <cstdint>
+#include <string>
+#include "Interpreter.h"
+#include "OutputWriter.h"
+
+namespace intprt
+{
+
+// "text", "json" or "binary"; false for anything else.
+bool parseOutputFormat(const std::string&, OutputFormat&);
+
+// Writes a returned value followed by a newline in the text and JSON
+// formats, or as a single binary frame.
+void writeValue(OutputWriter&, const Var&, OutputFormat);
+
+// Numbers, strings and arrays map to their JSON counterparts, nothing to
+// null. A hexgrid is written column by column:
+//   {"q":[...],"r":[...],"s":[...],"values":[...]}
+void writeJson(OutputWriter&, const Var&);
+
+// A frame is the byte length of the value as uint64 followed by the value.
+// All numbers are little-endian. A value is a one byte tag and its payload:
+//   0 nothing
+//   1 int      int32
+//   2 float    float64
+//   3 string   uint32 length, bytes
+//   4 array    uint32 count, count values
+//   5 hexgrid  uint32 count, then the columns int32 q[count], int32 r[count],
+//              int32 s[count], uint8 tag[count] and the payloads of the
+//              values in cell order, without their tags
+// Cells are in the (q, r, s) order used by foreach.
+void writeBinaryFrame(OutputWriter&, const Var&);
+std::uint64_t binarySize(const Var&);
+
+} // namespace intprt
+
+#endif // TKOM_VALUE_FORMAT_H
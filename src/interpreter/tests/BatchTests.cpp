@@ -0,0 +1,132 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <boost/test/unit_test.hpp>
+#include <parser/Ast.h>
+#include <lexer/Lexer.h>
+#include "interpreter/Batch.h"
+#include "interpreter/CompressedGrid.h"
+#include "interpreter/GridFile.h"
+using namespace ast;
+using namespace lexer;
+using namespace parser;
+using namespace std;
+using namespace intprt;
+
+
+struct BatchTestsFixture
+{
+    vector<string> paths;
+
+    ~BatchTestsFixture()
+    {
+        for(auto const& path : paths) remove(path.c_str());
+    }
+
+    string writeInput(const string& text)
+    {
+        auto path = "batch_test_input_" + to_string(paths.size()) + ".hex";
+        ofstream(path) << text;
+        paths.push_back(path);
+        return path;
+    }
+
+    unique_ptr<Program> parse(const string& script)
+    {
+        istringstream in(script);
+        return Parser(make_unique<Lexer>(in)).parse();
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(BatchTests, BatchTestsFixture)
+
+BOOST_AUTO_TEST_CASE(batch_reads_hexgrid_literal)
+{
+    istringstream in("<\"blue\" at [0, 0, 0], 2 at [1, -1, 0]>");
+    auto grid = readHexgrid(in);
+    BOOST_CHECK_EQUAL(grid.size(), 2);
+    BOOST_CHECK_EQUAL(get<Symbol>(grid.on(0, 0, 0)).str(), "blue");
+    istringstream script("<1 at [0, 0, 0]>; return 1");
+    BOOST_CHECK_THROW(readHexgrid(script), runtime_error);
+    istringstream negative("<-2.5 at [-1, 1, 0]>");
+    BOOST_CHECK_EQUAL(get<double>(readHexgrid(negative).on(-1, 1, 0)), -2.5);
+}
+
+BOOST_AUTO_TEST_CASE(batch_rejects_code_as_hexgrid)
+{
+    for(auto text : {"load \"batch_test_missing.hex\"",
+                     "open(\"batch_test_missing.hex\")",
+                     "distances(<1 at [0, 0, 0]>, [[0, 0, 0]])",
+                     "<load \"batch_test_missing.hex\" at [0, 0, 0]>",
+                     "<1 + 1 at [0, 0, 0]>"}){
+        istringstream in(text);
+        BOOST_CHECK_THROW(readHexgrid(in), runtime_error);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(batch_loads_saved_hexgrids)
+{
+    auto grid = Hexgrid();
+    grid.add(positionToArray(Position(0, 0, 0)), string("blue"));
+    grid.add(positionToArray(Position(1, -1, 0)), 2);
+    auto inputs = vector<string>{writeInput(""), writeInput(""), writeInput("<3 at [0, 0, 0]>")};
+    saveHexgrid(grid, inputs[0]);
+    saveCompressedHexgrid(grid, inputs[1]);
+    BOOST_CHECK(readInputHexgrid(inputs[0]).toString() == grid.toString());
+    BOOST_CHECK(readInputHexgrid(inputs[1]).toString() == grid.toString());
+    BOOST_CHECK_EQUAL(get<int>(readInputHexgrid(inputs[2]).on(0, 0, 0)), 3);
+    auto program = parse("return grid on [0, 0, 0];");
+    auto runner = BatchRunner(*program, "grid", 2);
+    auto out = ostringstream(), errors = ostringstream();
+    BOOST_CHECK_EQUAL(runner.run(inputs, out, errors), 0u);
+    BOOST_CHECK_EQUAL(out.str(), "blue\nblue\n3\n");
+}
+
+BOOST_AUTO_TEST_CASE(batch_reads_path_list)
+{
+    istringstream in("a.hex\n\n  b.hex \r\n\t\nc.hex");
+    BOOST_CHECK(readPathList(in) == vector<string>({"a.hex", "b.hex", "c.hex"}));
+}
+
+BOOST_AUTO_TEST_CASE(batch_writes_outputs_in_input_order)
+{
+    auto inputs = vector<string>();
+    auto expected = string();
+    for(int i = 0; i < 40; i++){
+        // Later inputs are smaller, so they tend to finish first.
+        auto literal = string("<");
+        int cells = 200 - i * 5;
+        for(int q = 0; q < cells; q++)
+            literal += (q ? ", " : "") + to_string(q % 3) + " at [" + to_string(q) + ", 0, " + to_string(-q) + "]";
+        inputs.push_back(writeInput(literal + ">"));
+        expected += to_string(cells) + "\n";
+    }
+    auto program = parse("int count = 0;"
+                         "foreach array pos in input { count = count + 1; }"
+                         "return count;");
+    for(unsigned threads : {1u, 4u}){
+        auto runner = BatchRunner(*program, "input", threads);
+        auto out = ostringstream(), errors = ostringstream();
+        BOOST_CHECK_EQUAL(runner.run(inputs, out, errors), 0u);
+        BOOST_CHECK_EQUAL(out.str(), expected);
+        BOOST_CHECK_EQUAL(errors.str(), "");
+        BOOST_CHECK_EQUAL(runner.getPoolStats().threads, threads);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(batch_reports_failed_inputs)
+{
+    auto inputs = vector<string>{writeInput("<1 at [0, 0, 0]>"),
+                                 "batch_test_missing.hex",
+                                 writeInput("<\"text\" at [0, 0, 0]>"),
+                                 writeInput("<2 at [0, 0, 0]>")};
+    auto program = parse("int value = grid on [0, 0, 0]; return value * 10;");
+    auto runner = BatchRunner(*program, "grid", 2);
+    auto out = ostringstream(), errors = ostringstream();
+    BOOST_CHECK_EQUAL(runner.run(inputs, out, errors), 2u);
+    BOOST_CHECK_EQUAL(out.str(), "10\n20\n");
+    BOOST_CHECK(errors.str().find("batch_test_missing.hex: ") != string::npos);
+    BOOST_CHECK(errors.str().find(inputs[2] + ": ") != string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
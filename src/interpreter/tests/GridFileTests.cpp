@@ -0,0 +1,221 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <boost/test/unit_test.hpp>
+#include <parser/Ast.h>
+#include <lexer/Lexer.h>
+#include "interpreter/CompressedGrid.h"
+#include "interpreter/GridFile.h"
+#include "interpreter/PagedGrid.h"
+using namespace ast;
+using namespace lexer;
+using namespace parser;
+using namespace std;
+using namespace intprt;
+
+
+struct GridFileTestsFixture
+{
+    const string path = "grid_file_test.hex";
+
+    ~GridFileTestsFixture()
+    {
+        remove(path.c_str());
+    }
+
+    string fileBytes()
+    {
+        ifstream in(path, ios::binary);
+        return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    }
+
+    void writeBytes(const string& bytes)
+    {
+        ofstream(path, ios::binary) << bytes;
+    }
+
+    // 100 rows of 100 cells holding one of three values.
+    Hexgrid paletteRows()
+    {
+        auto grid = Hexgrid();
+        const Var palette[] = {string("water"), string("grass"), 3};
+        for(int q = -50; q < 50; q++)
+            for(int r = 0; r < 100; r++)
+                grid.add(positionToArray(Position(q, r, -q - r)), palette[(q * q + r / 10) % 3]);
+        return grid;
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(GridFileTests, GridFileTestsFixture)
+
+BOOST_AUTO_TEST_CASE(grid_file_round_trips_cells)
+{
+    auto grid = Hexgrid();
+    grid.add(positionToArray(Position(-3, 1, 2)), -7);
+    grid.add(positionToArray(Position(0, 0, 0)), string("blue"));
+    grid.add(positionToArray(Position(0, 2, -2)), 2.5);
+    grid.add(positionToArray(Position(1, -1, 0)), string("blue"));
+    grid.add(positionToArray(Position(4, -4, 0)), string(""));
+    grid.add(positionToArray(Position(5, -9, 4)), Var());
+    saveHexgrid(grid, path);
+    auto loaded = loadHexgrid(path);
+    BOOST_CHECK_EQUAL(loaded.toString(), grid.toString());
+    BOOST_REQUIRE_EQUAL(loaded.size(), 6);
+    BOOST_CHECK_EQUAL(get<int>(loaded.on(-3, 1, 2)), -7);
+    BOOST_CHECK_EQUAL(get<double>(loaded.on(0, 2, -2)), 2.5);
+    BOOST_CHECK_EQUAL(loaded.on(5, -9, 4).index(), 0u);
+    // "blue" is stored once.
+    auto layout = gridfile::Layout{6, 2, 4};
+    BOOST_CHECK_EQUAL(fileBytes().size(), layout.fileSize());
+    BOOST_CHECK_EQUAL(layout.valueColumn() % 8, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(grid_file_keeps_path_costs)
+{
+    auto grid = Hexgrid();
+    for(int q = 0; q < 5; q++) grid.add(positionToArray(Position(q, -q, 0)), 3);
+    saveHexgrid(grid, path);
+    auto loaded = loadHexgrid(path);
+    BOOST_CHECK(loaded.path(Position(0, 0, 0), Position(4, -4, 0)) == grid.path(Position(0, 0, 0), Position(4, -4, 0)));
+}
+
+BOOST_AUTO_TEST_CASE(grid_file_saves_empty_grid)
+{
+    saveHexgrid(Hexgrid(), path);
+    BOOST_CHECK_EQUAL(fileBytes().size(), gridfile::Layout().fileSize());
+    BOOST_CHECK_EQUAL(loadHexgrid(path).size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(grid_file_rejects_nested_values)
+{
+    auto grid = Hexgrid();
+    grid.add(positionToArray(Position(0, 0, 0)), positionToArray(Position(1, -1, 0)));
+    BOOST_CHECK_THROW(saveHexgrid(grid, path), runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(grid_file_rejects_damaged_files)
+{
+    BOOST_CHECK_THROW(loadHexgrid("grid_file_test_missing.hex"), runtime_error);
+    auto grid = Hexgrid();
+    grid.add(positionToArray(Position(0, 0, 0)), 1);
+    grid.add(positionToArray(Position(1, 0, -1)), string("red"));
+    saveHexgrid(grid, path);
+    auto bytes = fileBytes();
+    writeBytes(bytes.substr(0, bytes.size() - 1));
+    BOOST_CHECK_THROW(loadHexgrid(path), runtime_error);
+    writeBytes("HEXGRIX1" + bytes.substr(8));
+    BOOST_CHECK_THROW(loadHexgrid(path), runtime_error);
+    // Cells out of order.
+    auto swapped = bytes;
+    swap(swapped[32], swapped[36]);
+    writeBytes(swapped);
+    BOOST_CHECK_THROW(loadHexgrid(path), runtime_error);
+    // A string number past the table.
+    auto outside = bytes;
+    outside[gridfile::Layout{2, 1, 3}.valueColumn() + 8] = 9;
+    writeBytes(outside);
+    BOOST_CHECK_THROW(loadHexgrid(path), runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(grid_file_saved_and_loaded_by_scripts)
+{
+    istringstream in("hexgrid grid = <\"blue\" at [0, 0, 0], 4 at [1, -1, 0]>;"
+                     "save grid to \"" + path + "\";"
+                     "hexgrid copy = load \"" + path + "\";"
+                     "int value = copy on [1, -1, 0];");
+    auto interpreter = Interpreter();
+    interpreter.setThreads(1);
+    Parser(make_unique<Lexer>(in)).parse()->accept(interpreter);
+    BOOST_CHECK_EQUAL(get<int>(interpreter.getValue("value")), 4);
+    BOOST_CHECK_EQUAL(get<Hexgrid>(interpreter.getValue("copy")).size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(hilbert_curve_moves_one_cell_at_a_time)
+{
+    auto order = vector<pair<uint64_t, pair<uint32_t, uint32_t>>>();
+    for(uint32_t x = 0; x < 16; x++)
+        for(uint32_t y = 0; y < 16; y++) order.push_back({gridfile::hilbertIndex(x, y), {x, y}});
+    sort(order.begin(), order.end());
+    BOOST_CHECK_EQUAL(order.back().first, 255u);
+    for(size_t i = 1; i < order.size(); i++){
+        auto [x0, y0] = order[i - 1].second;
+        auto [x1, y1] = order[i].second;
+        BOOST_CHECK_EQUAL(abs(int(x1) - int(x0)) + abs(int(y1) - int(y0)), 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(compressed_grid_round_trips_cells)
+{
+    auto grid = Hexgrid();
+    grid.add(positionToArray(Position(-3, 1, 2)), -7);
+    grid.add(positionToArray(Position(0, 0, 0)), string("blue"));
+    grid.add(positionToArray(Position(0, 2, -2)), 2.5);
+    grid.add(positionToArray(Position(1, -1, 0)), string("blue"));
+    grid.add(positionToArray(Position(4, -4, 0)), string(""));
+    grid.add(positionToArray(Position(5, -9, 4)), Var());
+    grid.add(positionToArray(Position(-2000000000, 2000000000, 0)), 2147483647);
+    saveCompressedHexgrid(grid, path);
+    BOOST_CHECK_EQUAL(loadHexgrid(path).toString(), grid.toString());
+    saveCompressedHexgrid(Hexgrid(), path);
+    BOOST_CHECK_EQUAL(loadHexgrid(path).size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(compressed_grid_is_small_for_palettes)
+{
+    auto grid = paletteRows();
+    saveHexgrid(grid, path);
+    auto columns = fileBytes().size();
+    saveCompressedHexgrid(grid, path);
+    auto compressed = fileBytes().size();
+    BOOST_CHECK_LT(compressed * 10, columns);
+    BOOST_CHECK_EQUAL(loadHexgrid(path).toString(), grid.toString());
+}
+
+BOOST_AUTO_TEST_CASE(compressed_grid_reader_streams_cells)
+{
+    auto grid = paletteRows();
+    auto encoded = ostringstream();
+    writeCompressedHexgrid(grid, encoded);
+    auto in = istringstream(encoded.str());
+    auto reader = CompressedGridReader(in);
+    BOOST_REQUIRE_EQUAL(reader.size(), 10000u);
+    auto pos = Position();
+    auto value = Var();
+    size_t same = 0, read = 0;
+    while(reader.next(pos, value)){
+        read++;
+        if(sameValue(grid.on(pos), value)) same++;
+    }
+    BOOST_CHECK_EQUAL(read, 10000u);
+    BOOST_CHECK_EQUAL(same, 10000u);
+    BOOST_CHECK(!reader.next(pos, value));
+}
+
+BOOST_AUTO_TEST_CASE(compressed_grid_rejects_damaged_files)
+{
+    saveCompressedHexgrid(paletteRows(), path);
+    auto bytes = fileBytes();
+    writeBytes(bytes.substr(0, bytes.size() - 1));
+    BOOST_CHECK_THROW(loadHexgrid(path), runtime_error);
+    // A value number past the dictionary.
+    writeBytes(bytes.substr(0, bytes.size() - 1) + char(99));
+    BOOST_CHECK_THROW(loadHexgrid(path), runtime_error);
+    auto in = istringstream(bytes.substr(0, 6));
+    BOOST_CHECK_THROW(CompressedGridReader{in}, runtime_error);
+    BOOST_CHECK_THROW(PagedGrid(path, 1), runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(compressed_grid_saved_by_scripts)
+{
+    istringstream in("hexgrid grid = <\"blue\" at [0, 0, 0], 4 at [1, -1, 0]>;"
+                     "save grid to \"" + path + "\" compressed;"
+                     "hexgrid copy = load \"" + path + "\";"
+                     "int value = copy on [1, -1, 0];");
+    auto interpreter = Interpreter();
+    interpreter.setThreads(1);
+    Parser(make_unique<Lexer>(in)).parse()->accept(interpreter);
+    BOOST_CHECK_EQUAL(get<int>(interpreter.getValue("value")), 4);
+    BOOST_CHECK_EQUAL(fileBytes().substr(0, 8), "HEXGRIZ1");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,71 @@
+#include <cmath>
+#include <boost/test/unit_test.hpp>
+#include "interpreter/HexLine.h"
+using namespace std;
+using namespace intprt;
+
+namespace{
+    vector<Position> cellsOn(const Position& from, const Position& to){
+        auto cells = vector<Position>();
+        for(auto line = HexLine(from, to); !line.done(); line.next()) cells.push_back(line.current());
+        return cells;
+    }
+
+    // The floating point line of the usual cube rounding algorithm.
+    Position rounded(const Position& a, const Position& b, double t){
+        double q = get<0>(a) + (get<0>(b) - get<0>(a)) * t;
+        double r = get<1>(a) + (get<1>(b) - get<1>(a)) * t;
+        double s = get<2>(a) + (get<2>(b) - get<2>(a)) * t;
+        double rq = round(q), rr = round(r), rs = round(s);
+        double dq = fabs(rq - q), dr = fabs(rr - r), ds = fabs(rs - s);
+        if(dq > dr && dq > ds) rq = -rr - rs;
+        else if(dr > ds) rr = -rq - rs;
+        else rs = -rq - rr;
+        return Position(int(rq), int(rr), int(rs));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(HexLineTests)
+
+BOOST_AUTO_TEST_CASE(line_to_itself_is_one_cell)
+{
+    auto cells = cellsOn(Position(2, -1, -1), Position(2, -1, -1));
+    BOOST_CHECK_EQUAL(cells.size(), 1u);
+    BOOST_CHECK(cells[0] == Position(2, -1, -1));
+}
+
+BOOST_AUTO_TEST_CASE(line_along_an_axis)
+{
+    auto cells = cellsOn(Position(0, 0, 0), Position(3, 0, -3));
+    auto expected = vector<Position>{{0, 0, 0}, {1, 0, -1}, {2, 0, -2}, {3, 0, -3}};
+    BOOST_CHECK(cells == expected);
+}
+
+BOOST_AUTO_TEST_CASE(lines_are_contiguous_and_end_at_their_targets)
+{
+    for(int q = -6; q <= 6; q++)
+        for(int r = -6; r <= 6; r++){
+            auto from = Position(1, 2, -3);
+            auto to = Position(q, r, -q - r);
+            auto cells = cellsOn(from, to);
+            BOOST_REQUIRE_EQUAL((long long)cells.size(), hexDistance(from, to) + 1);
+            BOOST_CHECK(cells.front() == from);
+            BOOST_CHECK(cells.back() == to);
+            for(size_t i = 1; i < cells.size(); i++)
+                BOOST_CHECK_EQUAL(hexDistance(cells[i - 1], cells[i]), 1);
+        }
+}
+
+BOOST_AUTO_TEST_CASE(line_matches_floating_point_rounding_away_from_ties)
+{
+    // Lines whose points never fall halfway between cells.
+    auto from = Position(0, 0, 0);
+    for(auto const& to : {Position(7, -3, -4), Position(-5, 9, -4), Position(11, -2, -9)}){
+        auto cells = cellsOn(from, to);
+        auto n = hexDistance(from, to);
+        for(long long i = 0; i <= n; i++)
+            BOOST_CHECK(cells[i] == rounded(from, to, double(i) / n));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
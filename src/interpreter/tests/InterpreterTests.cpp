@@ -1,4 +1,8 @@
+#include <algorithm>
+#include <limits>
+#include <set>
 #include <sstream>
+#include <thread>
 #include <boost/test/unit_test.hpp>
 #include <parser/Ast.h>
 #include <lexer/Lexer.h>
@@ -74,13 +78,13 @@ BOOST_AUTO_TEST_CASE(interpreter_declare_and_assign_var_string)
 {
     interpret_text("string x;\nx=\"Hello\";");
     BOOST_CHECK_EQUAL(interpreter.containsVar("x"), true);
-    BOOST_CHECK_EQUAL(get<string>(interpreter.getValue("x")), "Hello");
+    BOOST_CHECK_EQUAL(get<Symbol>(interpreter.getValue("x")).str(), "Hello");
 }
 BOOST_AUTO_TEST_CASE(interpreter_init_var_string)
 {
     interpret_text("string x=\"Hello\";");
     BOOST_CHECK_EQUAL(interpreter.containsVar("x"), true);
-    BOOST_CHECK_EQUAL(get<string>(interpreter.getValue("x")), "Hello");
+    BOOST_CHECK_EQUAL(get<Symbol>(interpreter.getValue("x")).str(), "Hello");
 }
 BOOST_AUTO_TEST_CASE(interpreter_declare_var_array)
 {
@@ -103,7 +107,7 @@ BOOST_AUTO_TEST_CASE(interpreter_init_var_array)
     auto ar =get<Array>(interpreter.getValue("x"));
     BOOST_CHECK_EQUAL(get<int>(ar.get(0)), 1);
     BOOST_CHECK_EQUAL(get<double>(ar.get(1)), 2.2);
-    BOOST_CHECK_EQUAL(get<string>(ar.get(2)), "Hello");
+    BOOST_CHECK_EQUAL(get<Symbol>(ar.get(2)).str(), "Hello");
     auto subArr = get<Array>(ar.get(3));
     BOOST_CHECK_EQUAL(get<int>(subArr.get(0)), 1);
 }
@@ -112,8 +116,8 @@ BOOST_AUTO_TEST_CASE(interpreter_init_var_hexgrid)
     interpret_text("hexgrid x=<\"blue\" at [0, 0, 0], \"red\" at [0, 1, -1]>;");
     BOOST_CHECK_EQUAL(interpreter.containsVar("x"), true);
     auto hex =get<Hexgrid>(interpreter.getValue("x"));
-    BOOST_CHECK_EQUAL(get<string>(hex.on(0, 0, 0)), "blue");
-    BOOST_CHECK_EQUAL(get<string>(hex.on(0, 1, -1)), "red");
+    BOOST_CHECK_EQUAL(get<Symbol>(hex.on(0, 0, 0)).str(), "blue");
+    BOOST_CHECK_EQUAL(get<Symbol>(hex.on(0, 1, -1)).str(), "red");
 }
 
 BOOST_AUTO_TEST_CASE(interpreter_arithmetical_negation_int)
@@ -168,7 +172,7 @@ BOOST_AUTO_TEST_CASE(interpreter_add_expression_string)
 {
     interpret_text("string x = \"a\" + \"b\";");
     BOOST_CHECK_EQUAL(interpreter.containsVar("x"), true);
-    BOOST_CHECK_EQUAL(get<string>(interpreter.getValue("x")), "ab");
+    BOOST_CHECK_EQUAL(get<Symbol>(interpreter.getValue("x")).str(), "ab");
 }
 
 
@@ -384,7 +388,7 @@ BOOST_AUTO_TEST_CASE(interpreter_on_expression_string)
 {
     interpret_text( "hexgrid x = <\"asd\" at [2, -1, -1]>; string word = x on [2, -1, -1];");
     BOOST_CHECK_EQUAL(interpreter.containsVar("word"), true);
-    BOOST_CHECK_EQUAL(get<string>(interpreter.getValue("word")), "asd");
+    BOOST_CHECK_EQUAL(get<Symbol>(interpreter.getValue("word")).str(), "asd");
 }
 
 BOOST_AUTO_TEST_CASE(interpreter_on_expression_int)
@@ -410,6 +414,50 @@ BOOST_AUTO_TEST_CASE(interpreter_by_expression)
     BOOST_CHECK_EQUAL(get<int>(interpreter.getValue("s2")), -4);
 }
 
+BOOST_AUTO_TEST_CASE(hexgrid_ranges_cover_cells_in_order)
+{
+    auto grid = Hexgrid();
+    BOOST_CHECK_EQUAL(grid.ranges(4).size(), 1u);
+    grid.add(positionToArray(Position(-4, 2, 2)), 1);
+    BOOST_CHECK_EQUAL(grid.ranges(4).size(), 1u);
+    for(int q = -5; q <= 3; q++)
+        for(int r = -300; r <= 300; r += 7) grid.add(positionToArray(Position(q, r, -q - r)), q);
+    // A single row is cut along r.
+    auto row = Hexgrid();
+    for(int r = -50; r < 50; r++) row.add(positionToArray(Position(2, r, -2 - r)), r);
+    for(auto const* cut : {&grid, &row}){
+        auto ranges = cut->ranges(16);
+        BOOST_CHECK_GT(ranges.size(), 8u);
+        BOOST_CHECK(ranges.size() <= 16u);
+        auto cell = cut->getCells().begin();
+        for(auto const& range : ranges){
+            BOOST_CHECK(range.first == cell);
+            cell = range.second;
+        }
+        BOOST_CHECK(cell == cut->getCells().end());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_by_scans_ranges_in_order)
+{
+    auto grid = Hexgrid();
+    unsigned state = 99;
+    for(int q = -150; q <= 150; q++)
+        for(int r = -150; r <= 150; r++){
+            state = state * 1103515245 + 12345;
+            grid.add(positionToArray(Position(q, r, -q - r)), int((state >> 16) % 5));
+        }
+    BOOST_REQUIRE(size_t(grid.size()) >= Hexgrid::parallelScanCells);
+    auto single = get<Array>(grid.by(3));
+    auto pool = ThreadPool(4);
+    auto scope = PoolScope(pool);
+    auto parallel = get<Array>(grid.by(3, 4));
+    BOOST_CHECK_GT(pool.getStats().tasks, 4u);
+    BOOST_REQUIRE_EQUAL(single.size(), parallel.size());
+    BOOST_CHECK_EQUAL(single.toString(), parallel.toString());
+    BOOST_CHECK_EQUAL(get<Array>(grid.by(3, 3)).toString(), single.toString());
+}
+
 BOOST_AUTO_TEST_CASE(interpreter_beside_expression)
 {
     interpret_text( "hexgrid x = <\"blue\" at [2, -1, -1], 1 at [2, 0, -2], 10.2 at [3, -2, -1]>; \n" 
@@ -450,6 +498,576 @@ BOOST_AUTO_TEST_CASE(interpreter_beside_expression2)
     BOOST_CHECK_EQUAL(c, 2);
 }
 
+BOOST_AUTO_TEST_CASE(interpreter_within_expression)
+{
+    interpret_text("hexgrid x = <1 at [0, 0, 0], 2 at [1, -1, 0], 3 at [2, -1, -1],"
+                   "             4 at [3, -3, 0], 5 at [-2, 0, 2]>;"
+                   "array none = x within 0 at [5, -5, 0];"
+                   "array centre = x within 0 at [0, 0, 0];"
+                   "array near = x within 2 at [0, 0, 0];");
+    BOOST_CHECK_EQUAL(get<Array>(interpreter.getValue("none")).size(), 0);
+    BOOST_CHECK_EQUAL(get<Array>(interpreter.getValue("centre")).size(), 1);
+    auto near = get<Array>(interpreter.getValue("near"));
+    BOOST_CHECK_EQUAL(near.toString(),
+                      "[ [ -2, 0, 2, ], [ 0, 0, 0, ], [ 1, -1, 0, ], [ 2, -1, -1, ], ]");
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_within_probes_and_scans_alike)
+{
+    interpret_text("hexgrid x = <>;"
+                   "foreach int q in [-5, -4, -3, -2, -1, 0, 1, 2, 3, 4, 5] {"
+                   "    foreach int r in [-5, -4, -3, -2, -1, 0, 1, 2, 3, 4, 5] {"
+                   "        if (q + r <= 5 and q + r >= (-5)) { add q * 10 + r to x at [q, r, -q-r]; }"
+                   "    }"
+                   "}");
+    auto x = get<Hexgrid>(interpreter.getValue("x"));
+    BOOST_CHECK_EQUAL(x.size(), 91);
+    for(int radius = 0; radius <= 7; radius++){
+        auto found = vector<Position>();
+        x.within(Position(1, -1, 0), radius, [&](const Position& pos){ found.push_back(pos); });
+        auto expected = vector<Position>();
+        for(auto const& pos : x.getKeys())
+            if(hexDistance(pos, Position(1, -1, 0)) <= radius) expected.push_back(pos);
+        BOOST_CHECK(found == expected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_foreach_within)
+{
+    interpret_text("hexgrid x = <1 at [0, 0, 0], 2 at [1, -1, 0], 3 at [2, -1, -1], 4 at [3, -3, 0]>;"
+                   "int sum = 0;"
+                   "foreach array pos in x within 2 - 1 at [1, -1, 0] { sum = sum + (x on pos); }");
+    BOOST_CHECK_EQUAL(get<int>(interpreter.getValue("sum")), 6);
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_within_validates_operands)
+{
+    BOOST_CHECK_THROW(interpret_text("hexgrid x = <1 at [0, 0, 0]>; array a = x within 1 at [1, 1, 1];"),
+                      std::runtime_error);
+    BOOST_CHECK_THROW(interpret_text("hexgrid y = <1 at [0, 0, 0]>; array b = y within (-1) at [0, 0, 0];"),
+                      std::runtime_error);
+    BOOST_CHECK_THROW(interpret_text("hexgrid z = <1 at [0, 0, 0]>; array c = z within 1.5 at [0, 0, 0];"),
+                      std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_path_goes_around_walls)
+{
+    // A straight row from [0, 0, 0] to [3, 0, -3] blocked at [2, 0, -2].
+    interpret_text("hexgrid x = <1 at [0, 0, 0], 1 at [1, 0, -1], (-1) at [2, 0, -2], 1 at [3, 0, -3],"
+                   "             1 at [2, -1, -1], 1 at [3, -1, -2]>;"
+                   "array p = path from [0, 0, 0] to [3, 0, -3] in x;");
+    BOOST_CHECK_EQUAL(get<Array>(interpreter.getValue("p")).toString(),
+                      "[ [ 0, 0, 0, ], [ 1, 0, -1, ], [ 2, -1, -1, ], [ 3, -1, -2, ], [ 3, 0, -3, ], ]");
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_path_prefers_cheaper_cells)
+{
+    interpret_text("hexgrid x = <1 at [0, 0, 0], 9 at [1, 0, -1], 2 at [1, -1, 0], 2 at [2, -1, -1],"
+                   "             1 at [2, 0, -2]>;"
+                   "array p = path from [0, 0, 0] to [2, 0, -2] in x;");
+    BOOST_CHECK_EQUAL(get<Array>(interpreter.getValue("p")).toString(),
+                      "[ [ 0, 0, 0, ], [ 1, -1, 0, ], [ 2, -1, -1, ], [ 2, 0, -2, ], ]");
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_path_without_route_is_empty)
+{
+    interpret_text("hexgrid x = <\"a\" at [0, 0, 0], \"b\" at [2, 0, -2]>;"
+                   "array p = path from [0, 0, 0] to [2, 0, -2] in x;"
+                   "array q = path from [0, 0, 0] to [5, 0, -5] in x;"
+                   "array r = path from [0, 0, 0] to [0, 0, 0] in x;");
+    BOOST_CHECK_EQUAL(get<Array>(interpreter.getValue("p")).size(), 0);
+    BOOST_CHECK_EQUAL(get<Array>(interpreter.getValue("q")).size(), 0);
+    BOOST_CHECK_EQUAL(get<Array>(interpreter.getValue("r")).toString(), "[ [ 0, 0, 0, ], ]");
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_path_length_matches_distance_on_open_grid)
+{
+    auto grid = Hexgrid();
+    for(int q = -10; q <= 10; q++)
+        for(int r = -10; r <= 10; r++)
+            if(abs(q + r) <= 10) grid.add(positionToArray(Position(q, r, -q - r)), string("open"));
+    auto found = grid.path(Position(-10, 0, 10), Position(10, -5, -5));
+    BOOST_CHECK_EQUAL(found.size(), 21u);
+    for(size_t i = 1; i < found.size(); i++)
+        BOOST_CHECK_EQUAL(hexDistance(found[i - 1], found[i]), 1);
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_flood_from_seed)
+{
+    interpret_text("hexgrid x = <\"blue\" at [0, 0, 0], \"blue\" at [1, -1, 0], \"red\" at [0, 1, -1],"
+                   "             \"blue\" at [2, -1, -1], \"blue\" at [5, -5, 0], \"red\" at [-1, 1, 0]>;"
+                   "array blue = flood(x, [0, 0, 0]);"
+                   "array red = flood(x, [0, 1, -1]);"
+                   "array through = flood(x, [0, 1, -1], \"blue\");"
+                   "array empty = flood(x, [9, -9, 0]);");
+    BOOST_CHECK_EQUAL(get<Array>(interpreter.getValue("blue")).toString(),
+                      "[ [ 0, 0, 0, ], [ 1, -1, 0, ], [ 2, -1, -1, ], ]");
+    BOOST_CHECK_EQUAL(get<Array>(interpreter.getValue("red")).toString(),
+                      "[ [ 0, 1, -1, ], [ -1, 1, 0, ], ]");
+    BOOST_CHECK_EQUAL(get<Array>(interpreter.getValue("through")).toString(),
+                      "[ [ 0, 1, -1, ], [ 0, 0, 0, ], [ 1, -1, 0, ], [ 2, -1, -1, ], ]");
+    BOOST_CHECK_EQUAL(get<Array>(interpreter.getValue("empty")).size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_components_label_regions)
+{
+    interpret_text("hexgrid x = <1 at [0, 0, 0], 1 at [1, -1, 0], 2 at [0, 1, -1],"
+                   "             1 at [3, -3, 0], 2 at [-1, 1, 0], [1] at [-1, 0, 1]>;"
+                   "hexgrid labels = components(x);");
+    BOOST_CHECK_EQUAL(get<Hexgrid>(interpreter.getValue("labels")).toString(),
+                      "< 1 at [-1, 0, 1], 2 at [-1, 1, 0], 3 at [0, 0, 0], 2 at [0, 1, -1], "
+                      "3 at [1, -1, 0], 4 at [3, -3, 0], >");
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_components_agree_with_flood)
+{
+    auto grid = Hexgrid();
+    unsigned state = 12345;
+    for(int q = -8; q <= 8; q++)
+        for(int r = -8; r <= 8; r++){
+            state = state * 1103515245 + 12345;
+            if(abs(q + r) <= 8 && (state >> 16) % 5) grid.add(positionToArray(Position(q, r, -q - r)), int(state >> 16) % 3);
+        }
+    auto labels = grid.components();
+    BOOST_CHECK_EQUAL(labels.size(), grid.size());
+    for(auto const& pos : grid.getKeys()){
+        auto region = grid.flood(pos);
+        int label = get<int>(labels.on(pos));
+        int members = 0;
+        for(auto const& [other, otherLabel] : labels.getCells()) members += get<int>(otherLabel) == label;
+        BOOST_CHECK_EQUAL(int(region.size()), members);
+        for(auto const& other : region) BOOST_CHECK_EQUAL(get<int>(labels.on(other)), label);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_distances_from_sources)
+{
+    interpret_text("hexgrid x = <0 at [0, 0, 0], 0 at [1, -1, 0], 0 at [2, -2, 0], 0 at [3, -3, 0],"
+                   "             0 at [4, -4, 0], 0 at [9, -9, 0]>;"
+                   "array a = [0, 0, 0];"
+                   "array b = [4, -4, 0];"
+                   "array sources = [a, b];"
+                   "hexgrid steps = distances(x, sources);"
+                   "hexgrid owner = nearest(x, sources);");
+    BOOST_CHECK_EQUAL(get<Hexgrid>(interpreter.getValue("steps")).toString(),
+                      "< 0 at [0, 0, 0], 1 at [1, -1, 0], 2 at [2, -2, 0], 1 at [3, -3, 0], 0 at [4, -4, 0], >");
+    BOOST_CHECK_EQUAL(get<Hexgrid>(interpreter.getValue("owner")).toString(),
+                      "< 0 at [0, 0, 0], 0 at [1, -1, 0], 0 at [2, -2, 0], 1 at [3, -3, 0], 1 at [4, -4, 0], >");
+    BOOST_CHECK_THROW(interpret_text("hexgrid y = distances(x, a);"), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_distances_agree_across_threads)
+{
+    // Wide enough frontiers to be expanded in parallel, with holes so
+    // that steps don't follow from the coordinates alone.
+    auto grid = Hexgrid();
+    auto sources = vector<Position>();
+    unsigned state = 777;
+    for(int q = -120; q <= 120; q++)
+        for(int r = -120; r <= 120; r++){
+            if(abs(q + r) > 120) continue;
+            state = state * 1103515245 + 12345;
+            if((state >> 16) % 7 == 0) continue;
+            grid.add(positionToArray(Position(q, r, -q - r)), 1);
+            if((state >> 16) % 7 < 4) sources.push_back(Position(q, r, -q - r));
+        }
+    BOOST_REQUIRE(sources.size() > 16384);
+    for(bool nearest : {false, true}){
+        auto single = grid.distances(sources, nearest, 1);
+        auto parallel = grid.distances(sources, nearest, 4);
+        BOOST_REQUIRE_EQUAL(single.size(), parallel.size());
+        auto cell = parallel.getCells().begin();
+        for(auto const& [pos, value] : single.getCells()){
+            BOOST_CHECK(pos == cell->first);
+            BOOST_CHECK_EQUAL(get<int>(value), get<int>(cell->second));
+            ++cell;
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_distances_match_hex_distance_on_open_grid)
+{
+    auto grid = Hexgrid();
+    for(int q = -10; q <= 10; q++)
+        for(int r = -10; r <= 10; r++)
+            if(abs(q + r) <= 10) grid.add(positionToArray(Position(q, r, -q - r)), string("open"));
+    auto sources = vector<Position>{Position(-10, 0, 10), Position(3, 3, -6), Position(7, -7, 0)};
+    auto steps = grid.distances(sources);
+    auto owner = grid.distances(sources, true);
+    BOOST_CHECK_EQUAL(steps.size(), grid.size());
+    for(auto const& [pos, value] : steps.getCells()){
+        long long best = hexDistance(pos, sources[0]);
+        int closest = 0;
+        for(int i = 1; i < 3; i++)
+            if(hexDistance(pos, sources[i]) < best){
+                best = hexDistance(pos, sources[i]);
+                closest = i;
+            }
+        BOOST_CHECK_EQUAL(get<int>(value), best);
+        BOOST_CHECK_EQUAL(get<int>(owner.on(pos)), closest);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_neighbour_reductions)
+{
+    interpret_text("hexgrid x = <1 at [0, 0, 0], 2 at [1, -1, 0], 3 at [0, 1, -1], 4 at [-1, 0, 1], 9 at [5, -5, 0]>;"
+                   "hexgrid sums = neighbour_sum(x);"
+                   "hexgrid lows = neighbour_min(x);"
+                   "hexgrid highs = neighbour_max(x);"
+                   "hexgrid counts = neighbour_count(x);");
+    BOOST_CHECK_EQUAL(get<Hexgrid>(interpreter.getValue("sums")).toString(),
+                      "< 1 at [-1, 0, 1], 9 at [0, 0, 0], 1 at [0, 1, -1], 1 at [1, -1, 0], 0 at [5, -5, 0], >");
+    BOOST_CHECK_EQUAL(get<Hexgrid>(interpreter.getValue("lows")).toString(),
+                      "< 1 at [-1, 0, 1], 2 at [0, 0, 0], 1 at [0, 1, -1], 1 at [1, -1, 0], >");
+    BOOST_CHECK_EQUAL(get<Hexgrid>(interpreter.getValue("highs")).toString(),
+                      "< 1 at [-1, 0, 1], 4 at [0, 0, 0], 1 at [0, 1, -1], 1 at [1, -1, 0], >");
+    BOOST_CHECK_EQUAL(get<Hexgrid>(interpreter.getValue("counts")).toString(),
+                      "< 1 at [-1, 0, 1], 3 at [0, 0, 0], 1 at [0, 1, -1], 1 at [1, -1, 0], 0 at [5, -5, 0], >");
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_neighbour_reductions_over_decimals)
+{
+    interpret_text("hexgrid x = <1 at [0, 0, 0], 0.5 at [1, -1, 0], 2 at [0, 1, -1]>;"
+                   "hexgrid sums = neighbour_sum(x);");
+    auto sums = get<Hexgrid>(interpreter.getValue("sums"));
+    BOOST_CHECK_EQUAL(get<double>(sums.on(Position(0, 0, 0))), 2.5);
+    BOOST_CHECK_EQUAL(get<double>(sums.on(Position(1, -1, 0))), 1.0);
+    BOOST_CHECK_THROW(interpret_text("hexgrid y = neighbour_max(<\"a\" at [0, 0, 0]>);"), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_neighbour_sum_rejects_overflow)
+{
+    auto grid = Hexgrid();
+    grid.add(positionToArray(Position(0, 0, 0)), 0);
+    grid.add(positionToArray(Position(1, -1, 0)), numeric_limits<int>::max());
+    grid.add(positionToArray(Position(0, -1, 1)), 1);
+    BOOST_CHECK_THROW(grid.neighbourhood(Reduction::Sum), std::runtime_error);
+    grid.add(positionToArray(Position(-1, 0, 1)), -1);
+    auto sums = grid.neighbourhood(Reduction::Sum);
+    BOOST_CHECK_EQUAL(get<int>(sums.on(Position(0, 0, 0))), numeric_limits<int>::max());
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_neighbour_sum_agrees_with_beside)
+{
+    auto grid = Hexgrid();
+    unsigned state = 99;
+    for(int q = -8; q <= 8; q++)
+        for(int r = -8; r <= 8; r++){
+            state = state * 1103515245 + 12345;
+            if(abs(q + r) <= 8 && (state >> 16) % 4) grid.add(positionToArray(Position(q, r, -q - r)), int(state >> 16) % 10);
+        }
+    auto sums = grid.neighbourhood(Reduction::Sum);
+    auto counts = grid.neighbourhood(Reduction::Count);
+    for(auto const& [q, r, s] : grid.getKeys()){
+        auto beside = get<Array>(grid.beside(q, r, s));
+        int total = 0;
+        for(int i = 0; i < beside.size(); i++) total += get<int>(grid.on(Hexgrid::arrayToTuple(beside.get(i))));
+        BOOST_CHECK_EQUAL(get<int>(sums.on(Position(q, r, s))), total);
+        BOOST_CHECK_EQUAL(get<int>(counts.on(Position(q, r, s))), beside.size());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_step_birth_and_survival)
+{
+    // A dead centre with three living neighbours is born, living cells
+    // with one living neighbour die, the wall stays.
+    interpret_text("hexgrid x = <0 at [0, 0, 0], 1 at [1, -1, 0], 1 at [-1, 1, 0], 1 at [0, -1, 1],"
+                   "             0 at [1, 0, -1], \"wall\" at [0, 1, -1]>;"
+                   "hexgrid next = step(x, [3], [2]);"
+                   "hexgrid named = step(x, [3], [2], 1, 0);");
+    BOOST_CHECK_EQUAL(get<Hexgrid>(interpreter.getValue("next")).toString(),
+                      "< 0 at [-1, 1, 0], 0 at [0, -1, 1], 1 at [0, 0, 0], wall at [0, 1, -1], "
+                      "0 at [1, -1, 0], 0 at [1, 0, -1], >");
+    BOOST_CHECK_EQUAL(get<Hexgrid>(interpreter.getValue("named")).toString(),
+                      get<Hexgrid>(interpreter.getValue("next")).toString());
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_step_with_rule_function)
+{
+    interpret_text("int calls = 0;"
+                   "func string rule(string value, int living)"
+                   "{"
+                   "    calls = calls + 1;"
+                   "    string next = value;"
+                   "    if (living >= 2) { next = \"fire\"; }"
+                   "    return next;"
+                   "}"
+                   "hexgrid x = <\"fire\" at [0, 0, 0], \"fire\" at [1, -1, 0], \"tree\" at [0, -1, 1],"
+                   "             \"tree\" at [1, -2, 1], \"tree\" at [5, -5, 0], \"tree\" at [6, -6, 0]>;"
+                   "hexgrid burnt = step(x, \"rule\", \"fire\");");
+    BOOST_CHECK_EQUAL(get<Hexgrid>(interpreter.getValue("burnt")).toString(),
+                      "< fire at [0, -1, 1], fire at [0, 0, 0], tree at [1, -2, 1], "
+                      "fire at [1, -1, 0], tree at [5, -5, 0], tree at [6, -6, 0], >");
+    // fire with 1, tree with 2, tree with 1, tree with 0.
+    BOOST_CHECK_EQUAL(get<int>(interpreter.getValue("calls")), 4);
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_step_treats_negative_zero_as_zero)
+{
+    auto board = Hexgrid();
+    board.add(positionToArray(Position(0, 0, 0)), 0.0);
+    board.add(positionToArray(Position(5, -5, 0)), -0.0);
+    int calls = 0;
+    auto next = board.step(1.0, [&](const Var& value, int) -> Var { calls++; return value; });
+    BOOST_CHECK_EQUAL(calls, 1);
+    BOOST_CHECK_EQUAL(next.size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_step_agrees_across_threads)
+{
+    auto board = Hexgrid();
+    unsigned state = 4242;
+    for(int q = -30; q <= 30; q++)
+        for(int r = -30; r <= 30; r++){
+            state = state * 1103515245 + 12345;
+            if(abs(q + r) <= 30) board.add(positionToArray(Position(q, r, -q - r)), int(state >> 16) % 2);
+        }
+    auto rule = [](const Var& value, int living) -> Var {
+        return get<int>(value) ? int(living == 2) : int(living == 2 || living == 3);
+    };
+    auto single = board.step(1, rule, 1).toString();
+    BOOST_CHECK_EQUAL(board.step(1, rule, 4).toString(), single);
+    BOOST_CHECK(single != board.toString());
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_builtin_argument_checks)
+{
+    BOOST_CHECK_THROW(interpret_text("array a = flood([0, 0, 0]);"), std::runtime_error);
+    BOOST_CHECK_THROW(interpret_text("array b = flood(1, [0, 0, 0]);"), std::runtime_error);
+    BOOST_CHECK_THROW(interpret_text("array c = no_such_function(1);"), hexgrid_errors::FunctionIsNotDefined);
+    BOOST_CHECK_THROW(interpret_text("hexgrid d = step(<1 at [0, 0, 0]>, [7], [2]);"), std::runtime_error);
+    BOOST_CHECK_THROW(interpret_text("hexgrid e = step(<1 at [0, 0, 0]>, \"no_rule\", 1);"),
+                      hexgrid_errors::FunctionIsNotDefined);
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_visible_stops_at_occupied_cells)
+{
+    interpret_text("hexgrid x = <\"wall\" at [2, 0, -2], \"unit\" at [0, 0, 0], \"unit\" at [4, 0, -4]>;"
+                   "int blocked = visible from [0, 0, 0] to [4, 0, -4] in x;"
+                   "int open = visible from [0, 0, 0] to [0, 4, -4] in x;"
+                   "int next = visible from [0, 0, 0] to [1, 0, -1] in x;"
+                   "int self = visible from [0, 0, 0] to [0, 0, 0] in x;");
+    BOOST_CHECK_EQUAL(get<int>(interpreter.getValue("blocked")), 0);
+    BOOST_CHECK_EQUAL(get<int>(interpreter.getValue("open")), 1);
+    BOOST_CHECK_EQUAL(get<int>(interpreter.getValue("next")), 1);
+    BOOST_CHECK_EQUAL(get<int>(interpreter.getValue("self")), 1);
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_line_builtin)
+{
+    interpret_text("array cells = line([0, 0, 0], [2, 0, -2]);");
+    BOOST_CHECK_EQUAL(get<Array>(interpreter.getValue("cells")).toString(),
+                      "[ [ 0, 0, 0, ], [ 1, 0, -1, ], [ 2, 0, -2, ], ]");
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_fov_sees_everything_in_open_space)
+{
+    auto grid = Hexgrid();
+    auto seen = vector<Position>();
+    grid.fieldOfView(Position(1, 1, -2), 4, [&](const Position& pos){ seen.push_back(pos); });
+    BOOST_CHECK_EQUAL(seen.size(), hexCount(4));
+    sort(seen.begin(), seen.end());
+    BOOST_CHECK(adjacent_find(seen.begin(), seen.end()) == seen.end());
+    for(auto const& pos : seen) BOOST_CHECK(hexDistance(pos, Position(1, 1, -2)) <= 4);
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_fov_is_blocked_by_occupied_cells)
+{
+    interpret_text("hexgrid x = <\"rock\" at [1, 0, -1], \"rock\" at [0, 0, 0]>;"
+                   "array seen = fov(x, [0, 0, 0], 3);"
+                   "int behind = 0;"
+                   "int rock = 0;"
+                   "foreach array pos in fov(x, [0, 0, 0], 3) {"
+                   "    if (pos[1] == 0 and pos[0] >= 2) { behind = behind + 1; }"
+                   "    if (pos[1] == 0 and pos[0] == 1) { rock = rock + 1; }"
+                   "}");
+    BOOST_CHECK_EQUAL(get<int>(interpreter.getValue("behind")), 0);
+    BOOST_CHECK_EQUAL(get<int>(interpreter.getValue("rock")), 1);
+    auto seen = get<Array>(interpreter.getValue("seen"));
+    BOOST_CHECK_EQUAL(seen.toString().substr(0, 14), "[ [ 0, 0, 0, ]");
+    BOOST_CHECK(seen.size() < int(hexCount(3)) - 2);
+    BOOST_CHECK(seen.size() > int(hexCount(2)));
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_fov_agrees_with_line_of_sight_off_edges)
+{
+    // A sparse field of rocks; wherever the sight line doesn't graze a
+    // cell edge both must agree that a cell is hidden behind a rock.
+    auto grid = Hexgrid();
+    for(auto const& rock : {Position(2, -1, -1), Position(-1, 3, -2), Position(0, -3, 3)})
+        grid.add(positionToArray(rock), string("rock"));
+    auto seen = set<Position>();
+    grid.fieldOfView(Position(0, 0, 0), 6, [&](const Position& pos){ seen.insert(pos); });
+    BOOST_CHECK(!seen.count(Position(4, -2, -2)));
+    BOOST_CHECK(!seen.count(Position(-2, 6, -4)));
+    BOOST_CHECK(!seen.count(Position(0, -5, 5)));
+    BOOST_CHECK(!grid.visible(Position(0, 0, 0), Position(4, -2, -2)));
+    BOOST_CHECK(seen.count(Position(4, -1, -3)) == grid.visible(Position(0, 0, 0), Position(4, -1, -3)));
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_parallel_foreach_reductions)
+{
+    auto grid = Hexgrid();
+    int total = 0, threes = 0, lowest = 1000, highest = -1;
+    for(int i = 0; i < 700; i++){
+        int value = (i * 37) % 101;
+        grid.add(positionToArray(Position(i, -i, 0)), value);
+        total += value;
+        threes += value == 3;
+        lowest = min(lowest, value);
+        highest = max(highest, value);
+    }
+    for(unsigned threads : {1u, 4u}){
+        interpreter = Interpreter();
+        interpreter.setThreads(threads);
+        interpreter.declare(5, "grid");
+        interpreter.assign("grid", grid);
+        interpret_text("func int twice(int x) { return x * 2; }"
+                       "int total = 0; int threes = 0; int lowest = 1000; int highest = -1;"
+                       "parallel foreach array pos in grid sum total, count threes, min lowest, max highest"
+                       "{"
+                       "    int value = grid on pos;"
+                       "    total = total + twice(value);"
+                       "    if (value == 3) { threes = threes + 1; }"
+                       "    if (value < lowest) { lowest = value; }"
+                       "    if (value > highest) { highest = value; }"
+                       "}");
+        BOOST_CHECK_EQUAL(get<int>(interpreter.getValue("total")), 2 * total);
+        BOOST_CHECK_EQUAL(get<int>(interpreter.getValue("threes")), threes);
+        BOOST_CHECK_EQUAL(get<int>(interpreter.getValue("lowest")), lowest);
+        BOOST_CHECK_EQUAL(get<int>(interpreter.getValue("highest")), highest);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_parallel_foreach_runs_chunks_on_pool)
+{
+    auto grid = Hexgrid();
+    for(int i = 0; i < 1000; i++) grid.add(positionToArray(Position(i, -i, 0)), i);
+    interpreter = Interpreter();
+    BOOST_CHECK_EQUAL(interpreter.getPoolStats().tasks, 0u);
+    interpreter.setThreads(3);
+    interpreter.declare(5, "grid");
+    interpreter.assign("grid", grid);
+    interpret_text("int total = 0;"
+                   "parallel foreach array pos in grid sum total { int value = grid on pos; total = total + value; }");
+    BOOST_CHECK_EQUAL(get<int>(interpreter.getValue("total")), 999 * 500);
+    auto stats = interpreter.getPoolStats();
+    BOOST_CHECK_EQUAL(stats.threads, 3u);
+    // 1000 elements make 4 chunks.
+    BOOST_CHECK_EQUAL(stats.tasks, 4u);
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_parallel_foreach_sums_alike_on_any_thread_count)
+{
+    auto sums = set<double>();
+    for(unsigned threads : {1u, 2u, 3u, 8u}){
+        interpreter = Interpreter();
+        interpreter.setThreads(threads);
+        interpret_text("hexgrid grid = <0 at [0, 0, 0]>;"
+                       "foreach int i in [1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20] {"
+                       "    foreach int j in [1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30] {"
+                       "        add 0 to grid at [i, j, 0 - i - j];"
+                       "    }"
+                       "}"
+                       "float total = 0.1;"
+                       "parallel foreach array pos in grid sum total { total = total + 1.0 / (pos[0] * 7 + pos[1] + 1); }");
+        sums.insert(get<double>(interpreter.getValue("total")));
+    }
+    BOOST_CHECK_EQUAL(sums.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_parallel_foreach_throws_on_overflowing_sum)
+{
+    // Each of the two chunks sums to 2000000000, their merge doesn't fit.
+    auto values = Array();
+    for(int i = 0; i < 512; i++) values.add(i == 0 || i == 511 ? 2000000000 : 0);
+    for(unsigned threads : {1u, 4u}){
+        interpreter = Interpreter();
+        interpreter.setThreads(threads);
+        interpreter.declare(4, "values");
+        interpreter.assign("values", values);
+        BOOST_CHECK_THROW(interpret_text("int total = 0;"
+                                         "parallel foreach int value in values sum total { total = total + value; }"),
+                          runtime_error);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_parallel_foreach_from_threads_sharing_a_pool)
+{
+    // Both threads run tasks as slot 0 of the pool, each also those the
+    // other queued.
+    auto pool = make_shared<ThreadPool>(3);
+    auto grid = Hexgrid();
+    for(int i = 0; i < 3000; i++) grid.add(positionToArray(Position(i, -i, 0)), i % 7);
+    istringstream in("int total = 0;"
+                     "parallel foreach array pos in grid sum total { int value = grid on pos; total = total + value; }"
+                     "return total;");
+    auto program = Parser(std::make_unique<Lexer>(in)).parse();
+    auto outputs = vector<ostringstream>(2);
+    auto threads = vector<thread>();
+    for(auto& output : outputs)
+        threads.emplace_back([&]{
+            auto own = Interpreter();
+            own.setPool(pool);
+            own.setOutput(output);
+            own.declare(5, "grid");
+            own.assign("grid", grid);
+            for(int run = 0; run < 40; run++) program->accept(own);
+        });
+    for(auto& thread : threads) thread.join();
+    int total = 0;
+    for(int i = 0; i < 3000; i++) total += i % 7;
+    auto expected = string();
+    for(int run = 0; run < 40; run++) expected += to_string(total) + "\n";
+    for(auto const& output : outputs) BOOST_CHECK_EQUAL(output.str(), expected);
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_parallel_foreach_rejects_side_effects)
+{
+    auto run = [&](const string& body){
+        interpreter = Interpreter();
+        interpreter.setThreads(2);
+        interpret_text("int total = 0; int other = 0; int lowest = 0;"
+                       "func int bump() { other = other + 1; return other; }"
+                       "parallel foreach int i in [1, 2, 3] sum total, min lowest { " + body + " }");
+    };
+    BOOST_CHECK_NO_THROW(run("int local = i; local = local + 1; total = total + local;"));
+    BOOST_CHECK_NO_THROW(run("lowest = i; lowest = lowest - 1;"));
+    BOOST_CHECK_THROW(run("other = i;"), std::runtime_error);
+    BOOST_CHECK_THROW(run("total = i;"), std::runtime_error);
+    BOOST_CHECK_THROW(run("int copy = total;"), std::runtime_error);
+    BOOST_CHECK_THROW(run("total = total + bump();"), std::runtime_error);
+    BOOST_CHECK_THROW(run("return i;"), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_parallel_foreach_checks_step_rules)
+{
+    auto run = [&](const string& body){
+        interpreter = Interpreter();
+        interpreter.setThreads(2);
+        interpret_text("int total = 0; int calls = 0; string name = \"keep\"; hexgrid board = <1 at [0, 0, 0]>;"
+                       "func int keep(int value, int living) { return value; }"
+                       "func int spy(int value, int living) { calls = calls + 1; return value; }"
+                       "parallel foreach int i in [1, 2, 3] sum total { " + body + " }");
+    };
+    BOOST_CHECK_NO_THROW(run("hexgrid next = step(board, \"keep\", 1); int kept = next on [0, 0, 0]; total = total + kept;"));
+    BOOST_CHECK_NO_THROW(run("hexgrid next = step(board, [3], [2]);"));
+    BOOST_CHECK_THROW(run("hexgrid next = step(board, \"spy\", 1);"), std::runtime_error);
+    BOOST_CHECK_THROW(run("hexgrid next = step(board, name, 1);"), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(interpreter_parallel_foreach_moves_without_target)
+{
+    interpreter = Interpreter();
+    interpreter.setThreads(2);
+    interpret_text("int total = 0;"
+                   "parallel foreach int i in [1, 2] sum total {"
+                   "    hexgrid a = <i at [0, 0, 0]>; int taken = 0;"
+                   "    move [0, 0, 0] from a to taken;"
+                   "    total = total + taken;"
+                   "}");
+    BOOST_CHECK_EQUAL(get<int>(interpreter.getValue("total")), 3);
+}
 
 BOOST_AUTO_TEST_CASE(interpreter_if_statement)
 {
@@ -577,7 +1195,7 @@ BOOST_AUTO_TEST_CASE(interpreter_add_statement)
                     "add \"test2\" to a at [1, 0, -1];      \n");
     auto a = get<Hexgrid>(interpreter.getValue("a"));
     auto test2 = a.on(1, 0, -1);
-    BOOST_CHECK_EQUAL(get<string>(test2), "test2");
+    BOOST_CHECK_EQUAL(get<Symbol>(test2).str(), "test2");
 }
 
 bool interpreter_remove_statement_correct_msg(const runtime_error ex){
@@ -591,6 +1209,22 @@ BOOST_AUTO_TEST_CASE(interpreter_remove_statement)
         BOOST_CHECK_EXCEPTION(a.on(1, -1, 0), std::runtime_error,
             interpreter_remove_statement_correct_msg);
 }
+BOOST_AUTO_TEST_CASE(interpreter_copies_of_values_are_independent)
+{
+    BOOST_CHECK_LE(sizeof(Var), 16u);
+    interpret_text("hexgrid a = <\"test\" at [1, -1, 0]>; hexgrid b = a; hexgrid c = a;\n"
+                   "add 2 to b at [0, 0, 0]; remove [1, -1, 0] from c;\n"
+                   "array x = [1, 2]; array y = x;");
+    auto a = get<Hexgrid>(interpreter.getValue("a"));
+    BOOST_CHECK_EQUAL(a.size(), 1);
+    BOOST_CHECK_EQUAL(get<Symbol>(a.on(1, -1, 0)).str(), "test");
+    BOOST_CHECK_EQUAL(get<Hexgrid>(interpreter.getValue("b")).size(), 2);
+    BOOST_CHECK_EQUAL(get<Hexgrid>(interpreter.getValue("c")).size(), 0);
+    auto y = get<Array>(interpreter.getValue("y"));
+    y.add(3);
+    BOOST_CHECK_EQUAL(y.size(), 3);
+    BOOST_CHECK_EQUAL(get<Array>(interpreter.getValue("x")).size(), 2);
+}
 BOOST_AUTO_TEST_CASE(interpreter_move_statement_hexgrid)
 {
         interpret_text( "hexgrid a = <\"test\" at [1, -1, 0]>; \n"
@@ -599,7 +1233,7 @@ BOOST_AUTO_TEST_CASE(interpreter_move_statement_hexgrid)
         auto a = get<Hexgrid>(interpreter.getValue("a"));
         auto b = get<Hexgrid>(interpreter.getValue("b"));
         auto test = b.on(2, 0, -2);
-        BOOST_CHECK_EQUAL(get<string>(test), "test");
+        BOOST_CHECK_EQUAL(get<Symbol>(test).str(), "test");
         BOOST_CHECK_EXCEPTION(a.on(1, -1, 0), std::runtime_error,
             interpreter_remove_statement_correct_msg);
 }
@@ -609,7 +1243,7 @@ BOOST_AUTO_TEST_CASE(interpreter_move_statement_string)
                         "string b; \n"
                         "move [1, -1, 0] from a to b;");
         auto a = get<Hexgrid>(interpreter.getValue("a"));
-        auto b = get<string>(interpreter.getValue("b"));
+        auto b = get<Symbol>(interpreter.getValue("b")).str();
         BOOST_CHECK_EQUAL(b, "test");
         BOOST_CHECK_EXCEPTION(a.on(1, -1, 0), std::runtime_error,
             interpreter_remove_statement_correct_msg);
@@ -617,4 +1251,31 @@ BOOST_AUTO_TEST_CASE(interpreter_move_statement_string)
 
 
 
+BOOST_AUTO_TEST_CASE(interpreter_runs_one_program_on_many_threads)
+{
+    std::istringstream in("func int triple(int x) { return x * 3; }"
+                          "int total = 0;"
+                          "foreach int i in [1, 2, 3, 4] { total = total + triple(i); }"
+                          "return total;"
+                          "return \"done\";");
+    auto program = Parser(std::make_unique<Lexer>(in)).parse();
+    auto outputs = vector<ostringstream>(8);
+    // Nothing runs in parallel, so none of them starts a pool.
+    auto poolThreads = vector<unsigned>(outputs.size());
+    auto threads = vector<thread>();
+    for(size_t i = 0; i < outputs.size(); i++)
+        threads.emplace_back([&, i]{
+            auto own = Interpreter();
+            own.setOutput(outputs[i]);
+            for(int run = 0; run < 50; run++) program->accept(own);
+            poolThreads[i] = own.getPoolStats().threads;
+        });
+    for(auto& thread : threads) thread.join();
+    auto expected = string();
+    for(int run = 0; run < 50; run++) expected += "30\ndone\n";
+    for(auto const& output : outputs) BOOST_CHECK_EQUAL(output.str(), expected);
+    for(auto started : poolThreads) BOOST_CHECK_EQUAL(started, 0u);
+    BOOST_CHECK_EQUAL(program->funcs.size(), 1u);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
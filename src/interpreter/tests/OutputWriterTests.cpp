@@ -0,0 +1,84 @@
+#include <sstream>
+#include <boost/test/unit_test.hpp>
+#include <parser/Ast.h>
+#include <lexer/Lexer.h>
+#include "interpreter/Interpreter.h"
+#include "interpreter/OutputWriter.h"
+using namespace ast;
+using namespace lexer;
+using namespace parser;
+using namespace std;
+using namespace intprt;
+
+
+struct OutputWriterTestsFixture
+{
+    Interpreter interpreter = Interpreter();
+
+    std::string printed(const std::string& str)
+    {
+        std::istringstream in(str);
+        std::ostringstream out;
+        auto old = cout.rdbuf(out.rdbuf());
+        Parser p(std::make_unique<Lexer>(in));
+        p.parse()->accept(interpreter);
+        cout.rdbuf(old);
+        return out.str();
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(OutputWriterTests, OutputWriterTestsFixture)
+
+BOOST_AUTO_TEST_CASE(writer_formats_numbers_like_the_standard_library)
+{
+    std::ostringstream out;
+    {
+        OutputWriter writer(out);
+        writer.write(-2147483647).write(' ').writeFixed(2.5).write(' ').writeGeneral(2.5)
+              .write(' ').writeGeneral(1234567.0);
+    }
+    std::ostringstream expected;
+    expected << -2147483647 << ' ' << std::to_string(2.5) << ' ' << 2.5 << ' ' << 1234567.0;
+    BOOST_CHECK_EQUAL(out.str(), expected.str());
+}
+
+BOOST_AUTO_TEST_CASE(writer_flushes_when_buffer_is_full)
+{
+    std::ostringstream out;
+    {
+        OutputWriter writer(out, 1);
+        for(int i = 0; i < 1000; i++) writer.write(i).write(',');
+        writer.write(std::string(5000, 'x'));
+    }
+    std::string expected;
+    for(int i = 0; i < 1000; i++) expected += std::to_string(i) + ",";
+    BOOST_CHECK_EQUAL(out.str(), expected + std::string(5000, 'x'));
+}
+
+BOOST_AUTO_TEST_CASE(return_prints_scalars)
+{
+    BOOST_CHECK_EQUAL(printed("return 12;"), "12\n");
+    BOOST_CHECK_EQUAL(printed("return 2.5;"), "2.5\n");
+    BOOST_CHECK_EQUAL(printed("return \"text\";"), "text\n");
+}
+
+BOOST_AUTO_TEST_CASE(return_prints_nested_array)
+{
+    BOOST_CHECK_EQUAL(printed("return [1, 2.5, \"a\", [3]];"),
+                      "[ 1, 2.500000, a, [ 3, ], ]\n");
+}
+
+BOOST_AUTO_TEST_CASE(return_prints_hexgrid)
+{
+    BOOST_CHECK_EQUAL(printed("return <\"blue\" at [0, 0, 0], [1, 2] at [1, -1, 0]>;"),
+                      "< blue at [0, 0, 0], [ 1, 2, ] at [1, -1, 0], >\n");
+}
+
+BOOST_AUTO_TEST_CASE(to_string_matches_printed_value)
+{
+    printed("hexgrid h = <1.5 at [0, 0, 0], [2, [3]] at [1, 0, -1]>;");
+    auto h = get<Hexgrid>(interpreter.getValue("h"));
+    BOOST_CHECK_EQUAL(h.toString(), "< 1.500000 at [0, 0, 0], [ 2, [ 3, ], ] at [1, 0, -1], >");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,214 @@
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <boost/test/unit_test.hpp>
+#include <parser/Ast.h>
+#include <lexer/Lexer.h>
+#include "interpreter/CompressedGrid.h"
+#include "interpreter/GridFile.h"
+#include "interpreter/PagedGrid.h"
+#include "interpreter/ValueFormat.h"
+using namespace ast;
+using namespace lexer;
+using namespace parser;
+using namespace std;
+using namespace intprt;
+
+
+struct PagedGridTestsFixture
+{
+    const string path = "paged_grid_test.hex";
+
+    ~PagedGridTestsFixture()
+    {
+        remove(path.c_str());
+    }
+
+    // 100 rows of 100 cells, three pages.
+    Hexgrid saveRows()
+    {
+        auto grid = Hexgrid();
+        for(int q = 0; q < 100; q++)
+            for(int r = -50; r < 50; r++){
+                auto pos = positionToArray(Position(q, r, -q - r));
+                if((q + r) % 7 == 0) grid.add(pos, string(q % 2 ? "red" : "blue"));
+                else grid.add(pos, q * 1000 + r);
+            }
+        saveHexgrid(grid, path);
+        return grid;
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(PagedGridTests, PagedGridTestsFixture)
+
+BOOST_AUTO_TEST_CASE(paged_grid_reads_saved_cells)
+{
+    auto grid = saveRows();
+    auto paged = PagedGrid(path, 2);
+    BOOST_REQUIRE_EQUAL(paged.size(), 10000u);
+    BOOST_CHECK_EQUAL(get<int>(paged.on(Position(3, 2, -5))), 3002);
+    BOOST_CHECK_EQUAL(get<Symbol>(paged.on(Position(99, -1, -98))).str(), "red");
+    BOOST_CHECK_EQUAL(get<int>(paged.on(Position(0, -50, 50))), -50);
+    BOOST_CHECK(paged.contains(Position(99, 49, -148)));
+    BOOST_CHECK(!paged.contains(Position(-1, 0, 1)));
+    BOOST_CHECK(!paged.contains(Position(100, 0, -100)));
+    BOOST_CHECK_THROW(paged.on(Position(5, 60, -65)), runtime_error);
+    auto cell = grid.getCells().begin();
+    size_t same = 0;
+    paged.forEach([&](const Position& pos, const Var& value){
+        if(pos == cell->first && value.index() == cell->second.index() &&
+           sameValue(value, cell->second)) same++;
+        ++cell;
+    });
+    BOOST_CHECK_EQUAL(same, 10000u);
+}
+
+BOOST_AUTO_TEST_CASE(paged_grid_counts_hits_and_faults)
+{
+    saveRows();
+    auto paged = PagedGrid(path, 2);
+    auto stats = paged.getStats();
+    BOOST_CHECK_EQUAL(stats.pages, 3u);
+    BOOST_CHECK_EQUAL(stats.faults, 0u);
+    paged.on(Position(0, 0, 0));
+    paged.on(Position(0, 1, -1));
+    paged.on(Position(99, 0, -99));
+    stats = paged.getStats();
+    BOOST_CHECK_EQUAL(stats.faults, 2u);
+    BOOST_CHECK_EQUAL(stats.hits, 1u);
+    // Three pages through a cache of two: each is read again.
+    paged.resetStats();
+    paged.forEach([](const Position&, const Var&){});
+    paged.forEach([](const Position&, const Var&){});
+    stats = paged.getStats();
+    BOOST_CHECK_EQUAL(stats.faults + stats.hits, 6u);
+    BOOST_CHECK_EQUAL(stats.hits, 1u);
+    BOOST_CHECK_EQUAL(stats.cachedPages, 2u);
+}
+
+BOOST_AUTO_TEST_CASE(paged_grid_keeps_text_out_of_symbol_table)
+{
+    auto grid = Hexgrid();
+    for(int q = 0; q < 100; q++)
+        for(int r = 0; r < 100; r++)
+            grid.add(positionToArray(Position(q, r, -q - r)), "xq" + to_string(q * 100 + r));
+    saveHexgrid(grid, path);
+    // Renamed in the file, so that the text read back was never interned.
+    auto bytes = string();
+    {
+        auto in = ifstream(path, ios::binary);
+        bytes.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    }
+    for(auto at = bytes.find("xq0"); at != string::npos; at = bytes.find("xq", at + 2))
+        bytes.replace(at, 2, "zv");
+    ofstream(path, ios::binary | ios::trunc) << bytes;
+    auto symbols = Symbol::count();
+    // 10000 distinct strings walked through a cache of one page.
+    auto paged = PagedGrid(path, 1);
+    size_t owned = 0;
+    paged.forEach([&](const Position& pos, const Var& value){
+        auto const& text = get<Symbol>(value);
+        owned += !text.isInterned() && text.str() == "zv" + to_string(get<0>(pos) * 100 + get<1>(pos));
+    });
+    BOOST_CHECK_EQUAL(owned, 10000u);
+    BOOST_CHECK_EQUAL(paged.getStats().pages, 3u);
+    BOOST_CHECK_EQUAL(Symbol::count(), symbols);
+}
+
+BOOST_AUTO_TEST_CASE(paged_grid_rejects_damaged_files)
+{
+    BOOST_CHECK_THROW(PagedGrid("paged_grid_test_missing.hex", 1), runtime_error);
+    saveRows();
+    auto bytes = string();
+    {
+        ifstream in(path, ios::binary);
+        bytes.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    }
+    // A tag no value has, found when its page is read.
+    bytes[gridfile::Layout{10000, 2, 7}.tagColumn() + 9000] = 9;
+    ofstream(path, ios::binary) << bytes;
+    auto paged = PagedGrid(path, 1);
+    BOOST_CHECK_NO_THROW(paged.on(Position(0, 0, 0)));
+    BOOST_CHECK_THROW(paged.on(Position(99, 0, -99)), runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(paged_grid_written_and_saved_like_loaded_one)
+{
+    auto grid = saveRows();
+    auto paged = Hexgrid::fromPages(make_shared<PagedGrid>(path, 1));
+    auto written = [](const Hexgrid& written, OutputFormat format){
+        auto out = ostringstream();
+        {
+            auto writer = OutputWriter(out);
+            writeValue(writer, written, format);
+        }
+        return out.str();
+    };
+    BOOST_CHECK(written(paged, OutputFormat::Json) == written(grid, OutputFormat::Json));
+    BOOST_CHECK(written(paged, OutputFormat::Binary) == written(grid, OutputFormat::Binary));
+    const string copy = "paged_grid_test_copy.hex", packed = "paged_grid_test_copy.hexz";
+    auto symbols = Symbol::count();
+    saveHexgrid(paged, copy);
+    BOOST_CHECK_EQUAL(Symbol::count(), symbols);
+    BOOST_CHECK(loadHexgrid(copy).toString() == grid.toString());
+    // Ordering the cells for it would need them all at once.
+    ofstream(packed) << "kept";
+    BOOST_CHECK_THROW(saveCompressedHexgrid(paged, packed), runtime_error);
+    auto kept = string();
+    ifstream(packed) >> kept;
+    BOOST_CHECK_EQUAL(kept, "kept");
+    remove(copy.c_str());
+    remove(packed.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(paged_grid_opened_by_scripts)
+{
+    saveRows();
+    istringstream in("hexgrid world = open(\"" + path + "\", 2);"
+                     "int value = world on [3, 2, -5];"
+                     "array near = world beside [0, -50, 50];"
+                     "int count = 0;"
+                     "foreach array pos in world { count = count + 1; }"
+                     "array stats = page_stats(world);");
+    auto interpreter = Interpreter();
+    interpreter.setThreads(1);
+    Parser(make_unique<Lexer>(in)).parse()->accept(interpreter);
+    BOOST_CHECK_EQUAL(get<int>(interpreter.getValue("value")), 3002);
+    BOOST_CHECK_EQUAL(get<Array>(interpreter.getValue("near")).size(), 2);
+    BOOST_CHECK_EQUAL(get<int>(interpreter.getValue("count")), 10000);
+    auto stats = get<Array>(interpreter.getValue("stats"));
+    BOOST_CHECK_EQUAL(get<int>(stats.get(0)), 4);
+    BOOST_CHECK_EQUAL(get<int>(stats.get(1)), 3);
+    istringstream by("hexgrid world = open(\"" + path + "\"); array found = world by 5;");
+    BOOST_CHECK_THROW(Parser(make_unique<Lexer>(by)).parse()->accept(interpreter), runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(paged_grid_walked_a_page_at_a_time_by_parallel_foreach)
+{
+    auto grid = saveRows();
+    int total = 0;
+    grid.forEach([&](const Position&, const Var& value){
+        if(value.index() == 1) total += get<int>(value);
+    });
+    istringstream in("hexgrid world = open(\"" + path + "\", 1);"
+                     "int total = 0;"
+                     "int cells = 0;"
+                     "parallel foreach array pos in world sum total, count cells {"
+                     "    cells = cells + 1;"
+                     "    if ((pos[0] + pos[1]) % 7 != 0) { int value = world on pos; total = total + value; }"
+                     "}"
+                     "array stats = page_stats(world);");
+    auto interpreter = Interpreter();
+    interpreter.setThreads(4);
+    Parser(make_unique<Lexer>(in)).parse()->accept(interpreter);
+    BOOST_CHECK_EQUAL(get<int>(interpreter.getValue("cells")), 10000);
+    BOOST_CHECK_EQUAL(get<int>(interpreter.getValue("total")), total);
+    // Every page is read once: the cells of each are looked up while it
+    // is the one kept, before the next is read.
+    auto stats = get<Array>(interpreter.getValue("stats"));
+    BOOST_CHECK_GT(get<int>(stats.get(0)), 0);
+    BOOST_CHECK_EQUAL(get<int>(stats.get(1)), 3);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,77 @@
+#include <sstream>
+#include <boost/test/unit_test.hpp>
+#include <parser/Ast.h>
+#include <lexer/Lexer.h>
+#include "interpreter/InstrumentedInterpreter.h"
+#include "interpreter/Profiler.h"
+using namespace ast;
+using namespace lexer;
+using namespace parser;
+using namespace std;
+using namespace intprt;
+
+
+struct ProfilerTestsFixture
+{
+    Profiler profiler = Profiler();
+    void profile_text(const std::string& str)
+    {
+        std::istringstream in(str);
+        Parser p(std::make_unique<Lexer>(in));
+        auto interpreter = InstrumentedInterpreter(profiler);
+        p.parse()->accept(interpreter);
+    }
+
+    Profiler::NodeStats find(const std::string& kind, std::pair<int, int> start)
+    {
+        for(auto const& stats : profiler.getStats())
+            if(stats.kind == kind && stats.start == start) return stats;
+        BOOST_FAIL("no stats for " + kind);
+        return {};
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(ProfilerTests, ProfilerTestsFixture)
+
+BOOST_AUTO_TEST_CASE(profiler_counts_loop_body_hits)
+{
+    profile_text("int x = 0;\n"
+                 "foreach int y in [1, 2, 3] {\n"
+                 "  x = x + y;\n"
+                 "}");
+    BOOST_CHECK_EQUAL(find("ForeachStatement", {2, 1}).hits, 1);
+    BOOST_CHECK_EQUAL(find("AssignmentStatement", {3, 3}).hits, 3);
+    BOOST_CHECK_EQUAL(find("AddExpression", {3, 7}).hits, 3);
+}
+
+BOOST_AUTO_TEST_CASE(profiler_inclusive_time_contains_exclusive_time)
+{
+    profile_text("int x = 0; foreach int y in [1, 2, 3] { x = x + y; }");
+    auto stats = profiler.getStats();
+    BOOST_CHECK_EQUAL(stats.front().kind, std::string("Program"));
+    for(auto const& s : stats) BOOST_CHECK(s.exclusive <= s.inclusive);
+}
+
+BOOST_AUTO_TEST_CASE(profiler_counts_recursive_function_once_in_inclusive_time)
+{
+    profile_text("int x = 0;\n"
+                 "func int f(int n){ if (n > 0) { x = x + 1; f(n - 1); } }\n"
+                 "f(3);");
+    auto def = find("FunctionDefinition", {2, 1});
+    BOOST_CHECK_EQUAL(def.hits, 4);
+    BOOST_CHECK(def.inclusive <= find("Program", {1, 1}).inclusive);
+}
+
+BOOST_AUTO_TEST_CASE(profiler_collapsed_stacks_start_at_program)
+{
+    profile_text("int x = 0; foreach int y in [1, 2, 3] { x = x + y; }");
+    std::stringstream out;
+    profiler.writeCollapsedStacks(out);
+    std::string line;
+    while(std::getline(out, line)){
+        BOOST_CHECK_EQUAL(line.rfind("Program(1:1)", 0), 0);
+        BOOST_CHECK(line.find(' ') != std::string::npos);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,113 @@
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <boost/test/unit_test.hpp>
+#include <dirent.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "interpreter/Server.h"
+using namespace std;
+using namespace intprt;
+
+namespace{
+    const char* socketPath = "server_test.sock";
+
+    // Without ending the request when end is false.
+    string request(const string& script, bool end = true){
+        int client = socket(AF_UNIX, SOCK_STREAM, 0);
+        auto address = sockaddr_un();
+        address.sun_family = AF_UNIX;
+        strncpy(address.sun_path, socketPath, sizeof address.sun_path - 1);
+        if(connect(client, reinterpret_cast<sockaddr*>(&address), sizeof address) < 0){
+            close(client);
+            return "no connection";
+        }
+        for(size_t sent = 0; sent < script.size();){
+            auto written = write(client, script.data() + sent, script.size() - sent);
+            if(written <= 0) break;
+            sent += size_t(written);
+        }
+        if(end) shutdown(client, SHUT_WR);
+        auto reply = string();
+        char buffer[4096];
+        for(ssize_t got; (got = read(client, buffer, sizeof buffer)) > 0;) reply.append(buffer, size_t(got));
+        close(client);
+        return reply;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(ServerTests)
+
+BOOST_AUTO_TEST_CASE(server_keeps_globals_between_requests)
+{
+    unlink(socketPath);
+    auto server = Server(socketPath);
+    server.getInterpreter().setThreads(1);
+    auto serving = thread([&]{ server.serve(); });
+    BOOST_CHECK_EQUAL(request("hexgrid world = <\"blue\" at [0, 0, 0], \"red\" at [1, -1, 0], \"blue\" at [2, -2, 0]>;"), "");
+    BOOST_CHECK_EQUAL(request("return world on [1, -1, 0];"), "red\n");
+    BOOST_CHECK_EQUAL(request("array found = world by \"blue\"; return found[1];"), "[ 2, -2, 0, ]\n");
+    server.stop();
+    serving.join();
+}
+
+BOOST_AUTO_TEST_CASE(server_recovers_from_failed_requests)
+{
+    unlink(socketPath);
+    auto server = Server(socketPath);
+    server.getInterpreter().setThreads(1);
+    BOOST_CHECK_EQUAL(server.handle("int total = 5;"), "");
+    auto failed = server.handle("func int broken(int x) { int y = missing + x; return y; } return broken(total);");
+    BOOST_CHECK_EQUAL(failed.rfind("error: ", 0), 0u);
+    BOOST_CHECK_EQUAL(server.handle("return 3 +;").rfind("error: ", 0), 0u);
+    BOOST_CHECK_EQUAL(server.handle("return total + 1;"), "6\n");
+    // Functions last for their request.
+    BOOST_CHECK_EQUAL(server.handle("return broken(1);").rfind("error: ", 0), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(server_answers_unended_requests_after_timeout)
+{
+    unlink(socketPath);
+    auto server = Server(socketPath, chrono::milliseconds(200));
+    server.getInterpreter().setThreads(1);
+    auto serving = thread([&]{ server.serve(); });
+    BOOST_CHECK_EQUAL(request("int total = 2; return total;", false), "error: the request wasn't ended in time\n");
+    BOOST_CHECK_EQUAL(request("return 1 + 1;"), "2\n");
+    server.stop();
+    serving.join();
+}
+
+BOOST_AUTO_TEST_CASE(server_answers_requests_cut_short_by_stop)
+{
+    unlink(socketPath);
+    auto server = Server(socketPath);
+    server.getInterpreter().setThreads(1);
+    auto serving = thread([&]{ server.serve(); });
+    auto reply = string();
+    auto client = thread([&]{ reply = request("return 1;", false); });
+    // Stopped while it waits for the rest of the request.
+    this_thread::sleep_for(chrono::milliseconds(200));
+    server.stop();
+    client.join();
+    serving.join();
+    BOOST_CHECK_EQUAL(reply, "error: the server is stopping\n");
+}
+
+BOOST_AUTO_TEST_CASE(server_refuses_taken_path)
+{
+    unlink(socketPath);
+    auto first = Server(socketPath);
+    auto openFiles = [](){
+        auto count = 0;
+        auto listing = opendir("/proc/self/fd");
+        while(readdir(listing)) count++;
+        closedir(listing);
+        return count;
+    };
+    auto before = openFiles();
+    BOOST_CHECK_THROW(Server{socketPath}.stop(), runtime_error);
+    BOOST_CHECK_EQUAL(openFiles(), before);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include <lexer/Lexer.h>
+#include <parser/Parser.h>
+#include "interpreter/Interpreter.h"
+using namespace lexer;
+using namespace parser;
+using namespace std;
+using namespace intprt;
+
+BOOST_AUTO_TEST_SUITE(SymbolTests)
+
+BOOST_AUTO_TEST_CASE(symbols_of_equal_text_are_equal)
+{
+    auto blue = Symbol("blue");
+    BOOST_CHECK(blue == Symbol(string("bl") + "ue"));
+    BOOST_CHECK(blue != Symbol("red"));
+    BOOST_CHECK_EQUAL(blue.str(), "blue");
+    BOOST_CHECK_EQUAL(blue.size(), 4u);
+    BOOST_CHECK_EQUAL(Symbol().str(), "");
+    BOOST_CHECK(Symbol() == Symbol(""));
+    auto joined = blue;
+    joined += Symbol("bird");
+    BOOST_CHECK(joined == Symbol("bluebird"));
+    BOOST_CHECK_EQUAL(blue.str(), "blue");
+}
+
+BOOST_AUTO_TEST_CASE(symbols_are_small_values)
+{
+    BOOST_CHECK_EQUAL(sizeof(Symbol), sizeof(void*));
+    auto value = Var(string("green"));
+    BOOST_REQUIRE_EQUAL(value.index(), 3u);
+    BOOST_CHECK(get<Symbol>(value) == Symbol("green"));
+}
+
+BOOST_AUTO_TEST_CASE(joined_symbols_are_not_interned)
+{
+    auto joined = Symbol("sea"), letter = Symbol("s"), other = Symbol("see");
+    auto before = Symbol::count();
+    for(int i = 0; i < 100; i++) joined += letter;
+    BOOST_CHECK(!joined.isInterned());
+    BOOST_CHECK_EQUAL(joined.size(), 103u);
+    BOOST_CHECK_EQUAL(Symbol::count(), before);
+    auto copy = joined;
+    BOOST_CHECK(copy == joined);
+    BOOST_CHECK(Symbol::owned("sea") == Symbol("sea"));
+    BOOST_CHECK(Symbol::owned("sea") != other);
+    BOOST_CHECK_EQUAL(Symbol::owned("sea").hash(), Symbol("sea").hash());
+    auto interned = joined.interned();
+    BOOST_CHECK(interned.isInterned());
+    BOOST_CHECK(interned == joined);
+    BOOST_CHECK_EQUAL(Symbol::count(), before + 1);
+}
+
+BOOST_AUTO_TEST_CASE(strings_built_by_scripts_are_not_kept)
+{
+    auto interpreter = Interpreter();
+    auto run = [&](const string& script){
+        istringstream in(script);
+        Parser(make_unique<Lexer>(in)).parse()->accept(interpreter);
+    };
+    run("string s = \"cell\"; foreach int i in [1, 2, 3] { s = s + \"x\"; }");
+    auto before = Symbol::count();
+    run("string t = \"\"; foreach int i in [1, 2, 3, 4, 5, 6, 7, 8, 9, 10] { t = t + \"x\"; }"
+        "hexgrid grid = <\"cell\" at [0, 0, 0]>; add t to grid at [1, -1, 0];");
+    // Only the cell holding t keeps it.
+    BOOST_CHECK_EQUAL(Symbol::count(), before + 1);
+    BOOST_CHECK_EQUAL(get<Symbol>(interpreter.getValue("t")).str(), "xxxxxxxxxx");
+}
+
+BOOST_AUTO_TEST_CASE(hexgrid_cells_hold_interned_text)
+{
+    auto grid = Hexgrid();
+    grid.add(positionToArray(Position(0, 0, 0)), Symbol::owned("cell text"));
+    auto value = grid.on(Position(0, 0, 0));
+    BOOST_CHECK(get<Symbol>(value).isInterned());
+    BOOST_CHECK_EQUAL(get<Symbol>(value).str(), "cell text");
+}
+
+BOOST_AUTO_TEST_CASE(symbols_interned_on_many_threads_agree)
+{
+    const int threads = 4, words = 3000;
+    // Each thread interns the same words, starting at a different one.
+    auto ids = vector<vector<uint32_t>>(threads, vector<uint32_t>(words));
+    auto running = vector<thread>();
+    for(int t = 0; t < threads; t++)
+        running.emplace_back([&, t]{
+            for(int i = 0; i < words; i++){
+                int word = (i + t * words / threads) % words;
+                ids[t][word] = Symbol("thread word " + to_string(word)).id();
+            }
+        });
+    for(auto& t : running) t.join();
+    for(int t = 1; t < threads; t++) BOOST_CHECK(ids[t] == ids[0]);
+    auto distinct = ids[0];
+    sort(distinct.begin(), distinct.end());
+    BOOST_CHECK(unique(distinct.begin(), distinct.end()) == distinct.end());
+    BOOST_CHECK_EQUAL(Symbol("thread word 7").id(), ids[0][7]);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,135 @@
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <time.h>
+#include <boost/test/unit_test.hpp>
+#include "interpreter/Parallel.h"
+#include "interpreter/ThreadPool.h"
+using namespace std;
+using namespace intprt;
+
+BOOST_AUTO_TEST_SUITE(ThreadPoolTests)
+
+BOOST_AUTO_TEST_CASE(runs_every_task_once)
+{
+    auto pool = ThreadPool(4);
+    auto runs = vector<atomic<int>>(1000);
+    auto badSlots = atomic<int>(0);
+    pool.run(runs.size(), [&](size_t i, unsigned slot){
+        badSlots += slot >= 4;
+        runs[i]++;
+    });
+    BOOST_CHECK_EQUAL(badSlots, 0);
+    for(auto const& count : runs) BOOST_CHECK_EQUAL(count, 1);
+    BOOST_CHECK_EQUAL(pool.getStats().tasks, 1000u);
+}
+
+BOOST_AUTO_TEST_CASE(pool_of_one_runs_on_caller)
+{
+    auto pool = ThreadPool(1);
+    auto caller = this_thread::get_id();
+    pool.run(10, [&](size_t, unsigned slot){
+        BOOST_CHECK_EQUAL(slot, 0u);
+        BOOST_CHECK(this_thread::get_id() == caller);
+    });
+    BOOST_CHECK_EQUAL(pool.getStats().steals, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(rethrows_task_exception)
+{
+    auto pool = ThreadPool(3);
+    auto runs = atomic<int>(0);
+    BOOST_CHECK_THROW(pool.run(50, [&](size_t i, unsigned){
+        runs++;
+        if(i == 7) throw runtime_error("task failed");
+    }), runtime_error);
+    BOOST_CHECK_EQUAL(runs, 50);
+    // Still usable afterwards.
+    pool.run(5, [&](size_t, unsigned){ runs++; });
+    BOOST_CHECK_EQUAL(runs, 55);
+}
+
+BOOST_AUTO_TEST_CASE(tasks_run_nested_tasks)
+{
+    auto pool = ThreadPool(3);
+    auto sum = atomic<int>(0);
+    pool.run(8, [&](size_t, unsigned){
+        pool.run(8, [&](size_t i, unsigned){ sum += int(i); });
+    });
+    BOOST_CHECK_EQUAL(sum, 8 * 28);
+    BOOST_CHECK_EQUAL(pool.getStats().tasks, 8u + 64u);
+}
+
+BOOST_AUTO_TEST_CASE(idle_threads_steal)
+{
+    auto pool = ThreadPool(4);
+    pool.run(64, [](size_t, unsigned){ this_thread::sleep_for(chrono::milliseconds(2)); });
+    auto stats = pool.getStats();
+    BOOST_CHECK_GT(stats.steals, 0u);
+    BOOST_CHECK_GT(stats.busySeconds, 0.1);
+    BOOST_CHECK_GT(stats.utilization(), 0);
+    pool.resetStats();
+    BOOST_CHECK_EQUAL(pool.getStats().tasks, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(waiting_caller_sleeps)
+{
+    auto pool = ThreadPool(2);
+    auto cpuTime = [](){
+        timespec now;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+        return chrono::seconds(now.tv_sec) + chrono::nanoseconds(now.tv_nsec);
+    };
+    auto stolen = atomic<bool>(false);
+    auto started = cpuTime();
+    // The caller runs the first task, which lasts until the worker has
+    // taken the other, then waits while that one sleeps.
+    pool.run(2, [&](size_t i, unsigned){
+        if(i == 0) while(!stolen) this_thread::sleep_for(chrono::milliseconds(1));
+        else {
+            stolen = true;
+            this_thread::sleep_for(chrono::milliseconds(300));
+        }
+    });
+    BOOST_CHECK_LT(chrono::duration_cast<chrono::milliseconds>(cpuTime() - started).count(), 100);
+}
+
+BOOST_AUTO_TEST_CASE(scope_sets_current_pool)
+{
+    BOOST_CHECK(ThreadPool::current() == nullptr);
+    auto pool = ThreadPool(2);
+    {
+        auto scope = PoolScope(pool);
+        BOOST_CHECK(ThreadPool::current() == &pool);
+        BOOST_CHECK_EQUAL(availableThreads(), 2u);
+        auto parts = vector<int>(2);
+        auto inPool = atomic<int>(0);
+        parallelChunks(100, 2, [&](unsigned part, size_t begin, size_t end){
+            parts[part] = int(end - begin);
+            inPool += ThreadPool::current() == &pool;
+        });
+        BOOST_CHECK_EQUAL(parts[0] + parts[1], 100);
+        BOOST_CHECK_EQUAL(inPool, 2);
+    }
+    BOOST_CHECK(ThreadPool::current() == nullptr);
+    BOOST_CHECK_EQUAL(pool.getStats().tasks, 2u);
+}
+
+BOOST_AUTO_TEST_CASE(scope_starts_pool_when_asked_for)
+{
+    auto started = unique_ptr<ThreadPool>();
+    auto scope = PoolScope(3, [&]() -> ThreadPool& {
+        started = make_unique<ThreadPool>(3);
+        return *started;
+    });
+    BOOST_CHECK_EQUAL(availableThreads(), 3u);
+    parallelChunks(1, 3, [](unsigned, size_t, size_t){});
+    BOOST_CHECK(!started);
+    parallelChunks(100, 3, [](unsigned, size_t, size_t){});
+    BOOST_CHECK(started);
+    BOOST_CHECK(ThreadPool::current() == started.get());
+    BOOST_CHECK_EQUAL(started->getStats().tasks, 3u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
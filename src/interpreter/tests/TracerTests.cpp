@@ -0,0 +1,81 @@
+#include <sstream>
+#include <boost/test/unit_test.hpp>
+#include <parser/Ast.h>
+#include <lexer/Lexer.h>
+#include "interpreter/InstrumentedInterpreter.h"
+#include "interpreter/Tracer.h"
+using namespace ast;
+using namespace lexer;
+using namespace parser;
+using namespace std;
+using namespace intprt;
+
+
+struct TracerTestsFixture
+{
+    Tracer tracer = Tracer();
+    void trace_text(const std::string& str)
+    {
+        std::istringstream in(str);
+        Parser p(std::make_unique<Lexer>(in));
+        auto interpreter = InstrumentedInterpreter(tracer);
+        p.parse()->accept(interpreter);
+    }
+
+    int count(const std::string& name)
+    {
+        int found = 0;
+        for(auto const& event : tracer.getEvents())
+            if(event.name == name) found++;
+        return found;
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(TracerTests, TracerTestsFixture)
+
+BOOST_AUTO_TEST_CASE(tracer_records_top_level_statements)
+{
+    trace_text("int x = 0;\nx = 2;");
+    BOOST_CHECK_EQUAL(count("run"), 1);
+    BOOST_CHECK_EQUAL(count("InitializationStatement 1:1"), 1);
+    BOOST_CHECK_EQUAL(count("AssignmentStatement 2:1"), 1);
+    BOOST_CHECK_EQUAL(tracer.getEvents().size(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(tracer_records_function_calls_and_queries)
+{
+    trace_text("hexgrid h = <1 at [0, 0, 0], 2 at [1, -1, 0]>;\n"
+               "int n = 0;\n"
+               "func int count(){ foreach array p in h beside [0, 0, 0] { n = n + (h on p); } }\n"
+               "count(); count();\n"
+               "array blue = h by 2;");
+    BOOST_CHECK_EQUAL(count("call count"), 2);
+    BOOST_CHECK_EQUAL(count("beside"), 2);
+    BOOST_CHECK_EQUAL(count("on"), 2);
+    BOOST_CHECK_EQUAL(count("by"), 1);
+}
+
+BOOST_AUTO_TEST_CASE(tracer_nests_events_in_time)
+{
+    trace_text("func int f(){ int x = 1; } f();");
+    auto const& events = tracer.getEvents();
+    BOOST_REQUIRE_EQUAL(events.size(), 2);
+    auto const& call = events[0];
+    auto const& run = events[1];
+    BOOST_CHECK_EQUAL(run.name, "run");
+    BOOST_CHECK(call.timestamp >= run.timestamp);
+    BOOST_CHECK(call.timestamp + call.duration <= run.timestamp + run.duration + 0.001);
+}
+
+BOOST_AUTO_TEST_CASE(tracer_writes_complete_events_json)
+{
+    tracer.begin("lex", "frontend");
+    tracer.end();
+    std::stringstream out;
+    tracer.writeJson(out);
+    auto json = out.str();
+    BOOST_CHECK(json.find("\"traceEvents\":[") != std::string::npos);
+    BOOST_CHECK(json.find("\"name\":\"lex\",\"cat\":\"frontend\",\"ph\":\"X\"") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
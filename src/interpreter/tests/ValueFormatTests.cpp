@@ -0,0 +1,146 @@
+#include <cstring>
+#include <sstream>
+#include <boost/test/unit_test.hpp>
+#include <parser/Ast.h>
+#include <lexer/Lexer.h>
+#include "interpreter/Interpreter.h"
+#include "interpreter/ValueFormat.h"
+using namespace ast;
+using namespace lexer;
+using namespace parser;
+using namespace std;
+using namespace intprt;
+
+
+struct ValueFormatTestsFixture
+{
+    Interpreter interpreter = Interpreter();
+
+    std::string printed(const std::string& str, OutputFormat format)
+    {
+        std::istringstream in(str);
+        std::ostringstream out;
+        auto old = cout.rdbuf(out.rdbuf());
+        interpreter.setOutputFormat(format);
+        Parser p(std::make_unique<Lexer>(in));
+        p.parse()->accept(interpreter);
+        cout.rdbuf(old);
+        return out.str();
+    }
+};
+
+// Reads back what writeBinaryFrame wrote.
+class BinaryReader
+{
+public:
+    BinaryReader(std::string data_) : data(std::move(data_)) {}
+    uint64_t number(size_t bytes){
+        uint64_t value = 0;
+        for(size_t i = 0; i < bytes; i++) value |= uint64_t(uint8_t(data[offset + i])) << (8 * i);
+        offset += bytes;
+        return value;
+    }
+    int int32(){ return int32_t(uint32_t(number(4))); }
+    double float64(){
+        auto bits = number(8);
+        double value;
+        memcpy(&value, &bits, sizeof value);
+        return value;
+    }
+    std::string text(size_t n){
+        auto value = data.substr(offset, n);
+        offset += n;
+        return value;
+    }
+    bool atEnd() const { return offset == data.size(); }
+private:
+    std::string data;
+    size_t offset = 0;
+};
+
+BOOST_FIXTURE_TEST_SUITE(ValueFormatTests, ValueFormatTestsFixture)
+
+BOOST_AUTO_TEST_CASE(output_format_names)
+{
+    auto format = OutputFormat::Text;
+    BOOST_CHECK(parseOutputFormat("json", format) && format == OutputFormat::Json);
+    BOOST_CHECK(parseOutputFormat("binary", format) && format == OutputFormat::Binary);
+    BOOST_CHECK(parseOutputFormat("text", format) && format == OutputFormat::Text);
+    BOOST_CHECK(!parseOutputFormat("xml", format));
+}
+
+BOOST_AUTO_TEST_CASE(text_format_is_the_default)
+{
+    BOOST_CHECK_EQUAL(printed("return <\"blue\" at [0, 0, 0]>;", OutputFormat::Text),
+                      "< blue at [0, 0, 0], >\n");
+}
+
+BOOST_AUTO_TEST_CASE(json_scalars_and_arrays)
+{
+    BOOST_CHECK_EQUAL(printed("return 12;", OutputFormat::Json), "12\n");
+    BOOST_CHECK_EQUAL(printed("return 2.0;", OutputFormat::Json), "2.0\n");
+    BOOST_CHECK_EQUAL(printed("return 0.1;", OutputFormat::Json), "0.1\n");
+    BOOST_CHECK_EQUAL(printed("return \"a\\\"b\";", OutputFormat::Json), "\"a\\\"b\"\n");
+    BOOST_CHECK_EQUAL(printed("return [1, [2.5, \"x\"]];", OutputFormat::Json),
+                      "[1,[2.5,\"x\"]]\n");
+}
+
+BOOST_AUTO_TEST_CASE(json_hexgrid_is_columnar)
+{
+    BOOST_CHECK_EQUAL(printed("return <\"blue\" at [0, 0, 0], 7 at [1, -1, 0]>;", OutputFormat::Json),
+                      "{\"q\":[0,1],\"r\":[0,-1],\"s\":[0,0],\"values\":[\"blue\",7]}\n");
+    BOOST_CHECK_EQUAL(printed("hexgrid h = <1 at [0, 0, 0]>; remove [0, 0, 0] from h; return h;",
+                              OutputFormat::Json),
+                      "{\"q\":[],\"r\":[],\"s\":[],\"values\":[]}\n");
+}
+
+BOOST_AUTO_TEST_CASE(binary_scalar_frames)
+{
+    BinaryReader in(printed("return 12; return 2.5; return \"abc\";", OutputFormat::Binary));
+    BOOST_CHECK_EQUAL(in.number(8), 5u);
+    BOOST_CHECK_EQUAL(in.number(1), 1u);
+    BOOST_CHECK_EQUAL(in.int32(), 12);
+    BOOST_CHECK_EQUAL(in.number(8), 9u);
+    BOOST_CHECK_EQUAL(in.number(1), 2u);
+    BOOST_CHECK_EQUAL(in.float64(), 2.5);
+    BOOST_CHECK_EQUAL(in.number(8), 8u);
+    BOOST_CHECK_EQUAL(in.number(1), 3u);
+    BOOST_CHECK_EQUAL(in.number(4), 3u);
+    BOOST_CHECK_EQUAL(in.text(3), "abc");
+    BOOST_CHECK(in.atEnd());
+}
+
+BOOST_AUTO_TEST_CASE(binary_hexgrid_is_columnar)
+{
+    auto data = printed("return <\"ab\" at [0, 0, 0], 7 at [1, -1, 0], [(-1)] at [2, 0, -2]>;",
+                        OutputFormat::Binary);
+    BinaryReader in(data);
+    BOOST_CHECK_EQUAL(in.number(8), data.size() - 8);
+    BOOST_CHECK_EQUAL(in.number(1), 5u);
+    BOOST_CHECK_EQUAL(in.number(4), 3u);
+    for(int q : {0, 1, 2}) BOOST_CHECK_EQUAL(in.int32(), q);
+    for(int r : {0, -1, 0}) BOOST_CHECK_EQUAL(in.int32(), r);
+    for(int s : {0, 0, -2}) BOOST_CHECK_EQUAL(in.int32(), s);
+    for(unsigned tag : {3u, 1u, 4u}) BOOST_CHECK_EQUAL(in.number(1), tag);
+    BOOST_CHECK_EQUAL(in.number(4), 2u);
+    BOOST_CHECK_EQUAL(in.text(2), "ab");
+    BOOST_CHECK_EQUAL(in.int32(), 7);
+    BOOST_CHECK_EQUAL(in.number(4), 1u);
+    BOOST_CHECK_EQUAL(in.number(1), 1u);
+    BOOST_CHECK_EQUAL(in.int32(), -1);
+    BOOST_CHECK(in.atEnd());
+}
+
+BOOST_AUTO_TEST_CASE(binary_size_matches_written_bytes)
+{
+    printed("hexgrid h = <\"blue\" at [0, 0, 0], [1, 2.5] at [1, 0, -1]>;", OutputFormat::Text);
+    auto h = interpreter.getValue("h");
+    std::ostringstream out;
+    {
+        OutputWriter writer(out);
+        writeBinaryFrame(writer, h);
+    }
+    BOOST_CHECK_EQUAL(out.str().size(), 8 + binarySize(h));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -2,22 +2,25 @@
 
 using namespace lexer;
 using namespace token;
+// Read only, so lexers on different threads can share them.
 namespace{
-     std::set<std::string> keywords = { "func", "return", "if", "elif", 
+    const std::set<std::string> keywords = { "func", "return", "if", "elif", 
                                         "else", "move", "foreach", 
                                         "in", "add", "remove", "to",
-                                        "from","at"};
-    std::set<std::string> alphaOperators = {"and", "or", "beside",
-                                            "by", "on"};
-    std::set<char> signs = {'<', '>', '/', '%', '*', '+', '-', '!','=',
+                                        "from","at", "path", "visible",
+                                        "parallel", "save", "load",
+                                        "compressed"};
+    const std::set<std::string> alphaOperators = {"and", "or", "beside",
+                                            "by", "on", "within"};
+    const std::set<char> signs = {'<', '>', '/', '%', '*', '+', '-', '!','=',
                              '{', '}', '[', ']', '(', ')', ',', ';'};
-    static std::set<std::string> operators = {  "<", ">", "/", "%", 
+    const std::set<std::string> operators = {  "<", ">", "/", "%", 
                                                 "*", "+", "-", "!",
                                                 "=", "{", "}", "[",
                                                 "]", "(", ")", "==",
                                                 "!=", ">=", "<=",",",
                                                 ";"};
-    static std::set<std::string> types = {  "int", "float", "string", 
+    const std::set<std::string> types = {  "int", "float", "string", 
                                             "hexgrid, array"};
 }
 
@@ -35,6 +38,14 @@ Token Lexer::getToken()
     return t.value_or(Token(Token::Type::UnkownToken));
 }
 
+std::vector<Token> Lexer::readAll()
+{
+    auto tokens = std::vector<Token>();
+    do tokens.push_back(getToken());
+    while (tokens.back().getType() != Token::Type::EndOfFile);
+    return tokens;
+}
+
 std::optional<token::Token> Lexer::tryEof()
 {
     if (in.eof()) return Token(getLocation(), getLocation());
@@ -213,11 +224,18 @@ Token::Type Lexer::getAlphaNumericTokenType(std::string value){
     if (value == "to")      return Token::Type::ToKeyword;
     if (value == "from")    return Token::Type::FromKeyword;
     if (value == "at")      return Token::Type::AtKeyword;
+    if (value == "path")    return Token::Type::PathKeyword;
+    if (value == "visible") return Token::Type::VisibleKeyword;
+    if (value == "parallel") return Token::Type::ParallelKeyword;
+    if (value == "save")    return Token::Type::SaveKeyword;
+    if (value == "load")    return Token::Type::LoadKeyword;
+    if (value == "compressed") return Token::Type::CompressedKeyword;
     if (value == "and")     return Token::Type::AndOperator;
     if (value == "or")      return Token::Type::OrOperator;
     if (value == "beside")  return Token::Type::BesideOperator;
     if (value == "by")      return Token::Type::ByOperator;
     if (value == "on")      return Token::Type::OnOperator;
+    if (value == "within")  return Token::Type::WithinOperator;
     if (value == "<")       return Token::Type::LessOperator;
     if (value == ">")       return Token::Type::GreaterOperator;
     if (value == "/")       return Token::Type::DivideOperator;
@@ -7,6 +7,7 @@
 #include <optional>
 #include <math.h>
 #include <utility>
+#include <vector>
 #include "Token.h"
 #include <HexgridErrors.h>
 
@@ -19,6 +20,8 @@ public:
     const Lexer& operator=(const Lexer&) = delete;
 
     token::Token getToken();
+    // Reads the rest of the input, the last token is EndOfFile.
+    std::vector<token::Token> readAll();
 
 private:
     std::optional<token::Token> tryEof();
@@ -80,11 +80,18 @@ std::string Token::toString(Token::Type type)
     case Type::ToKeyword:               return "\"to\" keyword";
     case Type::FromKeyword:             return "\"from\" keyword";
     case Type::AtKeyword:               return "\"at\" keyword";
+    case Type::PathKeyword:             return "\"path\" keyword";
+    case Type::VisibleKeyword:          return "\"visible\" keyword";
+    case Type::ParallelKeyword:         return "\"parallel\" keyword";
+    case Type::SaveKeyword:             return "\"save\" keyword";
+    case Type::LoadKeyword:             return "\"load\" keyword";
+    case Type::CompressedKeyword:       return "\"compressed\" keyword";
     case Type::AndOperator:             return "\"and\" operator";
     case Type::OrOperator:              return "\"or\" operator";
     case Type::BesideOperator:          return "\"beside\" operator";
     case Type::ByOperator:              return "\"by\" operator";
     case Type::OnOperator:              return "\"on\" operator";
+    case Type::WithinOperator:          return "\"within\" operator";
     case Type::LessOperator:            return "\"less\" operator";
     case Type::GreaterOperator:         return "\"greater\" operator";
     case Type::DivideOperator:          return "\"divide\" operator";
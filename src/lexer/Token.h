@@ -32,11 +32,18 @@ public:
         ToKeyword,
         FromKeyword,
         AtKeyword,
+        PathKeyword,
+        VisibleKeyword,
+        ParallelKeyword,
+        SaveKeyword,
+        LoadKeyword,
+        CompressedKeyword,
         AndOperator,
         OrOperator,
         BesideOperator,
         ByOperator,
         OnOperator,
+        WithinOperator,
         LessOperator,
         GreaterOperator,
         DivideOperator,
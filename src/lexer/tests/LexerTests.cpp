@@ -24,6 +24,19 @@ BOOST_AUTO_TEST_CASE(lexer_reads_empty_input_returns_eof)
   BOOST_CHECK_EQUAL(l.getToken().getType(), Token::Type::EndOfFile);
 }
 
+BOOST_AUTO_TEST_CASE(lexer_reads_all_tokens_up_to_eof)
+{
+  std::istringstream in("int x = 1;");
+  Lexer l(in);
+
+  const auto tokens = l.readAll();
+
+  BOOST_REQUIRE_EQUAL(tokens.size(), 6);
+  BOOST_CHECK_EQUAL(tokens[0].getType(), Token::Type::IntType);
+  BOOST_CHECK_EQUAL(tokens[3].getInteger(), 1);
+  BOOST_CHECK_EQUAL(tokens[5].getType(), Token::Type::EndOfFile);
+}
+
 // Integer token
 
 BOOST_AUTO_TEST_CASE(lexer_reads_int_token)
@@ -252,6 +265,49 @@ BOOST_AUTO_TEST_CASE(lexer_reads_alpha_operator_token)
   BOOST_CHECK_EQUAL(t.getText(), "");
 }
 
+BOOST_AUTO_TEST_CASE(lexer_reads_within_operator_token)
+{
+  std::istringstream in("within");
+  Lexer l(in);
+  BOOST_CHECK_EQUAL(l.getToken().getType(), Token::Type::WithinOperator);
+}
+
+BOOST_AUTO_TEST_CASE(lexer_reads_path_keyword_token)
+{
+  std::istringstream in("path");
+  Lexer l(in);
+  BOOST_CHECK_EQUAL(l.getToken().getType(), Token::Type::PathKeyword);
+}
+
+BOOST_AUTO_TEST_CASE(lexer_reads_visible_keyword_token)
+{
+  std::istringstream in("visible");
+  Lexer l(in);
+  BOOST_CHECK_EQUAL(l.getToken().getType(), Token::Type::VisibleKeyword);
+}
+
+BOOST_AUTO_TEST_CASE(lexer_reads_parallel_keyword_token)
+{
+  std::istringstream in("parallel");
+  Lexer l(in);
+  BOOST_CHECK_EQUAL(l.getToken().getType(), Token::Type::ParallelKeyword);
+}
+
+BOOST_AUTO_TEST_CASE(lexer_reads_save_and_load_keyword_tokens)
+{
+  std::istringstream in("save load");
+  Lexer l(in);
+  BOOST_CHECK_EQUAL(l.getToken().getType(), Token::Type::SaveKeyword);
+  BOOST_CHECK_EQUAL(l.getToken().getType(), Token::Type::LoadKeyword);
+}
+
+BOOST_AUTO_TEST_CASE(lexer_reads_compressed_keyword_token)
+{
+  std::istringstream in("compressed");
+  Lexer l(in);
+  BOOST_CHECK_EQUAL(l.getToken().getType(), Token::Type::CompressedKeyword);
+}
+
 BOOST_AUTO_TEST_CASE(lexer_reads_sign_one_char_operator_token)
 {
   std::istringstream in("=");
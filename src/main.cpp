@@ -1,26 +1,214 @@
 #include <iostream>
+#include <fstream>
 #include <sstream>
+#include <csignal>
 #include "lexer/Lexer.h"
 #include "parser/Ast.h"
 #include "parser/Parser.h"
 #include "HexgridErrors.h"
+#include "interpreter/Batch.h"
 #include "interpreter/Interpreter.h"
+#include "interpreter/InstrumentedInterpreter.h"
+#include "interpreter/Profiler.h"
+#include "interpreter/Server.h"
+#include "interpreter/Tracer.h"
+#include "interpreter/ValueFormat.h"
 
 using namespace lexer;
 using namespace parser;
 using namespace ast;
 using namespace intprt;
 
-std::unique_ptr<Node> readAndParseStdin()
+struct Options
+{
+  std::string profilePath;
+  std::string tracePath;
+  std::string poolStatsPath;
+  std::string batchPath;
+  std::string inputName = "input";
+  std::string socketPath;
+  unsigned threads = 0;
+  OutputFormat outputFormat = OutputFormat::Text;
+};
+
+void printUsage()
+{
+  std::cerr << "usage: hexgrider [--profile <path>] [--trace <file>] [--output <format>]\n"
+               "                 [--threads <count>] [--pool-stats <file>]\n"
+               "                 [--batch <list> [--input <name>]] < script\n"
+               "       hexgrider --serve <socket> [--threads <count>] [--output <format>]\n"
+               "  --profile <path>   write per-node timings to <path>.txt and\n"
+               "                     collapsed stacks to <path>.folded\n"
+               "  --trace <file>     write Chrome trace events as JSON to <file>\n"
+               "  --output <format>  print returned values as text (default),\n"
+               "                     json or binary\n"
+               "  --threads <count>  threads of the pool parallel work runs on\n"
+               "                     (default: all cores)\n"
+               "  --pool-stats <file> write thread pool tasks, steals and\n"
+               "                     utilization to <file>\n"
+               "  --batch <list>     run the script once for every hexgrid file\n"
+               "                     listed in <list>, one path per line, in\n"
+               "                     parallel; output follows the list order.\n"
+               "                     Files written by save are loaded, others\n"
+               "                     must hold a hexgrid literal\n"
+               "  --input <name>     variable holding the hexgrid in batch runs\n"
+               "                     (default: input)\n"
+               "  --serve <socket>   run scripts sent to a Unix domain socket,\n"
+               "                     keeping global variables between them\n";
+}
+
+bool parseThreads(const std::string& value, unsigned& threads)
+{
+  std::istringstream in(value);
+  long count = 0;
+  if(!(in >> count) || !in.eof() || count < 1 || count > 1024) return false;
+  threads = unsigned(count);
+  return true;
+}
+
+// Accepts both "--name value" and "--name=value".
+bool parseArguments(int argc, char* argv[], Options& options)
+{
+  for(int i = 1; i < argc; i++){
+    std::string arg = argv[i];
+    std::string value;
+    auto eq = arg.find('=');
+    if(eq != std::string::npos){
+      value = arg.substr(eq + 1);
+      arg = arg.substr(0, eq);
+    } else if(i + 1 < argc && arg.rfind("--", 0) == 0){
+      value = argv[++i];
+    }
+    if(arg == "--profile" && !value.empty()) options.profilePath = value;
+    else if(arg == "--trace" && !value.empty()) options.tracePath = value;
+    else if(arg == "--output" && parseOutputFormat(value, options.outputFormat)) continue;
+    else if(arg == "--threads" && parseThreads(value, options.threads)) continue;
+    else if(arg == "--pool-stats" && !value.empty()) options.poolStatsPath = value;
+    else if(arg == "--batch" && !value.empty()) options.batchPath = value;
+    else if(arg == "--input" && !value.empty()) options.inputName = value;
+    else if(arg == "--serve" && !value.empty()) options.socketPath = value;
+    else return false;
+  }
+  // Batch runs and servers aren't instrumented.
+  bool instrumented = !options.profilePath.empty() || !options.tracePath.empty();
+  if(!options.socketPath.empty()) return !instrumented && options.batchPath.empty();
+  return options.batchPath.empty() || !instrumented;
+}
+
+std::unique_ptr<Program> readAndParseStdin()
 {
   Parser p(std::make_unique<Lexer>(std::cin));
   return p.parse();
 }
 
-int main()
+// Lexes the whole input before parsing so both phases show up as
+// separate spans in the trace.
+std::unique_ptr<Program> readAndParseStdin(Tracer& tracer)
+{
+  tracer.begin("lex", "frontend");
+  auto tokens = Lexer(std::cin).readAll();
+  tracer.end();
+  tracer.begin("parse", "frontend");
+  auto program = Parser(std::move(tokens)).parse();
+  tracer.end();
+  return program;
+}
+
+void configure(Interpreter& interpreter, const Options& options)
+{
+  interpreter.setOutputFormat(options.outputFormat);
+  if(options.threads) interpreter.setThreads(options.threads);
+}
+
+void writePoolStats(const Interpreter& interpreter, const Options& options)
+{
+  if(options.poolStatsPath.empty()) return;
+  std::ofstream stats(options.poolStatsPath);
+  interpreter.getPoolStats().write(stats);
+}
+
+// Exits with 1 when any input failed.
+int runBatch(Program& program, const Options& options)
+{
+  std::ifstream list(options.batchPath);
+  if(!list){
+    std::cerr << "hexgrider: can't open " << options.batchPath << "\n";
+    return 2;
+  }
+  auto runner = BatchRunner(program, options.inputName,
+                            options.threads ? options.threads : hardwareThreads());
+  runner.setOutputFormat(options.outputFormat);
+  auto failed = runner.run(readPathList(list), std::cout, std::cerr);
+  if(!options.poolStatsPath.empty()){
+    std::ofstream stats(options.poolStatsPath);
+    runner.getPoolStats().write(stats);
+  }
+  return failed ? 1 : 0;
+}
+
+Server* runningServer = nullptr;
+
+void stopServer(int)
+{
+  if(runningServer) runningServer->stop();
+}
+
+int serve(const Options& options)
+{
+  try {
+    auto server = Server(options.socketPath);
+    configure(server.getInterpreter(), options);
+    runningServer = &server;
+    std::signal(SIGINT, stopServer);
+    std::signal(SIGTERM, stopServer);
+    server.serve();
+    runningServer = nullptr;
+    writePoolStats(server.getInterpreter(), options);
+  } catch(const std::exception& e) {
+    std::cerr << "hexgrider: " << e.what() << "\n";
+    return 2;
+  }
+  return 0;
+}
+
+int main(int argc, char* argv[])
 {
+  auto options = Options();
+  if(!parseArguments(argc, argv, options)){
+    printUsage();
+    return 2;
+  }
+  if(!options.socketPath.empty()) return serve(options);
+  auto tracer = Tracer();
+  auto profiler = Profiler();
+  auto listeners = ListenerGroup();
+  if(!options.tracePath.empty()) listeners.add(tracer);
+  if(!options.profilePath.empty()) listeners.add(profiler);
+
   // std::cout << readAndParseStdin()->toString();
-  auto i = Interpreter();
-  readAndParseStdin()->accept(i);
+  auto program = options.tracePath.empty() ? readAndParseStdin()
+                                           : readAndParseStdin(tracer);
+  if(!options.batchPath.empty()) return runBatch(*program, options);
+  if(listeners.empty()){
+    auto i = Interpreter();
+    configure(i, options);
+    program->accept(i);
+    writePoolStats(i, options);
+    return 0;
+  }
+  auto i = InstrumentedInterpreter(listeners);
+  configure(i, options);
+  program->accept(i);
+  writePoolStats(i, options);
+  if(!options.tracePath.empty()){
+    std::ofstream trace(options.tracePath);
+    tracer.writeJson(trace);
+  }
+  if(!options.profilePath.empty()){
+    std::ofstream report(options.profilePath + ".txt");
+    profiler.writeReport(report);
+    std::ofstream stacks(options.profilePath + ".folded");
+    profiler.writeCollapsedStacks(stacks);
+  }
   return 0;
 }
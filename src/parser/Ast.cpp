@@ -210,6 +210,26 @@ string ForeachStatement::toString(int depth) const
             statementBlock->toString(depth + 1);
 }
 
+ParallelForeachStatement::ParallelForeachStatement(
+                unique_ptr<Node> iterator_,
+                unique_ptr<Node> iterated_,
+                unique_ptr<Node> statementBlock_,
+                vector<Reduced> reductions_)
+: ForeachStatement(move(iterator_), move(iterated_), move(statementBlock_)),
+  reductions(move(reductions_)) {}
+
+string ParallelForeachStatement::toString(int depth) const
+{
+    static const char* names[] = {"sum", "min", "max", "count"};
+    string listed;
+    for(auto const& reduced : reductions)
+        listed += string(listed.empty() ? "" : ", ") + names[int(reduced.reduction)] + " " + reduced.name;
+    return string(depth, '|') + "Parallel Foreach Statement (" + listed + ")\n" +
+            iterator->toString(depth + 1) +
+            iterated->toString(depth + 1) +
+            statementBlock->toString(depth + 1);
+}
+
 FunctionCall::FunctionCall(string funcName_, 
                            vector<unique_ptr<Node>> args_)
                            :funcName(funcName_), args(move(args_)){}
@@ -231,8 +251,10 @@ FunctionDefinition::FunctionDefinition(
     unique_ptr<Node> statementBlock_,
     pair<int, int> start_, pair<int, int> end_)
 :   type(type_), name(name_), params(move(params_)), 
-    statementBlock(move(statementBlock_)),
-    startLoc(start_), endLoc(end_){}
+    statementBlock(move(statementBlock_))
+{
+    setLocation(start_, end_);
+}
 
 string FunctionDefinition::toString(int depth) const
 {
@@ -258,14 +280,6 @@ void FunctionDefinition::runStatementBlock(AstVisitor&v){
     statementBlock->accept(v);
 }
 
-pair<int, int> FunctionDefinition::getStart()const {
-    return startLoc;
-}
-
-pair<int, int> FunctionDefinition::getEnd() const {
-    return endLoc;
-}
-
 HexgridLiteral::HexgridLiteral(vector<unique_ptr<Node>> cells_)
 {
     cells = move(cells_);
@@ -312,6 +326,48 @@ string OnExpression::toString(int depth) const
             BinaryExpression::toString(depth);
 }
 
+WithinExpression::WithinExpression(unique_ptr<Node> grid_,
+                                   unique_ptr<Node> radius_,
+                                   unique_ptr<Node> center_)
+{
+    grid = move(grid_);
+    radius = move(radius_);
+    center = move(center_);
+}
+
+string WithinExpression::toString(int depth) const
+{
+    return string(depth, '|') + "Hexgrid Within Expression\n" +
+           grid->toString(depth + 1) +
+           radius->toString(depth + 1) +
+           center->toString(depth + 1);
+}
+
+PathExpression::PathExpression(unique_ptr<Node> source_,
+                               unique_ptr<Node> target_,
+                               unique_ptr<Node> grid_)
+{
+    source = move(source_);
+    target = move(target_);
+    grid = move(grid_);
+}
+
+string PathExpression::toString(int depth) const
+{
+    return string(depth, '|') + "Hexgrid Path Expression\n" +
+           source->toString(depth + 1) +
+           target->toString(depth + 1) +
+           grid->toString(depth + 1);
+}
+
+string VisibleExpression::toString(int depth) const
+{
+    return string(depth, '|') + "Hexgrid Visible Expression\n" +
+           source->toString(depth + 1) +
+           target->toString(depth + 1) +
+           grid->toString(depth + 1);
+}
+
 VariableReference::VariableReference(string name_)
     : name(name_)
 {
@@ -404,6 +460,20 @@ string MoveStatement::toString(int depth) const
 Node::~Node()
 {}
 
+void Node::setLocation(pair<int, int> start_, pair<int, int> end_)
+{
+    startLoc = start_;
+    endLoc = end_;
+}
+
+pair<int, int> Node::getStart() const {
+    return startLoc;
+}
+
+pair<int, int> Node::getEnd() const {
+    return endLoc;
+}
+
 
 BinaryExpression::BinaryExpression(unique_ptr<Node> lvalue_,
                                    unique_ptr<Node> rvalue_)
@@ -434,6 +504,31 @@ string RemoveStatement::toString(int depth) const
             grid->toString(depth + 1);
 }
 
+SaveStatement::SaveStatement(unique_ptr<Node> grid_, unique_ptr<Node> path_, bool compressed_)
+{
+    grid = move(grid_);
+    path = move(path_);
+    compressed = compressed_;
+}
+
+string SaveStatement::toString(int depth) const
+{
+    return string(depth, '|') + (compressed ? "Save Statement (compressed)\n" : "Save Statement\n") +
+            grid->toString(depth + 1) +
+            path->toString(depth + 1);
+}
+
+LoadExpression::LoadExpression(unique_ptr<Node> path_)
+{
+    path = move(path_);
+}
+
+string LoadExpression::toString(int depth) const
+{
+    return string(depth, '|') + "Load Expression\n" +
+            path->toString(depth + 1);
+}
+
 ReturnStatement::ReturnStatement(unique_ptr<Node> expr_)
 {
     expr = move(expr_);
@@ -18,6 +18,9 @@ class RemoveStatement;
 class MoveStatement;
 class IfStatement;
 class ForeachStatement;
+class ParallelForeachStatement;
+class SaveStatement;
+class LoadExpression;
 class ConditionBlock;
 class AddStatement;
 class InitializationStatement;
@@ -31,6 +34,9 @@ class MultiplyExpression;
 class SubtructExpression;
 class AddExpression;
 class OnExpression;
+class WithinExpression;
+class PathExpression;
+class VisibleExpression;
 class ByExpression;
 class BesideExpression;
 class NotEqualExpression;
@@ -66,6 +72,9 @@ virtual void visit(ast::RemoveStatement&) = 0;
 virtual void visit(ast::MoveStatement&) = 0;
 virtual void visit(ast::IfStatement&) = 0;
 virtual void visit(ast::ForeachStatement&) = 0;
+virtual void visit(ast::ParallelForeachStatement&) = 0;
+virtual void visit(ast::SaveStatement&) = 0;
+virtual void visit(ast::LoadExpression&) = 0;
 virtual void visit(ast::ConditionBlock&) = 0;
 virtual void visit(ast::AddStatement&) = 0;
 virtual void visit(ast::InitializationStatement&) = 0;
@@ -79,6 +88,9 @@ virtual void visit(ast::MultiplyExpression&) = 0;
 virtual void visit(ast::SubtructExpression&) = 0;
 virtual void visit(ast::AddExpression&) = 0;
 virtual void visit(ast::OnExpression&) = 0;
+virtual void visit(ast::WithinExpression&) = 0;
+virtual void visit(ast::PathExpression&) = 0;
+virtual void visit(ast::VisibleExpression&) = 0;
 virtual void visit(ast::ByExpression&) = 0;
 virtual void visit(ast::BesideExpression&) = 0;
 virtual void visit(ast::NotEqualExpression&) = 0;
@@ -109,6 +121,14 @@ public:
     virtual std::string toString(int depth = 0) const = 0;
     // virtual void accept(AstVisitor& v) {throw std::runtime_error("accept not implemented");}
     virtual void accept(AstVisitor&) = 0;
+
+    // Source span of the tokens the node was read from, (line, column).
+    void setLocation(std::pair<int, int>, std::pair<int, int>);
+    std::pair<int, int> getStart() const;
+    std::pair<int, int> getEnd() const;
+private:
+    std::pair<int, int> startLoc;
+    std::pair<int, int> endLoc;
 };
 
 class Variable
@@ -171,8 +191,6 @@ public:
 
     std::string toString(int depth = 0) const override;
     std::string getName() const;
-    std::pair<int, int> getStart()const ;
-    std::pair<int, int> getEnd()const;
     virtual void accept(AstVisitor& v) override {v.visit(*this);}
     size_t getParamCount() const;
     void declareParam(int, AstVisitor&);
@@ -182,10 +200,10 @@ private:
     std::string name;
     std::vector<std::unique_ptr<VariableDeclarationStatement>> params;
     std::unique_ptr<Node> statementBlock;
-    std::pair<int, int> startLoc;
-    std::pair<int, int> endLoc;
 };
 
+// Interpreters only read a program, so one parsed program can be run by
+// any number of them at once; it must outlive their runs.
 class Program : public Node
 {
 public:
@@ -424,6 +442,47 @@ public:
     virtual void accept(AstVisitor& v) override {v.visit(*this);}
 };
 
+// grid within radius at center
+class WithinExpression : public Node
+{
+public:
+    WithinExpression(std::unique_ptr<Node> grid_,
+                     std::unique_ptr<Node> radius_,
+                     std::unique_ptr<Node> center_);
+    ~WithinExpression(){};
+
+    std::string toString(int depth = 0) const override;
+    std::unique_ptr<Node> grid;
+    std::unique_ptr<Node> radius;
+    std::unique_ptr<Node> center;
+    virtual void accept(AstVisitor& v) override {v.visit(*this);}
+};
+
+// path from source to target in grid
+class PathExpression : public Node
+{
+public:
+    PathExpression(std::unique_ptr<Node> source_,
+                   std::unique_ptr<Node> target_,
+                   std::unique_ptr<Node> grid_);
+    ~PathExpression(){};
+
+    std::string toString(int depth = 0) const override;
+    std::unique_ptr<Node> source;
+    std::unique_ptr<Node> target;
+    std::unique_ptr<Node> grid;
+    virtual void accept(AstVisitor& v) override {v.visit(*this);}
+};
+
+// visible from source to target in grid
+class VisibleExpression : public PathExpression
+{
+public:
+    using PathExpression::PathExpression;
+    std::string toString(int depth = 0) const override;
+    virtual void accept(AstVisitor& v) override {v.visit(*this);}
+};
+
 class AddExpression : public BinaryExpression
 {
 public:
@@ -583,6 +642,30 @@ public:
     virtual void accept(AstVisitor& v) override {v.visit(*this);}
 };
 
+// foreach whose body may run for several elements at once. Only the
+// variables listed in reductions may be changed outside of it; each chunk
+// of elements folds into them separately and the results are merged.
+class ParallelForeachStatement : public ForeachStatement
+{
+public:
+    enum class Reduction { Sum, Min, Max, Count };
+    struct Reduced
+    {
+        Reduction reduction;
+        std::string name;
+    };
+
+    ParallelForeachStatement(
+                std::unique_ptr<Node> iterator_,
+                std::unique_ptr<Node> iterated_,
+                std::unique_ptr<Node> statementBlock_,
+                std::vector<Reduced> reductions_);
+
+    std::string toString(int depth = 0) const override;
+    std::vector<Reduced> reductions;
+    virtual void accept(AstVisitor& v) override {v.visit(*this);}
+};
+
 class IfStatement : public Node
 {
 public:
@@ -632,6 +715,33 @@ public:
 };
 
 
+// save grid to "file" or save grid to "file" compressed
+class SaveStatement : public Node
+{
+public:
+    SaveStatement(std::unique_ptr<Node> grid_, std::unique_ptr<Node> path_, bool compressed_ = false);
+    ~SaveStatement(){};
+
+    std::string toString(int depth = 0) const override;
+    std::unique_ptr<Node> grid;
+    std::unique_ptr<Node> path;
+    bool compressed;
+    virtual void accept(AstVisitor& v) override {v.visit(*this);}
+};
+
+// load "file"
+class LoadExpression : public Node
+{
+public:
+    LoadExpression(std::unique_ptr<Node> path_);
+    ~LoadExpression(){};
+
+    std::string toString(int depth = 0) const override;
+    std::unique_ptr<Node> path;
+    virtual void accept(AstVisitor& v) override {v.visit(*this);}
+};
+
+
 class ReturnStatement : public Node
 {
 public:
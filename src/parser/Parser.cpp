@@ -6,6 +6,7 @@ using namespace ast;
 using namespace std;
 
 Parser::Parser(unique_ptr<Lexer> lexer_):lexer(move(lexer_)){}
+Parser::Parser(vector<Token> tokens_):tokens(move(tokens_)){}
 Parser::~Parser(){}
 
 // Parses script, return statement and function definitions in a scope.
@@ -13,6 +14,7 @@ Parser::~Parser(){}
 unique_ptr<Program> Parser::parse()
 {
     advance();
+    auto start = current_token.getStart();
     auto program = make_unique<Program>();
     unique_ptr<Node> stmnt;
     unique_ptr<FunctionDefinition> func;
@@ -20,7 +22,7 @@ unique_ptr<Program> Parser::parse()
         if(stmnt)   program->insertStatement(move(stmnt));
         else        program->insertFunction(move(func));
     }
-    return program;
+    return located(move(program), start);
 }
 
 unique_ptr<Node> Parser::readStatement()
@@ -36,6 +38,7 @@ unique_ptr<Node> Parser::readStatement()
         ||  (stmnt = readAddStatement())
         ||  (stmnt = readRemoveStatement())
         ||  (stmnt = readMoveStatement())
+        ||  (stmnt = readSaveStatement())
         )) return nullptr;
     consume(Token::Type::Semicolon);
     return stmnt;
@@ -48,20 +51,21 @@ unique_ptr<Node> Parser::readDeclrOrInit()
     if(!consumeIfCheck(Token::Type::AssignOperator)) return declr;
     auto expr = readExpression();
     if(!expr) throwOnUnexpectedInput("a variable or a value");
-    return make_unique<InitializationStatement>(
-        declr->type, declr->identifier, move(expr));
+    return located(make_unique<InitializationStatement>(
+        declr->type, declr->identifier, move(expr)), declr->getStart());
 }
 
 unique_ptr<Node> Parser::readFuncCallOrAssignment()
 {
     if(!checkToken(Token::Type::Identifier)) return nullptr;
+    auto start = current_token.getStart();
     const auto id = current_token.getText();
     advance();
     auto assignment = readAssignment(id);
-    if(assignment) return assignment;
+    if(assignment) return located(move(assignment), start);
     auto functionCall = readFunctionCall(id);
     if(!functionCall) throwOnUnexpectedInput("an assignment or a function call");
-    return functionCall;
+    return located(move(functionCall), start);
 }
 
 unique_ptr<Node> Parser::readAssignment(string name)
@@ -75,25 +79,27 @@ unique_ptr<Node> Parser::readAssignment(string name)
 unique_ptr<VariableDeclarationStatement> Parser::readDeclr()
 {
     if(!isVarType()) return nullptr;
+    auto start = current_token.getStart();
     auto varType = getVarType();
     advance();
     requireToken(Token::Type::Identifier);
     const auto identifier = current_token.getText();
     advance();
-    return make_unique<VariableDeclarationStatement>(varType, identifier);
+    return located(make_unique<VariableDeclarationStatement>(varType, identifier), start);
 }
 
 unique_ptr<Node> Parser::readIfStatement()
 {
+    auto start = current_token.getStart();
     auto ifBlock = readIfBlock();
     if(!ifBlock) return nullptr;
     auto elifBlocks = readElifBlocks();
     auto elseBlock = readElseBlock();
-    return make_unique<IfStatement>(
+    return located(make_unique<IfStatement>(
         move(ifBlock),
         move(elifBlocks),
         move(elseBlock)
-    );
+    ), start);
 }
 
 unique_ptr<Node> Parser::readIfBlock(){
@@ -127,11 +133,12 @@ unique_ptr<Node> Parser::readElseBlock(){
 
 unique_ptr<ConditionBlock> Parser::readConditionBlock()
 {
+    auto start = current_token.getStart();
     auto cond = readCondition();
     if(!cond) return nullptr;
     auto block = readStatementBlock();
     if(!block) throwOnUnexpectedInput("a statement block");
-    return make_unique<ConditionBlock>(move(cond), move(block));
+    return located(make_unique<ConditionBlock>(move(cond), move(block)), start);
 }
 
 unique_ptr<Node> Parser::readCondition()
@@ -144,28 +151,58 @@ unique_ptr<Node> Parser::readCondition()
 
 unique_ptr<Node> Parser::readForeachStatement()
 {
-    if(!consumeIfCheck(Token::Type::ForeachKeyword)) return nullptr;
+    auto start = current_token.getStart();
+    bool parallel = consumeIfCheck(Token::Type::ParallelKeyword);
+    if(parallel) consume(Token::Type::ForeachKeyword);
+    else if(!consumeIfCheck(Token::Type::ForeachKeyword)) return nullptr;
     auto iterator = readDeclr();
     if(!iterator) throwOnUnexpectedInput("a declaration");
     consume(Token::Type::InKeyword);
     auto iterated = readExpression();
     if(!iterated) throwOnUnexpectedInput("a variable or a value");
+    auto reductions = parallel ? readReductions() : vector<ParallelForeachStatement::Reduced>();
     auto scope = readStatementBlock();
     if(!scope) throwOnUnexpectedInput("a statement block");
-    return make_unique<ForeachStatement>(move(iterator),
+    if(parallel)
+        return located(make_unique<ParallelForeachStatement>(move(iterator), move(iterated),
+                                                             move(scope), move(reductions)), start);
+    return located(make_unique<ForeachStatement>(move(iterator),
                                               move(iterated),
-                                              move(scope));
+                                              move(scope)), start);
+}
+
+// sum total, max highest, ... after the iterated value of parallel foreach
+vector<ParallelForeachStatement::Reduced> Parser::readReductions()
+{
+    using Reduction = ParallelForeachStatement::Reduction;
+    static const map<string, Reduction> kinds = {
+        {"sum", Reduction::Sum}, {"min", Reduction::Min},
+        {"max", Reduction::Max}, {"count", Reduction::Count}};
+    auto reductions = vector<ParallelForeachStatement::Reduced>();
+    if(!checkToken(Token::Type::Identifier)) return reductions;
+    do {
+        requireToken(Token::Type::Identifier);
+        auto kind = kinds.find(current_token.getText());
+        if(kind == kinds.end()) throwOnUnexpectedInput("sum, min, max or count");
+        advance();
+        requireToken(Token::Type::Identifier);
+        reductions.push_back({kind->second, current_token.getText()});
+        advance();
+    } while(consumeIfCheck(Token::Type::Comma));
+    return reductions;
 }
 
 unique_ptr<Node> Parser::readReturnStatement()
 {
+    auto start = current_token.getStart();
     if(!consumeIfCheck(Token::Type::ReturnKeyword)) return nullptr;
     auto expr = readExpression();
-    return make_unique<ReturnStatement>(move(expr));
+    return located(make_unique<ReturnStatement>(move(expr)), start);
 }
 
 unique_ptr<Node> Parser::readAddStatement()
 {
+    auto start = current_token.getStart();
     if(!consumeIfCheck(Token::Type::AddKeyword)) return nullptr;
     auto being_added = readExpression();
     if(!being_added) throwOnUnexpectedInput("a value or a variable");
@@ -175,25 +212,41 @@ unique_ptr<Node> Parser::readAddStatement()
     consume(Token::Type::AtKeyword);
     auto added_at = readExpression();
     if(!added_at) throwOnUnexpectedInput("a value or a variable");
-    return make_unique<AddStatement>(move(being_added),
+    return located(make_unique<AddStatement>(move(being_added),
                                           move(added_to),
-                                          move(added_at));
+                                          move(added_at)), start);
 }
 
 unique_ptr<Node> Parser::readRemoveStatement()
 {    
+    auto start = current_token.getStart();
     if(!consumeIfCheck(Token::Type::RemoveKeyword)) return nullptr;
     auto pos = readExpression();
     if(!pos) throwOnUnexpectedInput("a value or a variable");
     consume(Token::Type::FromKeyword);
     auto grid = readVariableReference();
     if(!grid) throwOnUnexpectedInput("a variable");
-    return make_unique<RemoveStatement>(move(pos),
-                                        move(grid));
+    return located(make_unique<RemoveStatement>(move(pos),
+                                        move(grid)), start);
+}
+
+// save grid to "file" or save grid to "file" compressed
+unique_ptr<Node> Parser::readSaveStatement()
+{
+    auto start = current_token.getStart();
+    if(!consumeIfCheck(Token::Type::SaveKeyword)) return nullptr;
+    auto grid = readExpression();
+    if(!grid) throwOnUnexpectedInput("a value or a variable");
+    consume(Token::Type::ToKeyword);
+    auto path = readExpression();
+    if(!path) throwOnUnexpectedInput("a value or a variable");
+    bool compressed = consumeIfCheck(Token::Type::CompressedKeyword);
+    return located(make_unique<SaveStatement>(move(grid), move(path), compressed), start);
 }
 
 unique_ptr<Node> Parser::readMoveStatement()
 {
+    auto start = current_token.getStart();
     if(!consumeIfCheck(Token::Type::MoveKeyword)) return nullptr;
     auto pos1 = readExpression();
     if(!pos1) throwOnUnexpectedInput("a value or a variable");
@@ -206,24 +259,25 @@ unique_ptr<Node> Parser::readMoveStatement()
     if(consumeIfCheck(Token::Type::AtKeyword)){
         auto pos2 = readExpression();
         if(!pos2) throwOnUnexpectedInput("a value or a variable");
-        return make_unique<MoveStatement>(
+        return located(make_unique<MoveStatement>(
             move(pos1), move(source), move(target), move(pos2)
-        );
+        ), start);
     }
-    return make_unique<MoveStatement>(
+    return located(make_unique<MoveStatement>(
         move(pos1), move(source), move(target), nullptr
-    );
+    ), start);
 }
 
 unique_ptr<Node> Parser::readStatementBlock()
 {
+    auto start = current_token.getStart();
     if(!consumeIfCheck(Token::Type::LeftBrace)) return nullptr;
     auto statments = vector<unique_ptr<Node>>();
     unique_ptr<Node> stmnt;
     while((stmnt = readStatement()))
         statments.push_back(move(stmnt));
     consume(Token::Type::RightBrace);
-    return make_unique<StatementBlock>(move(statments));
+    return located(make_unique<StatementBlock>(move(statments)), start);
 }
 
 unique_ptr<FunctionDefinition> Parser::readFuncDef()
@@ -270,32 +324,35 @@ unique_ptr<Node> Parser::readExpression()
 
 unique_ptr<Node> Parser::readOrExpression()
 {
+    auto start = current_token.getStart();
     auto expr = readAndExpression();
     if(!expr) return nullptr;
     while(consumeIfCheck(Token::Type::OrOperator))
     {
         auto rvalue = readAndExpression();
         if(!rvalue) throwOnUnexpectedInput("a value or a variable");
-        expr = make_unique<OrExpression>(move(expr), move(rvalue));
+        expr = located(make_unique<OrExpression>(move(expr), move(rvalue)), start);
     }
     return expr;
 }
 
 unique_ptr<Node> Parser::readAndExpression()
 {
+    auto start = current_token.getStart();
     auto expr = readComparisonExpression();
     if(!expr) return nullptr;
     while(consumeIfCheck(Token::Type::AndOperator))
     {
         auto rvalue = readComparisonExpression();
         if(!rvalue) throwOnUnexpectedInput("a value or a variable");
-        expr = make_unique<AndExpression>(move(expr), move(rvalue));
+        expr = located(make_unique<AndExpression>(move(expr), move(rvalue)), start);
     }
     return expr;
 }
 
 unique_ptr<Node> Parser::readComparisonExpression()
 {
+    auto start = current_token.getStart();
     auto expr = readHexgridExpression();
     if(!expr) return nullptr;
     if(isComparisonOperator()){
@@ -303,7 +360,7 @@ unique_ptr<Node> Parser::readComparisonExpression()
         advance();
         auto rvalue = readHexgridExpression();
         if(!rvalue) throwOnUnexpectedInput("a value or a variable");
-        expr = buildComparison(op, move(expr), move(rvalue));
+        expr = located(buildComparison(op, move(expr), move(rvalue)), start);
     }
     return expr;
 }
@@ -333,23 +390,32 @@ unique_ptr<BinaryExpression> Parser::buildComparison(
 
 unique_ptr<Node> Parser::readHexgridExpression()
 {
+    auto start = current_token.getStart();
     auto expr = readAddSubExpression();
     if(!expr) return nullptr;
     if(consumeIfCheck(Token::Type::OnOperator)){
         auto rvalue = readHexgridExpression();
-        expr = make_unique<OnExpression>(move(expr), move(rvalue));
+        expr = located(make_unique<OnExpression>(move(expr), move(rvalue)), start);
     } else if (consumeIfCheck(Token::Type::ByOperator)){
         auto rvalue = readHexgridExpression();
-        expr = make_unique<ByExpression>(move(expr), move(rvalue));
+        expr = located(make_unique<ByExpression>(move(expr), move(rvalue)), start);
     } else if (consumeIfCheck(Token::Type::BesideOperator)){
         auto rvalue = readHexgridExpression();
-        expr = make_unique<BesideExpression>(move(expr), move(rvalue));
+        expr = located(make_unique<BesideExpression>(move(expr), move(rvalue)), start);
+    } else if (consumeIfCheck(Token::Type::WithinOperator)){
+        auto radius = readAddSubExpression();
+        if(!radius) throwOnUnexpectedInput("a value or a variable");
+        consume(Token::Type::AtKeyword);
+        auto center = readHexgridExpression();
+        if(!center) throwOnUnexpectedInput("a value or a variable");
+        expr = located(make_unique<WithinExpression>(move(expr), move(radius), move(center)), start);
     }
     return expr;
 }
 
 unique_ptr<Node> Parser::readAddSubExpression()
 {
+    auto start = current_token.getStart();
     auto expr = readMulModDivExpression();
     if(!expr) return nullptr;
     while(checkToken(Token::Type::AddOperator) ||
@@ -365,11 +431,13 @@ unique_ptr<Node> Parser::readAddSubExpression()
         else expr = make_unique<SubtructExpression>( 
                                                     move(expr),
                                                     move(rvalue));
+        expr = located(move(expr), start);
     }
     return expr;
 }
 unique_ptr<Node> Parser::readMulModDivExpression()
 {
+    auto start = current_token.getStart();
     auto expr = readArithmNegExpression();
     if(!expr) return nullptr;
     while(checkToken(Token::Type::MultiplyOperator) 
@@ -389,30 +457,34 @@ unique_ptr<Node> Parser::readMulModDivExpression()
         else
             expr = make_unique<DivideExpression>(
                 move(expr), move(rvalue));
+        expr = located(move(expr), start);
     }
     return expr;
 }
 
 unique_ptr<Node> Parser::readArithmNegExpression()
 {
+    auto start = current_token.getStart();
     if (!consumeIfCheck(Token::Type::SubstructOperator))
         return readLogicNegExpression();
     auto expr = readLogicNegExpression();
     if(!expr) throwOnUnexpectedInput("a variable or a value");
-    return make_unique<ArithmeticalNegation>(move(expr));
+    return located(make_unique<ArithmeticalNegation>(move(expr)), start);
 }
 
 unique_ptr<Node> Parser::readLogicNegExpression()
 {
+    auto start = current_token.getStart();
     if (!consumeIfCheck(Token::Type::LogicalNegationOperator))
         return readIndexingExpression();
     auto expr = readIndexingExpression();
     if(!expr) throwOnUnexpectedInput("a variable or a value");
-    return make_unique<LogicalNegation>(move(expr));
+    return located(make_unique<LogicalNegation>(move(expr)), start);
 }
 
 unique_ptr<Node> Parser::readIndexingExpression()
 {
+    auto start = current_token.getStart();
     auto expr = readTerm();
     if(!expr) return nullptr;
     while (consumeIfCheck(Token::Type::LeftBracket))
@@ -420,8 +492,8 @@ unique_ptr<Node> Parser::readIndexingExpression()
         auto indexOn = move(expr);
         auto indexBy = readExpression();
         if(!indexBy) throwOnUnexpectedInput("an index");
-        expr = make_unique<IndexingExpression>(move(indexOn), move(indexBy));
         consume(Token::Type::RightBracket);
+        expr = located(make_unique<IndexingExpression>(move(indexOn), move(indexBy)), start);
     }
     return expr;
 }
@@ -435,9 +507,42 @@ unique_ptr<Node> Parser::readTerm()
     if (!term) term = readArray();
     if (!term) term = readHexgrid();
     if (!term) term = readSubExpression();
+    if (!term) term = readRouteExpression();
+    if (!term) term = readLoadExpression();
     return term;
 }
 
+// path or visible from source to target in grid
+unique_ptr<Node> Parser::readRouteExpression()
+{
+    auto start = current_token.getStart();
+    bool visible = checkToken(Token::Type::VisibleKeyword);
+    if(!consumeIfCheck(Token::Type::PathKeyword) &&
+       !consumeIfCheck(Token::Type::VisibleKeyword)) return nullptr;
+    consume(Token::Type::FromKeyword);
+    auto source = readHexgridExpression();
+    if(!source) throwOnUnexpectedInput("a value or a variable");
+    consume(Token::Type::ToKeyword);
+    auto target = readHexgridExpression();
+    if(!target) throwOnUnexpectedInput("a value or a variable");
+    consume(Token::Type::InKeyword);
+    auto grid = readHexgridExpression();
+    if(!grid) throwOnUnexpectedInput("a value or a variable");
+    if(visible)
+        return located(make_unique<VisibleExpression>(move(source), move(target), move(grid)), start);
+    return located(make_unique<PathExpression>(move(source), move(target), move(grid)), start);
+}
+
+// load "file"
+unique_ptr<Node> Parser::readLoadExpression()
+{
+    auto start = current_token.getStart();
+    if(!consumeIfCheck(Token::Type::LoadKeyword)) return nullptr;
+    auto path = readTerm();
+    if(!path) throwOnUnexpectedInput("a value or a variable");
+    return located(make_unique<LoadExpression>(move(path)), start);
+}
+
 unique_ptr<Node> Parser::readSubExpression()
 {
     if(!consumeIfCheck(Token::Type::LeftParenthese)) return nullptr;
@@ -452,42 +557,47 @@ unique_ptr<Node> Parser::readTextLiteral()
 {
     
     if(!checkToken(Token::Type::Text)) return nullptr;
+    auto start = current_token.getStart();
     auto literal = make_unique<TextLiteral>(current_token.getText());
     advance(); 
-    return literal;
+    return located(move(literal), start);
 }
 
 unique_ptr<Node> Parser::readDecimalLiteral()
 {
     if(!checkToken(Token::Type::Decimal)) return nullptr;
+    auto start = current_token.getStart();
     auto literal = make_unique<DecimalLiteral>(current_token.getDecimal());
     advance(); 
-    return literal;
+    return located(move(literal), start);
 }
 
 unique_ptr<Node> Parser::readIntegerLiteral()
 {
     if(!checkToken(Token::Type::Integer)) return nullptr;
+    auto start = current_token.getStart();
     auto literal = make_unique<IntegerLiteral>(current_token.getInteger());
     advance(); 
-    return literal;
+    return located(move(literal), start);
 }
 
 unique_ptr<VariableReference> Parser::readVariableReference(){
     if(!checkToken(Token::Type::Identifier)) return nullptr;
+    auto start = current_token.getStart();
     const auto id = current_token.getText();
     advance();
-    return make_unique<VariableReference>(id);
+    return located(make_unique<VariableReference>(id), start);
 }
 
 unique_ptr<Node> Parser::readVariableOrFuncCall()
 {
     if(!checkToken(Token::Type::Identifier)) return nullptr;
+    auto start = current_token.getStart();
     const auto id = current_token.getText();
     advance();
     auto funcCall = readFunctionCall(id);
-    if (funcCall) return funcCall;
-    return make_unique<VariableReference>(id);
+    if (funcCall) return located(move(funcCall), start);
+    return located(make_unique<VariableReference>(id), start);
 }
 
 unique_ptr<Node> Parser::readFunctionCall(string func_name)
@@ -525,29 +635,32 @@ vector<unique_ptr<Node>> Parser::readHexgridCellList(){
 }
 
 unique_ptr<Node> Parser::readHexgridCell(){
+    auto start = current_token.getStart();
     auto value = readExpression();
     if(!value) return nullptr;
     consume(Token::Type::AtKeyword);
     auto pos = readTerm();
     if(!pos)  throwOnUnexpectedInput("a value or a variable");
-    return make_unique<HexgridCell>(move(value), move(pos));
+    return located(make_unique<HexgridCell>(move(value), move(pos)), start);
 }
 
 
 unique_ptr<Node> Parser::readArray()
 {
+    auto start = current_token.getStart();
     if(!consumeIfCheck(Token::Type::LeftBracket)) return nullptr;
     auto elements = readElementList();
     consume(Token::Type::RightBracket);
-    return make_unique<ArrayLiteral>(move(elements));
+    return located(make_unique<ArrayLiteral>(move(elements)), start);
 }
 
 unique_ptr<Node> Parser::readHexgrid()
 {
+    auto start = current_token.getStart();
     if(!consumeIfCheck(Token::Type::LessOperator)) return nullptr;
     auto cells = readHexgridCellList();
     consume(Token::Type::GreaterOperator);
-    return make_unique<HexgridLiteral>(move(cells));
+    return located(make_unique<HexgridLiteral>(move(cells)), start);
 }
 
 
@@ -628,7 +741,8 @@ void Parser::advance()
 {
     prevTokenStart = current_token.getStart();
     prevTokenEnd = current_token.getEnd();
-    current_token = lexer->getToken();
+    if (lexer) current_token = lexer->getToken();
+    else if (nextToken < tokens.size()) current_token = tokens[nextToken++];
 }
 
 void Parser::consume(Token::Type t)
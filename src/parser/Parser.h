@@ -19,6 +19,8 @@ class Parser
 {
 public:
     Parser(std::unique_ptr<lexer::Lexer> lexer_);
+    // Parses tokens lexed beforehand, they must end with EndOfFile.
+    Parser(std::vector<token::Token> tokens_);
     ~Parser();
 
     std::unique_ptr<ast::Program> parse();
@@ -39,10 +41,12 @@ protected:
     std::unique_ptr<ast::Node> readElseBlock();
     std::unique_ptr<ast::ConditionBlock> readConditionBlock();
     std::unique_ptr<ast::Node> readForeachStatement();
+    std::vector<ast::ParallelForeachStatement::Reduced> readReductions();
     std::unique_ptr<ast::Node> readReturnStatement();
     std::unique_ptr<ast::Node> readAddStatement();
     std::unique_ptr<ast::Node> readRemoveStatement();
     std::unique_ptr<ast::Node> readMoveStatement();
+    std::unique_ptr<ast::Node> readSaveStatement();
 
     std::unique_ptr<ast::Node> readCondition();
     std::unique_ptr<ast::Node> readStatementBlock();
@@ -71,6 +75,8 @@ protected:
     std::unique_ptr<ast::Node> readArray();
     std::unique_ptr<ast::Node> readHexgrid();
     std::unique_ptr<ast::Node> readSubExpression();
+    std::unique_ptr<ast::Node> readRouteExpression();
+    std::unique_ptr<ast::Node> readLoadExpression();
     std::string readIdentifier();
     std::vector<std::unique_ptr<ast::Node>> readElementList();
     std::vector<std::unique_ptr<ast::Node>> readHexgridCellList();
@@ -86,6 +92,13 @@ protected:
 
 
 
+    template<class T>
+    std::unique_ptr<T> located(std::unique_ptr<T> node, std::pair<int, int> start)
+    {
+        node->setLocation(start, prevTokenEnd);
+        return node;
+    }
+
     void advance();
     bool checkToken(token::Token::Type expected) const;
     void consume(token::Token::Type);
@@ -93,6 +106,8 @@ protected:
     
 
     std::unique_ptr<lexer::Lexer> lexer;
+    std::vector<token::Token> tokens;
+    size_t nextToken = 0;
     token::Token current_token;
     std::pair<int, int> prevTokenStart;
     std::pair<int, int> prevTokenEnd;
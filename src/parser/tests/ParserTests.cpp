@@ -577,6 +577,94 @@ BOOST_AUTO_TEST_CASE(reads_script_with_foreach_statement)
                       "|||||Variable reference (i)\n");
 }
 
+BOOST_AUTO_TEST_CASE(reads_script_with_parallel_foreach_statement)
+{
+    parse("parallel foreach int i in values sum total, max highest { total = total + i; }");
+    BOOST_CHECK_EQUAL(result->toString(),
+                      "Program\n"
+                      "|Parallel Foreach Statement (sum total, max highest)\n"
+                      "||Variable Declaration (int i)\n"
+                      "||Variable reference (values)\n"
+                      "||StatementBlock\n"
+                      "|||Assignment (total)\n"
+                      "||||Add Expression\n"
+                      "|||||Variable reference (total)\n"
+                      "|||||Variable reference (i)\n");
+    BOOST_CHECK_THROW(parse("parallel foreach int i in values avg total { }"), std::exception);
+    BOOST_CHECK_THROW(parse("parallel int i = 0;"), std::exception);
+}
+
+BOOST_AUTO_TEST_CASE(reads_script_with_save_and_load)
+{
+    parse("save grid to \"world.hex\"; hexgrid copy = load name;");
+    BOOST_CHECK_EQUAL(result->toString(),
+                      "Program\n"
+                      "|Save Statement\n"
+                      "||Variable reference (grid)\n"
+                      "||Text Literal (world.hex)\n"
+                      "|Initialization (hexgrid copy)\n"
+                      "||Load Expression\n"
+                      "|||Variable reference (name)\n");
+    BOOST_CHECK_THROW(parse("save grid \"world.hex\";"), std::exception);
+    BOOST_CHECK_THROW(parse("hexgrid copy = load;"), std::exception);
+}
+
+BOOST_AUTO_TEST_CASE(reads_script_with_compressed_save)
+{
+    parse("save grid to \"world.hexz\" compressed;");
+    BOOST_CHECK_EQUAL(result->toString(),
+                      "Program\n"
+                      "|Save Statement (compressed)\n"
+                      "||Variable reference (grid)\n"
+                      "||Text Literal (world.hexz)\n");
+    BOOST_CHECK_THROW(parse("save grid compressed;"), std::exception);
+}
+
+BOOST_AUTO_TEST_CASE(reads_script_with_within_expression)
+{
+    parse("foreach array pos in grid within n + 1 at [0, 0, 0] { }");
+    BOOST_CHECK_EQUAL(result->toString(),
+                      "Program\n"
+                      "|Foreach Statement\n"
+                      "||Variable Declaration (array pos)\n"
+                      "||Hexgrid Within Expression\n"
+                      "|||Variable reference (grid)\n"
+                      "|||Add Expression\n"
+                      "||||Variable reference (n)\n"
+                      "||||Integer Literal (1)\n"
+                      "|||Array of length (3)\n"
+                      "||||Integer Literal (0)\n"
+                      "||||Integer Literal (0)\n"
+                      "||||Integer Literal (0)\n"
+                      "||StatementBlock\n");
+}
+
+BOOST_AUTO_TEST_CASE(reads_script_with_path_expression)
+{
+    parse("array p = path from a to b in grid;");
+    BOOST_CHECK_EQUAL(result->toString(),
+                      "Program\n"
+                      "|Initialization (array p)\n"
+                      "||Hexgrid Path Expression\n"
+                      "|||Variable reference (a)\n"
+                      "|||Variable reference (b)\n"
+                      "|||Variable reference (grid)\n");
+}
+
+BOOST_AUTO_TEST_CASE(reads_script_with_visible_expression)
+{
+    parse("if (visible from a to b in grid) { }");
+    BOOST_CHECK_EQUAL(result->toString(),
+                      "Program\n"
+                      "|If Statement\n"
+                      "||Condition Block\n"
+                      "|||Hexgrid Visible Expression\n"
+                      "||||Variable reference (a)\n"
+                      "||||Variable reference (b)\n"
+                      "||||Variable reference (grid)\n"
+                      "|||StatementBlock\n");
+}
+
 BOOST_AUTO_TEST_CASE(reads_script_with_return_statement)
 {
     parse("return i * 3;");
@@ -849,4 +937,37 @@ BOOST_AUTO_TEST_CASE(throws_on_function_redefinition)
 
 
 
+BOOST_AUTO_TEST_CASE(records_source_location_of_expressions)
+{
+    parseExpression("1 +\n  foo * 2");
+    BOOST_CHECK(result->getStart() == std::make_pair(1, 1));
+    BOOST_CHECK(result->getEnd() == std::make_pair(2, 10));
+    auto add = dynamic_cast<AddExpression*>(result.get());
+    BOOST_REQUIRE(add);
+    BOOST_CHECK(add->rvalue->getStart() == std::make_pair(2, 3));
+    BOOST_CHECK(add->rvalue->getEnd() == std::make_pair(2, 10));
+}
+
+BOOST_AUTO_TEST_CASE(records_source_location_of_statements)
+{
+    parse("int x = 1;\nforeach int y in [1] { x = y; }");
+    auto program = dynamic_cast<Program*>(result.get());
+    BOOST_REQUIRE(program);
+    BOOST_CHECK(program->stmnts[0]->getStart() == std::make_pair(1, 1));
+    BOOST_CHECK(program->stmnts[0]->getEnd() == std::make_pair(1, 10));
+    BOOST_CHECK(program->stmnts[1]->getStart() == std::make_pair(2, 1));
+    BOOST_CHECK(program->stmnts[1]->getEnd() == std::make_pair(2, 32));
+}
+
+
+BOOST_AUTO_TEST_CASE(parses_tokens_lexed_beforehand)
+{
+    std::istringstream in("int x = 1;");
+    Parser p(Lexer(in).readAll());
+    auto program = p.parse();
+    BOOST_REQUIRE_EQUAL(program->stmnts.size(), 1);
+    BOOST_CHECK_EQUAL(program->stmnts[0]->toString(),
+                      "Initialization (int x)\n|Integer Literal (1)\n");
+}
+
 BOOST_AUTO_TEST_SUITE_END()